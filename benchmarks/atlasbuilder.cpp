@@ -0,0 +1,68 @@
+// Composites 50,000 randomly sized PPM sprites from 8x8 to 64x64 into an atlas 8192 pixels wide.
+// The sprites are written to a temporary directory and placed in rows, with sprites taller than they are wide
+// rotated to lie flat, so that the time measured is that of copying rather than of packing. Reports the time
+// taken to composite the atlas on 1, 2, 4 and 8 threads, which only scales with threads when the machine has
+// that many cores.
+//   g++ -std=c++17 -O2 -Isrc benchmarks/atlasbuilder.cpp src/atlasbuilder.cpp src/mappedfile.cpp src/binpacker.cpp -o atlasbuilderbenchmark -pthread
+//   ./atlasbuilderbenchmark [minSpriteSize] [maxSpriteSize] [spriteCount]
+
+#include "atlasbuilder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+
+using namespace BinPacker;
+
+int main(int argc, char** argv) {
+	const unsigned int minSpriteSize = argc > 1 ? (unsigned int)std::atoi(argv[1]) : 8;
+	const unsigned int maxSpriteSize = argc > 2 ? (unsigned int)std::atoi(argv[2]) : 64;
+	const unsigned int spriteCount = argc > 3 ? (unsigned int)std::atoi(argv[3]) : 50000;
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "atlasbuilderbenchmark";
+	std::filesystem::create_directories(directory);
+
+	std::vector<Sprite> sprites(spriteCount);
+	std::vector<unsigned char> pixels;
+	unsigned int state = 1;
+	unsigned int rowLeft = 0, rowTop = 0, rowHeight = 0;
+	for (unsigned int i = 0; i < spriteCount; i++) {
+		state = state * 1103515245u + 12345u;
+		const unsigned int width = minSpriteSize + (state >> 16) % (maxSpriteSize - minSpriteSize + 1);
+		state = state * 1103515245u + 12345u;
+		const unsigned int height = minSpriteSize + (state >> 16) % (maxSpriteSize - minSpriteSize + 1);
+		pixels.assign((std::size_t)width * height * 3, (unsigned char)i);
+		sprites[i].path = (directory / (std::to_string(i) + ".ppm")).string();
+		std::FILE* file = std::fopen(sprites[i].path.c_str(), "wb");
+		if (file == nullptr) {
+			std::printf("Couldn't write %s\n", sprites[i].path.c_str());
+			return 1;
+		}
+		std::fprintf(file, "P6\n%u %u\n255\n", width, height);
+		std::fwrite(pixels.data(), 1, pixels.size(), file);
+		std::fclose(file);
+
+		// Rows are as tall as their tallest sprite, and a sprite that doesn't fit the current row starts a new one
+		const Area placed = {std::max(width, height), std::min(width, height)};
+		if (rowLeft + placed.width > 8192) {
+			rowTop += rowHeight;
+			rowLeft = rowHeight = 0;
+		}
+		sprites[i].placement = {rowLeft, rowTop, rowLeft + placed.width - 1, rowTop + placed.height - 1};
+		rowLeft += placed.width;
+		rowHeight = std::max(rowHeight, placed.height);
+	}
+	const unsigned int atlasHeight = rowTop + rowHeight;
+	std::printf("%u sprites from %ux%u to %ux%u into an 8192x%u atlas\n", spriteCount, minSpriteSize, minSpriteSize,
+		maxSpriteSize, maxSpriteSize, atlasHeight);
+
+	for (unsigned int threadCount : {1u, 2u, 4u, 8u}) {
+		AtlasBuilder builder({8192, atlasHeight}, 3);
+		const auto start = std::chrono::steady_clock::now();
+		const std::size_t failed = builder.Composite(sprites, threadCount).size();
+		const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::printf("%u threads %10.1f ms %8zu failed\n", threadCount, milliseconds, failed);
+	}
+	std::filesystem::remove_all(directory);
+	return 0;
+}
@@ -0,0 +1,66 @@
+// Compares the insert throughput of a ConcurrentBin with a Bin behind a single mutex for 1 to 8 threads.
+// The threads pack the same randomly sized items between them, and the fill of each bin is reported too.
+//   g++ -std=c++17 -O2 -Isrc benchmarks/concurrentbin.cpp src/concurrentbin.cpp src/binpacker.cpp -o concurrentbinbenchmark -pthread
+
+#include "concurrentbin.h"
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+using namespace BinPacker;
+
+static const Area binDimensions = {1024, 1024};
+static const unsigned int itemCount = 12000;
+
+static std::vector<Area> MakeItems() {
+	std::vector<Area> items;
+	unsigned int state = 1;
+	for (unsigned int i = 0; i < itemCount; i++) {
+		state = state * 1103515245u + 12345u;
+		items.push_back({1 + (state >> 16) % 8, 1 + (state >> 8) % 8});
+	}
+	return items;
+}
+
+// Runs pack on threadCount threads, each packing every threadCount-th item, and returns the seconds taken
+template<typename Pack>
+static double Run(const std::vector<Area>& items, unsigned int threadCount, Pack pack) {
+	const auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for (unsigned int t = 0; t < threadCount; t++) {
+		threads.emplace_back([&, t]() {
+			for (std::size_t i = t; i < items.size(); i += threadCount)
+				pack(items[i]);
+		});
+	}
+	for (std::thread & thread : threads)
+		thread.join();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+	const std::vector<Area> items = MakeItems();
+	const double binArea = (double)binDimensions.width * binDimensions.height;
+	std::printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+	std::printf("threads  mutex Bin items/s  fill  ConcurrentBin items/s  fill\n");
+	for (unsigned int threadCount : {1u, 2u, 4u, 8u}) {
+		Bin bin;
+		bin.ExtendDimensions(binDimensions);
+		std::mutex binMutex;
+		unsigned long long binUsed = 0;
+		const double binSeconds = Run(items, threadCount, [&](Area area) {
+			std::lock_guard<std::mutex> lock(binMutex);
+			if (bin.TryPackArea(area).IsValid())
+				binUsed += (unsigned long long)area.width * area.height;
+		});
+
+		ConcurrentBin concurrentBin(binDimensions, threadCount);
+		const double concurrentSeconds = Run(items, threadCount, [&](Area area) { concurrentBin.TryPackArea(area); });
+
+		std::printf("%7u  %19.0f  %4.1f%%  %21.0f  %4.1f%%\n", threadCount,
+			items.size() / binSeconds, 100 * binUsed / binArea,
+			items.size() / concurrentSeconds, 100 * concurrentBin.GetUsedArea() / binArea);
+	}
+	return 0;
+}
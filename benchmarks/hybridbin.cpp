@@ -0,0 +1,60 @@
+// Compares packing 10,000 randomly sized items into a Bin and into HybridBins with different small size limits.
+// As in the README's measurements, the bin starts at 128x128 and doubles whenever an item doesn't fit.
+// Reports the time taken and the largest number of empty regions the bin had.
+//   g++ -std=c++17 -O2 -Isrc benchmarks/hybridbin.cpp src/hybridbin.cpp src/cellpool.cpp src/binpacker.cpp -o hybridbinbenchmark
+//   ./hybridbinbenchmark [maxItemSize] [itemCount]
+
+#include "hybridbin.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace BinPacker;
+
+// Packs area, doubling the bin until it fits, and returns the number of empty regions afterwards
+template<typename Packer>
+static std::size_t PackGrowing(Packer& packer, Area area) {
+	while (!packer.TryPackArea(area).IsValid()) {
+		const Area dimensions = packer.GetDimensions();
+		packer.ExtendDimensions(dimensions);
+	}
+	return packer.GetEmptyRegions().size();
+}
+
+template<typename Packer>
+static void Run(const char* name, Packer& packer, const std::vector<Area>& items) {
+	std::size_t maxRegions = 0;
+	const auto start = std::chrono::steady_clock::now();
+	for (const Area & item : items)
+		maxRegions = std::max(maxRegions, PackGrowing(packer, item));
+	const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::printf("%-16s %10.1f ms %8zu regions\n", name, milliseconds, maxRegions);
+}
+
+int main(int argc, char** argv) {
+	const unsigned int maxItemSize = argc > 1 ? (unsigned int)std::atoi(argv[1]) : 64;
+	const unsigned int itemCount = argc > 2 ? (unsigned int)std::atoi(argv[2]) : 10000;
+	std::vector<Area> items;
+	unsigned int state = 1;
+	for (unsigned int i = 0; i < itemCount; i++) {
+		state = state * 1103515245u + 12345u;
+		const unsigned int width = 1 + (state >> 16) % maxItemSize;
+		state = state * 1103515245u + 12345u;
+		items.push_back({width, 1 + (state >> 16) % maxItemSize});
+	}
+	std::printf("%u items from 1x1 to %ux%u\n", itemCount, maxItemSize, maxItemSize);
+
+	Bin bin;
+	bin.ExtendDimensions({128, 128});
+	Run("Bin", bin, items);
+	for (unsigned int maxSmallSize : {4u, 8u, 16u, 32u}) {
+		Bin hybridBin;
+		hybridBin.ExtendDimensions({128, 128});
+		HybridBin hybrid(std::move(hybridBin), PackConstraints(), maxSmallSize);
+		char name[32];
+		std::snprintf(name, sizeof(name), "HybridBin <= %u", maxSmallSize);
+		Run(name, hybrid, items);
+	}
+	return 0;
+}
@@ -0,0 +1,43 @@
+// Packs a million randomly sized items into a SparseBin of 1,000,000x1,000,000 pixels.
+// Reports the time taken, the number of tiles materialized out of the bin's total, and the fraction of
+// the materialized tiles covered by items. Pack time depends on the tile size rather than on the bin size,
+// which can be checked by passing different bin sizes.
+//   g++ -std=c++17 -O2 -Isrc benchmarks/sparsebin.cpp src/sparsebin.cpp src/binpacker.cpp -o sparsebinbenchmark
+//   ./sparsebinbenchmark [maxItemSize] [binSize] [itemCount] [tileSize]
+
+#include "sparsebin.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace BinPacker;
+
+int main(int argc, char** argv) {
+	const unsigned int maxItemSize = argc > 1 ? (unsigned int)std::atoi(argv[1]) : 64;
+	const unsigned int binSize = argc > 2 ? (unsigned int)std::atoi(argv[2]) : 1000000;
+	const unsigned int itemCount = argc > 3 ? (unsigned int)std::atoi(argv[3]) : 1000000;
+	const unsigned int tileSize = argc > 4 ? (unsigned int)std::atoi(argv[4]) : 256;
+	std::vector<Area> items;
+	unsigned int state = 1;
+	for (unsigned int i = 0; i < itemCount; i++) {
+		state = state * 1103515245u + 12345u;
+		const unsigned int width = 1 + (state >> 16) % maxItemSize;
+		state = state * 1103515245u + 12345u;
+		items.push_back({width, 1 + (state >> 16) % maxItemSize});
+	}
+	std::printf("%u items from 1x1 to %ux%u into %ux%u with %ux%u tiles\n", itemCount, maxItemSize, maxItemSize, binSize, binSize, tileSize, tileSize);
+
+	SparseBin bin({binSize, binSize}, tileSize);
+	unsigned int packed = 0;
+	const auto start = std::chrono::steady_clock::now();
+	for (const Area & item : items) {
+		if (bin.TryPackArea(item).IsValid())
+			packed++;
+	}
+	const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	const unsigned long long tilesPerSide = (binSize + tileSize - 1) / tileSize;
+	const std::size_t tileCount = bin.GetMaterializedTileCount();
+	std::printf("%10.1f ms %8u packed %8zu of %llu tiles materialized %6.1f%% filled\n", milliseconds, packed, tileCount,
+		tilesPerSide * tilesPerSide, 100.0 * bin.GetUsedArea() / ((double)tileCount * tileSize * tileSize));
+	return 0;
+}
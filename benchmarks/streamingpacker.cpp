@@ -0,0 +1,73 @@
+// Packs ten million randomly sized items from a file into 256x256 pages with PackFile and a 32MB memory budget.
+// The item file is written first, a block at a time, so that the items are never all held in memory.
+// Reports the time taken, the throughput in items per second, the number of pages and, where the
+// platform reports it, the peak resident memory of the process.
+//   g++ -std=c++17 -O2 -Isrc benchmarks/streamingpacker.cpp src/streamingpacker.cpp src/mappedfile.cpp src/binpacker.cpp -o streamingpackerbenchmark
+//   ./streamingpackerbenchmark [maxItemSize] [itemCount] [pageSize] [memoryBudgetMB]
+
+#include "streamingpacker.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+using namespace BinPacker;
+
+int main(int argc, char** argv) {
+	const unsigned int maxItemSize = argc > 1 ? (unsigned int)std::atoi(argv[1]) : 64;
+	const unsigned long long itemCount = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10000000;
+	const unsigned int pageSize = argc > 3 ? (unsigned int)std::atoi(argv[3]) : 256;
+	const std::size_t memoryBudget = (argc > 4 ? (std::size_t)std::atoi(argv[4]) : 32) << 20;
+	const std::filesystem::path directory = std::filesystem::temp_directory_path();
+	const std::string itemPath = (directory / "streamingpackerbenchmark.items").string();
+	const std::string placementPath = (directory / "streamingpackerbenchmark.placements").string();
+
+	FILE* items = std::fopen(itemPath.c_str(), "wb");
+	if (items == nullptr) {
+		std::printf("Couldn't write %s\n", itemPath.c_str());
+		return 1;
+	}
+	// Little-endian width and height pairs, written a block at a time
+	std::vector<unsigned char> block;
+	unsigned int state = 1;
+	for (unsigned long long i = 0; i < itemCount; i++) {
+		for (int j = 0; j < 2; j++) {
+			state = state * 1103515245u + 12345u;
+			const std::uint32_t size = 1 + (state >> 16) % maxItemSize;
+			for (int k = 0; k < 4; k++)
+				block.push_back((unsigned char)(size >> (k * 8)));
+		}
+		if (block.size() >= (1 << 20) || i + 1 == itemCount) {
+			std::fwrite(block.data(), 1, block.size(), items);
+			block.clear();
+		}
+	}
+	std::fclose(items);
+	std::printf("%llu items from 1x1 to %ux%u into %ux%u pages\n", itemCount, maxItemSize, maxItemSize, pageSize, pageSize);
+
+	StreamingSettings settings;
+	settings.pageDimensions = {pageSize, pageSize};
+	settings.memoryBudget = memoryBudget;
+	StreamingStats stats;
+	const auto start = std::chrono::steady_clock::now();
+	const bool packed = PackFile(itemPath, placementPath, settings, &stats);
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::filesystem::remove(itemPath);
+	std::filesystem::remove(placementPath);
+	if (!packed) {
+		std::printf("PackFile failed\n");
+		return 1;
+	}
+	std::printf("%10.1f s %12.0f items/s %8llu packed %8u pages %4u peak open pages\n", seconds, stats.itemCount / seconds,
+		stats.packedCount, stats.pageCount, stats.peakOpenPages);
+#ifndef _WIN32
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+		std::printf("%10.1f MB peak resident memory\n", usage.ru_maxrss / 1024.0);
+#endif
+	return 0;
+}
@@ -0,0 +1,59 @@
+// Compares packing randomly sized items into a fixed size Bin and into a TiledBin with 128x128 tiles.
+// Without arguments it runs the README's two cases: 10,000 items from 1x1 to 16x16 into a 1024x1024 bin,
+// and 10,000 items from 1x1 to 64x64 into a 2048x2048 bin, which they more than fill.
+// Reports the time taken, the number of items packed and the fraction of the bin they cover.
+//   g++ -std=c++17 -O2 -Isrc benchmarks/tiledbin.cpp src/tiledbin.cpp src/binpacker.cpp -o tiledbinbenchmark
+//   ./tiledbinbenchmark [maxItemSize] [binSize] [itemCount]
+
+#include "tiledbin.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace BinPacker;
+
+template<typename Packer>
+static void Run(const char* name, Packer& packer, const std::vector<Area>& items) {
+	unsigned int packed = 0;
+	unsigned long long packedArea = 0;
+	const auto start = std::chrono::steady_clock::now();
+	for (const Area & item : items) {
+		if (packer.TryPackArea(item).IsValid()) {
+			packed++;
+			packedArea += (unsigned long long)item.width * item.height;
+		}
+	}
+	const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	const Area dimensions = packer.GetDimensions();
+	std::printf("%-10s %10.1f ms %8u packed %6.1f%% filled\n", name, milliseconds, packed,
+		100.0 * packedArea / ((double)dimensions.width * dimensions.height));
+}
+
+static void Compare(unsigned int maxItemSize, unsigned int binSize, unsigned int itemCount) {
+	std::vector<Area> items;
+	unsigned int state = 1;
+	for (unsigned int i = 0; i < itemCount; i++) {
+		state = state * 1103515245u + 12345u;
+		const unsigned int width = 1 + (state >> 16) % maxItemSize;
+		state = state * 1103515245u + 12345u;
+		items.push_back({width, 1 + (state >> 16) % maxItemSize});
+	}
+	std::printf("%u items from 1x1 to %ux%u into %ux%u\n", itemCount, maxItemSize, maxItemSize, binSize, binSize);
+
+	Bin bin;
+	bin.ExtendDimensions({binSize, binSize});
+	Run("Bin", bin, items);
+	TiledBin tiled({binSize, binSize}, 128);
+	Run("TiledBin", tiled, items);
+}
+
+int main(int argc, char** argv) {
+	const unsigned int itemCount = argc > 3 ? (unsigned int)std::atoi(argv[3]) : 10000;
+	if (argc > 2) {
+		Compare((unsigned int)std::atoi(argv[1]), (unsigned int)std::atoi(argv[2]), itemCount);
+	} else {
+		Compare(16, 1024, itemCount);
+		Compare(64, 2048, itemCount);
+	}
+	return 0;
+}
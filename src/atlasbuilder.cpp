@@ -0,0 +1,317 @@
+#include "atlasbuilder.h"
+#include "mappedfile.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+using namespace BinPacker;
+
+// Headers longer than this aren't supported
+static const std::size_t maxHeaderSize = 4096;
+
+// Reads the whitespace-separated tokens of a PNM header, skipping comments
+struct HeaderReader {
+	const unsigned char* data;
+	const unsigned char* end;
+
+	std::string ReadToken() {
+		while (data < end && (std::isspace(*data) || *data == '#')) {
+			if (*data == '#') {
+				while (data < end && *data != '\n')
+					data++;
+			} else {
+				data++;
+			}
+		}
+		std::string token;
+		while (data < end && !std::isspace(*data))
+			token += (char)*data++;
+		return token;
+	}
+
+	bool ReadNumber(unsigned int& value) {
+		const std::string token = ReadToken();
+		if (token.empty() || token.size() > 9 || token.find_first_not_of("0123456789") != std::string::npos)
+			return false;
+		value = (unsigned int)std::stoul(token);
+		return true;
+	}
+};
+
+// Parses the header of a binary PGM, PPM or PAM image with 8-bit samples and returns the size of the header
+static bool ParseHeader(const unsigned char* data, std::size_t size, Area& dimensions, unsigned int& channels, std::size_t& headerSize) {
+	HeaderReader reader = { data, data + size };
+	const std::string magic = reader.ReadToken();
+	unsigned int maxValue = 0;
+	if (magic == "P5" || magic == "P6") {
+		channels = magic == "P5" ? 1 : 3;
+		if (!reader.ReadNumber(dimensions.width) || !reader.ReadNumber(dimensions.height) || !reader.ReadNumber(maxValue))
+			return false;
+	} else if (magic == "P7") {
+		dimensions = {0, 0};
+		channels = 0;
+		for (std::string key = reader.ReadToken(); key != "ENDHDR"; key = reader.ReadToken()) {
+			if (key.empty())
+				return false;
+			else if (key == "WIDTH" && !reader.ReadNumber(dimensions.width))
+				return false;
+			else if (key == "HEIGHT" && !reader.ReadNumber(dimensions.height))
+				return false;
+			else if (key == "DEPTH" && !reader.ReadNumber(channels))
+				return false;
+			else if (key == "MAXVAL" && !reader.ReadNumber(maxValue))
+				return false;
+			else if (key == "TUPLTYPE")
+				reader.ReadToken();
+		}
+	} else {
+		return false;
+	}
+
+	// A single whitespace character separates the header from the samples
+	if (reader.data == reader.end || !std::isspace(*reader.data))
+		return false;
+	headerSize = (std::size_t)(reader.data + 1 - data);
+	return dimensions.width > 0 && dimensions.height > 0 && channels > 0 && channels <= 4 && maxValue > 0 && maxValue <= 255;
+}
+
+bool BinPacker::ReadImageInfo(const std::string& path, Area& dimensions, unsigned int& channels) {
+	MappedFile file;
+	if (!file.Open(path))
+		return false;
+	const std::size_t size = (std::size_t)std::min<unsigned long long>(file.GetSize(), maxHeaderSize);
+	const unsigned char* data = file.Map(0, size);
+	std::size_t headerSize;
+	return data != nullptr && ParseHeader(data, size, dimensions, channels, headerSize);
+}
+
+// Maps the samples of an image, reading its dimensions and samples per pixel from its header unless they're given for a raw image
+static const unsigned char* MapSamples(MappedFile& file, const std::string& path, Area& dimensions, unsigned int& channels) {
+	if (!file.Open(path))
+		return nullptr;
+	std::size_t headerSize = 0;
+	if (dimensions.width == 0 || dimensions.height == 0) {
+		const std::size_t length = (std::size_t)std::min<unsigned long long>(file.GetSize(), maxHeaderSize);
+		const unsigned char* header = file.Map(0, length);
+		if (header == nullptr || !ParseHeader(header, length, dimensions, channels, headerSize))
+			return nullptr;
+	}
+	return file.Map(headerSize, (std::size_t)dimensions.width * dimensions.height * channels);
+}
+
+// Returns a mask of the alpha samples in 8 bytes of pixels with 2 or 4 samples each
+static std::uint64_t GetAlphaMask(unsigned int channels) {
+	unsigned char bytes[8] = {};
+	for (unsigned int i = channels - 1; i < 8; i += channels)
+		bytes[i] = 0xFF;
+	std::uint64_t mask;
+	std::memcpy(&mask, bytes, 8);
+	return mask;
+}
+
+// Returns the first pixel from begin to end with a nonzero alpha, or end if there's none.
+// The alpha samples of a word of pixels are tested at once, and only the word holding an opaque pixel is scanned pixel by pixel.
+static unsigned int FindOpaquePixel(const unsigned char* row, unsigned int begin, unsigned int end, unsigned int channels, std::uint64_t mask) {
+	const unsigned int wordPixels = 8 / channels;
+	unsigned int x = begin;
+	for (std::uint64_t word; x + wordPixels <= end; x += wordPixels) {
+		std::memcpy(&word, row + (std::size_t)x * channels, 8);
+		if (word & mask)
+			break;
+	}
+	for (; x < end; x++) {
+		if (row[(std::size_t)x * channels + channels - 1] != 0)
+			return x;
+	}
+	return end;
+}
+
+// Returns one past the last pixel from begin to end with a nonzero alpha, or begin if there's none
+static unsigned int FindLastOpaquePixel(const unsigned char* row, unsigned int begin, unsigned int end, unsigned int channels, std::uint64_t mask) {
+	const unsigned int wordPixels = 8 / channels;
+	unsigned int x = end;
+	for (std::uint64_t word; x >= begin + wordPixels; x -= wordPixels) {
+		std::memcpy(&word, row + (std::size_t)(x - wordPixels) * channels, 8);
+		if (word & mask)
+			break;
+	}
+	for (; x > begin; x--) {
+		if (row[(std::size_t)(x - 1) * channels + channels - 1] != 0)
+			return x;
+	}
+	return begin;
+}
+
+bool BinPacker::FindOpaqueBounds(const std::string& path, Rect& bounds, Area rawDimensions, unsigned int rawChannels) {
+	MappedFile file;
+	Area size = rawDimensions;
+	unsigned int channels = rawChannels;
+	const unsigned char* samples = MapSamples(file, path, size, channels);
+	if (samples == nullptr || channels == 0 || channels > 4)
+		return false;
+	if (channels != 2 && channels != 4) {
+		bounds = {0, 0, size.width - 1, size.height - 1};
+		return true;
+	}
+
+	// Find the top row with an opaque pixel, and the bottom row scanning up to it
+	const std::uint64_t mask = GetAlphaMask(channels);
+	const std::size_t rowSize = (std::size_t)size.width * channels;
+	unsigned int top = 0, left = size.width;
+	while (top < size.height && (left = FindOpaquePixel(samples + top * rowSize, 0, size.width, channels, mask)) == size.width)
+		top++;
+	if (top == size.height) {
+		bounds = {1, 1, 0, 0};
+		return true;
+	}
+	unsigned int bottom = size.height - 1;
+	while (bottom > top && FindOpaquePixel(samples + bottom * rowSize, 0, size.width, channels, mask) == size.width)
+		bottom--;
+
+	// The rows in between only need scanning outside the columns found so far
+	unsigned int right = FindLastOpaquePixel(samples + top * rowSize, left, size.width, channels, mask);
+	for (unsigned int y = top + 1; y <= bottom; y++) {
+		const unsigned char* row = samples + y * rowSize;
+		left = FindOpaquePixel(row, 0, left, channels, mask);
+		right = FindLastOpaquePixel(row, right, size.width, channels, mask);
+	}
+	bounds = {left, top, right - 1, bottom};
+	return true;
+}
+
+Area BinPacker::TrimSprite(Sprite& sprite, unsigned int rawChannels) {
+	// A sprite that couldn't be read is left untrimmed, so compositing it reports the failure
+	Rect bounds;
+	if (!FindOpaqueBounds(sprite.path, bounds, sprite.rawDimensions, rawChannels))
+		return Area{0, 0};
+	sprite.trimmed = true;
+	sprite.bounds = bounds;
+	if (!bounds.IsValid())
+		return Area{0, 0};
+	return Area{sprite.bounds.right - sprite.bounds.left + 1, sprite.bounds.bottom - sprite.bounds.top + 1};
+}
+
+AtlasBuilder::AtlasBuilder(Area dimensions, unsigned int channels)
+	: dimensions(dimensions), channels(channels), pixels((std::size_t)dimensions.width * dimensions.height * channels, 0) {
+}
+
+std::vector<std::size_t> AtlasBuilder::Composite(const std::vector<Sprite>& sprites, unsigned int threadCount) {
+	using namespace std;
+
+	if (threadCount == 0)
+		threadCount = max(thread::hardware_concurrency(), 1u);
+
+	// Placements don't overlap, so each thread copies whole sprites into the atlas without locking
+	atomic<size_t> next(0);
+	mutex failedMutex;
+	vector<size_t> failed;
+	auto composite = [&]() {
+		for (size_t i = next++; i < sprites.size(); i = next++) {
+			if (!CompositeSprite(sprites[i])) {
+				lock_guard<mutex> lock(failedMutex);
+				failed.push_back(i);
+			}
+		}
+	};
+
+	vector<thread> helpers;
+	for (unsigned int t = 1; t < threadCount; t++)
+		helpers.emplace_back(composite);
+	composite();
+	for (thread & helper : helpers)
+		helper.join();
+
+	sort(failed.begin(), failed.end());
+	return failed;
+}
+
+bool AtlasBuilder::CompositeSprite(const Sprite& sprite) {
+	using namespace std;
+
+	// A trimmed sprite without bounds is entirely transparent, so it has nothing to copy
+	if (sprite.trimmed && !sprite.bounds.IsValid())
+		return true;
+	const Rect & p = sprite.placement;
+	if (!p.IsValid() || p.right >= dimensions.width || p.bottom >= dimensions.height)
+		return false;
+
+	MappedFile file;
+	Area size = sprite.rawDimensions;
+	unsigned int imageChannels = channels;
+	const unsigned char* samples = MapSamples(file, sprite.path, size, imageChannels);
+	if (samples == nullptr || imageChannels != channels)
+		return false;
+
+	// Only the sprite's bounds are copied, reading the image's rows from their left
+	const Rect bounds = sprite.trimmed ? sprite.bounds : Rect{0, 0, size.width - 1, size.height - 1};
+	if (bounds.right >= size.width || bounds.bottom >= size.height)
+		return false;
+	const size_t rowSize = (size_t)size.width * channels;
+	const unsigned char* source = samples + bounds.top * rowSize + (size_t)bounds.left * channels;
+	size = {bounds.right - bounds.left + 1, bounds.bottom - bounds.top + 1};
+
+	const unsigned int width = p.right - p.left + 1, height = p.bottom - p.top + 1;
+	const size_t atlasRowSize = (size_t)dimensions.width * channels;
+	unsigned char* destination = &pixels[p.top * atlasRowSize + (size_t)p.left * channels];
+	if (width == size.width && height == size.height) {
+		for (unsigned int y = 0; y < height; y++)
+			memcpy(destination + y * atlasRowSize, source + y * rowSize, (size_t)width * channels);
+		return true;
+	}
+	if (width != size.height || height != size.width)
+		return false;
+
+	// Rotate clockwise, so the source's bottom row becomes the destination's left column.
+	// Blocks of pixels are copied at a time, so that both images are read and written a few cache lines at a time.
+	const unsigned int block = 32;
+	for (unsigned int by = 0; by < height; by += block) {
+		for (unsigned int bx = 0; bx < width; bx += block) {
+			for (unsigned int y = by; y < min(by + block, height); y++) {
+				unsigned char* row = destination + y * atlasRowSize;
+				for (unsigned int x = bx; x < min(bx + block, width); x++)
+					memcpy(row + (size_t)x * channels, source + (size_t)(size.height - 1 - x) * rowSize + (size_t)y * channels, channels);
+			}
+		}
+	}
+	return true;
+}
+
+bool AtlasBuilder::Write(const std::string& path) const {
+	using namespace std;
+
+	FILE* file = fopen(path.c_str(), "wb");
+	if (file == nullptr)
+		return false;
+
+	bool written = true;
+	const bool raw = path.size() >= 4 && path.compare(path.size() - 4, 4, ".raw") == 0;
+	if (!raw) {
+		if (channels == 1 || channels == 3) {
+			written = fprintf(file, "P%c\n%u %u\n255\n", channels == 1 ? '5' : '6', dimensions.width, dimensions.height) > 0;
+		} else {
+			written = fprintf(file, "P7\nWIDTH %u\nHEIGHT %u\nDEPTH %u\nMAXVAL 255\n", dimensions.width, dimensions.height, channels) > 0;
+			if (channels == 2 || channels == 4)
+				written = written && fprintf(file, "TUPLTYPE %s\n", channels == 2 ? "GRAYSCALE_ALPHA" : "RGB_ALPHA") > 0;
+			written = written && fprintf(file, "ENDHDR\n") > 0;
+		}
+	}
+	written = written && fwrite(pixels.data(), 1, pixels.size(), file) == pixels.size();
+	return fclose(file) == 0 && written;
+}
+
+Area AtlasBuilder::GetDimensions() const {
+	return dimensions;
+}
+
+unsigned int AtlasBuilder::GetChannels() const {
+	return channels;
+}
+
+const std::vector<unsigned char>& AtlasBuilder::GetPixels() const {
+	return pixels;
+}
@@ -0,0 +1,79 @@
+// Compositing of sprite images into an atlas at their packed placements.
+// Sprites are binary PGM (P5), PPM (P6) or PAM (P7) images with 8-bit samples, or raw images of
+// tightly packed 8-bit samples with known dimensions. Each sprite is memory-mapped and copied into
+// the atlas by one of several threads, which take sprites in turn. Packed placements never overlap,
+// so threads never write the same pixels and need no synchronization beyond taking the next sprite.
+// A sprite whose placement has the width and height of its image swapped, as when TryPackArea
+// rotates an item, is copied rotated 90 degrees clockwise.
+// Sprites with an alpha channel can be trimmed of their transparent borders before packing: only the
+// bounds found by TrimSprite are packed and copied, and renderers offset the copied pixels by the
+// bounds' left and top to restore the sprite's original frame. Entirely transparent sprites have no
+// bounds, and are neither packed nor copied.
+
+#pragma once
+#include "binpacker.h"
+#include <cstddef>
+#include <string>
+
+namespace BinPacker
+{
+	/// \brief An image to copy into an atlas.
+	struct Sprite {
+		/// \brief Path of the image file.
+		std::string path;
+		/// \brief Location of the image in the atlas, as returned by \see Bin::TryPackArea for the image's dimensions.
+		Rect placement;
+		/// \brief Dimensions of a raw image, whose samples per pixel match the atlas, or {0, 0} if the image is a PGM, PPM or PAM file.
+		Area rawDimensions = {0, 0};
+		/// \brief If true, only \a bounds of the image is copied, otherwise the whole image is.
+		bool trimmed = false;
+		/// \brief Part of the image to copy if \a trimmed, as set by \see TrimSprite, or an invalid Rect to copy nothing.
+		/// Its left and top are the offset of the copied pixels within the image's original frame.
+		Rect bounds = {1, 1, 0, 0};
+	};
+
+	/// \brief Reads the dimensions and samples per pixel of the PGM, PPM or PAM image at \a path.
+	/// \return False if the file couldn't be read or isn't a supported image.
+	bool ReadImageInfo(const std::string& path, Area& dimensions, unsigned int& channels);
+
+	/// \brief Finds the smallest rectangle holding every pixel with a nonzero alpha sample in the image at \a path.
+	/// The last sample of each pixel is its alpha in images with 2 or 4 samples per pixel. Images without alpha are entirely opaque.
+	/// \param bounds Receives the rectangle, or an invalid Rect if the image is entirely transparent.
+	/// \param rawDimensions Dimensions of a raw image, or {0, 0} if the image is a PGM, PPM or PAM file.
+	/// \param rawChannels Samples per pixel of a raw image.
+	/// \return False if the file couldn't be read or isn't a supported image.
+	bool FindOpaqueBounds(const std::string& path, Rect& bounds, Area rawDimensions = {0, 0}, unsigned int rawChannels = 0);
+
+	/// \brief Trims \a sprite to the opaque bounds of its image, as found by \see FindOpaqueBounds, unless the image couldn't be read.
+	/// \param rawChannels Samples per pixel of the image if it is raw.
+	/// \return The dimensions to pack the sprite with, which are {0, 0} if the image is entirely transparent or couldn't be read.
+	Area TrimSprite(Sprite& sprite, unsigned int rawChannels = 0);
+
+	/// \brief Atlas image into which sprites are composited.
+	class AtlasBuilder {
+		public:
+			/// \brief Creates an atlas of \a dimensions with \a channels 8-bit samples per pixel, all zero.
+			AtlasBuilder(Area dimensions, unsigned int channels);
+
+			/// \brief Copies each of \a sprites into its placement in the atlas.
+			/// \param threadCount The number of threads to copy on, including the calling thread, or 0 for one per hardware thread.
+			/// \return The indices of sprites that couldn't be read, whose samples per pixel differ from the atlas,
+			/// or whose placement doesn't fit the image, its bounds or the atlas.
+			std::vector<std::size_t> Composite(const std::vector<Sprite>& sprites, unsigned int threadCount = 0);
+			/// \brief Writes the atlas to \a path as a PGM, PPM or PAM image depending on its samples per pixel,
+			/// or as raw samples if \a path ends with ".raw".
+			/// \return False if the file couldn't be written.
+			bool Write(const std::string& path) const;
+
+			Area GetDimensions() const;
+			unsigned int GetChannels() const;
+			/// \brief Returns the samples of the atlas, row by row from the top with no padding between rows.
+			const std::vector<unsigned char>& GetPixels() const;
+		private:
+			bool CompositeSprite(const Sprite& sprite);
+
+			Area dimensions;
+			unsigned int channels;
+			std::vector<unsigned char> pixels;
+	};
+}
@@ -0,0 +1,102 @@
+#include "backgroundcompactor.h"
+#include <algorithm>
+
+using namespace BinPacker;
+
+BackgroundCompactor::BackgroundCompactor(Bin& bin, PackConstraints constraints, unsigned int maxMovesPerBatch, double minFragmentation)
+	: bin(bin), constraints(constraints), maxMovesPerBatch(maxMovesPerBatch > 0 ? maxMovesPerBatch : 1), minFragmentation(minFragmentation) {
+	thread = std::thread(&BackgroundCompactor::Run, this);
+}
+
+BackgroundCompactor::~BackgroundCompactor() {
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		stopping = true;
+		wake.notify_one();
+	}
+	thread.join();
+}
+
+std::vector<Relocation> BackgroundCompactor::Poll(const std::vector<Rect>& liveRects) {
+	using namespace std;
+
+	vector<Relocation> batch;
+	bool finished;
+	{
+		lock_guard<mutex> lock(jobMutex);
+		if (planning)
+			return batch;
+
+		if (batches.empty()) {
+			// Start planning a compaction against a copy of the bin as it is now
+			if (!liveRects.empty() && bin.GetRevision() != settledRevision && GetFragmentation(liveRects) > minFragmentation) {
+				snapshot = bin;
+				snapshotRects = liveRects;
+				planning = true;
+				wake.notify_one();
+			}
+			return batch;
+		}
+
+		batch = move(batches.front());
+		batches.pop_front();
+		finished = batches.empty();
+	}
+
+	// Only apply relocations whose rects haven't been released or moved and whose destinations haven't been packed since the copy
+	auto same = [](const Rect & a, const Rect & b){ return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom; };
+	vector<Rect> current = liveRects;
+	vector<Relocation> applied;
+	for (const Relocation & r : batch) {
+		auto live = find_if(current.begin(), current.end(), [&](const Rect & c){ return same(c, r.from); });
+		// Later relocations that depended on a skipped one fail the same checks, and the compaction is retried once the plan is used up
+		if (live == current.end() || !bin.Reserve(r.to, constraints))
+			continue;
+		bin.Release(r.from, constraints);
+		*live = r.to;
+		applied.push_back(r);
+	}
+
+	// The plan is used up, so replace the empty regions fragmented by the moves
+	if (finished)
+		bin.RebuildEmptyRegions(current, constraints);
+	return applied;
+}
+
+void BackgroundCompactor::Run() {
+	std::unique_lock<std::mutex> lock(jobMutex);
+	while (true) {
+		wake.wait(lock, [this]{ return planning || stopping; });
+		if (stopping)
+			return;
+
+		Bin copy = std::move(snapshot);
+		std::vector<Rect> rects = std::move(snapshotRects);
+		lock.unlock();
+
+		std::deque<std::vector<Relocation>> planBatches;
+		Defragmenter defragmenter(copy, rects, constraints);
+		while (!defragmenter.IsDone())
+			planBatches.push_back(defragmenter.Step(maxMovesPerBatch));
+
+		lock.lock();
+		// If the bin can't be compacted any further, wait for it to change before trying again
+		if (planBatches.empty())
+			settledRevision = copy.GetRevision();
+		batches.swap(planBatches);
+		planning = false;
+	}
+}
+
+// Returns the fraction of the free space of the bin outside of its largest empty region
+double BackgroundCompactor::GetFragmentation(const std::vector<Rect>& liveRects) const {
+	const Area dimensions = bin.GetDimensions();
+	unsigned long long freeArea = (unsigned long long)dimensions.width * dimensions.height;
+	for (const Rect & r : liveRects)
+		freeArea -= std::min(freeArea, (unsigned long long)(r.right - r.left + 1) * (r.bottom - r.top + 1));
+
+	unsigned long long largestRegion = 0;
+	for (const Rect & r : bin.GetEmptyRegions())
+		largestRegion = std::max(largestRegion, (unsigned long long)(r.right - r.left + 1) * (r.bottom - r.top + 1));
+	return freeArea > 0 ? 1.0 - (double)largestRegion / freeArea : 0.0;
+}
@@ -0,0 +1,60 @@
+// Continuous defragmentation of a bin without stalling the thread that uses it.
+// When the free space of the bin becomes fragmented, the compactor copies the bin and its live
+// rects and plans their compaction with a Defragmenter on a worker thread. The owning thread polls
+// the compactor, e.g. once per frame, and receives the planned relocations in small batches. Since
+// the bin keeps changing while the plan is computed and applied, each relocation is only applied if
+// its source is still live and its destination is still empty. Relocations that can't be applied are
+// skipped, along with any that depend on them, and if the bin is still fragmented once the plan is
+// used up, the compaction is retried with a new copy of the bin.
+
+#pragma once
+#include "defragmenter.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace BinPacker
+{
+	/// \brief Compacts a \see Bin in the background while it remains in use.
+	class BackgroundCompactor {
+		public:
+			/// \brief Starts the worker thread for compacting \a bin, which must outlive the compactor.
+			/// \param maxMovesPerBatch The maximum number of relocations applied by each call to \see Poll.
+			/// \param minFragmentation Compaction starts once the largest empty region covers less than this fraction of the free space.
+			BackgroundCompactor(Bin& bin, PackConstraints constraints = PackConstraints(), unsigned int maxMovesPerBatch = 16, double minFragmentation = 0.5);
+			/// \brief Discards any compaction in progress and stops the worker thread.
+			~BackgroundCompactor();
+
+			BackgroundCompactor(const BackgroundCompactor&) = delete;
+			BackgroundCompactor& operator=(const BackgroundCompactor&) = delete;
+
+			/// \brief Applies the next batch of planned relocations to the bin, or starts planning a compaction if none is in progress.
+			/// Must be called on the thread that uses the bin.
+			/// \param liveRects Every rect currently packed into the bin with the compactor's constraints.
+			/// \return The relocations applied, whose contents must be copied in order and whose rects must be updated before the next poll.
+			std::vector<Relocation> Poll(const std::vector<Rect>& liveRects);
+		private:
+			void Run();
+			double GetFragmentation(const std::vector<Rect>& liveRects) const;
+
+			Bin& bin;
+			const PackConstraints constraints;
+			const unsigned int maxMovesPerBatch;
+			const double minFragmentation;
+
+			std::mutex jobMutex;
+			std::condition_variable wake;
+			// Copy of the bin and its live rects for the worker to plan against
+			bool planning = false;
+			bool stopping = false;
+			Bin snapshot;
+			std::vector<Rect> snapshotRects;
+			// Batches planned by the worker, applied in order by Poll
+			std::deque<std::vector<Relocation>> batches;
+			// Revision of the bin when the worker last found nothing to compact
+			unsigned long long settledRevision = ~0ull;
+
+			std::thread thread;
+	};
+}
@@ -1,7 +1,12 @@
 #include "binpacker.h"
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <limits>
 #include <map>
+#include <mutex>
 #include <numeric>
+#include <thread>
 
 using namespace BinPacker;
 
@@ -9,6 +14,10 @@ bool Rect::IsValid() const {
 	return left <= right && top <= bottom;
 }
 
+Bin::Bin(Area dimensions, std::vector<Rect> emptyRegions)
+	: dimensions(dimensions), emptyRegions(std::move(emptyRegions)) {
+}
+
 Area Bin::GetDimensions() const {
 	return dimensions;
 }
@@ -17,6 +26,10 @@ const std::vector<Rect>& Bin::GetEmptyRegions() const {
 	return emptyRegions;
 }
 
+unsigned long long Bin::GetRevision() const {
+	return revision;
+}
+
 // Scores the result of clipping region by clip based on the number
 // of spaces that would result and the amount of space remaining
 int GetClipScore(Rect region, Rect clip) {
@@ -51,93 +64,595 @@ int GetClipScore(Rect region, Rect clip) {
 	}
 }
 
-Rect Bin::TryPackArea(Area area) {
+// Rounds value up to the nearest multiple of alignment
+unsigned int AlignUp(unsigned int value, unsigned int alignment) {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+// Position of an item along one axis and the span it reserves including padding
+struct AxisPlacement {
+	unsigned int position, start, end;
+	bool valid;
+};
+
+// Places an item of the given (size-aligned) length against the near or far edge of a region along one axis.
+// The position is aligned inward, away from the edge, and padding is dropped along the edges of the bin if requested.
+AxisPlacement PlaceOnAxis(unsigned int regionStart, unsigned int regionEnd, unsigned int binLength, unsigned int length,
+	unsigned int padBefore, unsigned int padAfter, unsigned int alignment, bool padBinEdges, bool farEdge) {
+	const AxisPlacement invalid = {0, 0, 0, false};
+	unsigned int position;
+	if (!farEdge) {
+		position = AlignUp(!padBinEdges && regionStart == 0 ? 0 : regionStart + padBefore, alignment);
+	} else {
+		const unsigned int padding = !padBinEdges && regionEnd == binLength - 1 ? 0 : padAfter;
+		if (regionEnd + 1 < padding + length)
+			return invalid;
+		position = (regionEnd + 1 - padding - length) / alignment * alignment;
+	}
+
+	if (position + length > binLength || (padBinEdges && position < padBefore))
+		return invalid;
+	const unsigned int start = position - std::min(position, padBefore);
+	unsigned int end = position + length - 1 + padAfter;
+	if (end >= binLength) {
+		if (padBinEdges)
+			return invalid;
+		end = binLength - 1;
+	}
+
+	if (start < regionStart || end > regionEnd)
+		return invalid;
+	return AxisPlacement{position, start, end, true};
+}
+
+// Returns the space reserved for a rect packed with the given constraints, including its padding and size alignment,
+// or an invalid rect if that space doesn't fit in the bin. Padding is dropped along the edges of the bin if requested.
+Rect GetReservedRect(Rect rect, Area dimensions, const PackConstraints & constraints) {
 	using namespace std;
 
-	if (area.width > 0 && area.height > 0
-		&& area.width <= dimensions.width && area.height <= dimensions.height) {
-		// Try to fit the new area into every corner of every empty region
-		// (including 90-degree rotation) and compare the placement
-		// against every empty region to see which position and orientation
-		// results in the lowest clip score
-		int minScore = numeric_limits<int>::max();
-		Rect bestRect({1, 1, 0, 0});
-		for (const Area & area : {area, {area.height, area.width}}) { // For each orientation
+	const Rect invalid = {1, 1, 0, 0};
+	if (!rect.IsValid() || rect.right >= dimensions.width || rect.bottom >= dimensions.height)
+		return invalid;
+
+	const Padding & padding = constraints.padding;
+	const Area sizeAlignment = { max(constraints.sizeAlignment.width, 1u), max(constraints.sizeAlignment.height, 1u) };
+	const unsigned long long right = (unsigned long long)rect.left + AlignUp(rect.right - rect.left + 1, sizeAlignment.width) - 1 + padding.right;
+	const unsigned long long bottom = (unsigned long long)rect.top + AlignUp(rect.bottom - rect.top + 1, sizeAlignment.height) - 1 + padding.bottom;
+	if (constraints.padBinEdges && (rect.left < padding.left || rect.top < padding.top || right >= dimensions.width || bottom >= dimensions.height))
+		return invalid;
+
+	return Rect{
+		rect.left - min(rect.left, padding.left),
+		rect.top - min(rect.top, padding.top),
+		(unsigned int)min<unsigned long long>(right, dimensions.width - 1),
+		(unsigned int)min<unsigned long long>(bottom, dimensions.height - 1)
+	};
+}
+
+// Returns the parts of each piece that don't intersect cut
+std::vector<Rect> SubtractRect(const std::vector<Rect> & pieces, Rect cut) {
+	using namespace std;
+
+	vector<Rect> remaining;
+	for (const Rect & p : pieces) {
+		if (cut.left > p.right || cut.right < p.left || cut.top > p.bottom || cut.bottom < p.top) {
+			remaining.push_back(p);
+			continue;
+		}
+
+		// Split off the rows above and below the cut, then the columns to either side of it
+		if (p.top < cut.top)
+			remaining.push_back(Rect{p.left, p.top, p.right, cut.top - 1});
+		if (p.bottom > cut.bottom)
+			remaining.push_back(Rect{p.left, cut.bottom + 1, p.right, p.bottom});
+		const unsigned int top = max(p.top, cut.top), bottom = min(p.bottom, cut.bottom);
+		if (p.left < cut.left)
+			remaining.push_back(Rect{p.left, top, cut.left - 1, bottom});
+		if (p.right > cut.right)
+			remaining.push_back(Rect{cut.right + 1, top, p.right, bottom});
+	}
+	return remaining;
+}
+
+// Returns if the union of regions covers every piece
+bool IsCovered(const std::vector<Rect> & regions, std::vector<Rect> pieces) {
+	for (const Rect & r : regions) {
+		if (pieces.empty())
+			break;
+		pieces = SubtractRect(pieces, r);
+	}
+	return pieces.empty();
+}
+
+// Returns the maximal rectangles within the union of space that intersect target
+std::vector<Rect> GetMaximalRects(const std::vector<Rect> & space, Rect target) {
+	using namespace std;
+
+	// Divide the space into a grid of cells along the edges of its rects and mark the cells they cover
+	vector<unsigned int> xs, ys;
+	for (const Rect & r : space) {
+		xs.insert(xs.end(), { r.left, r.right + 1 });
+		ys.insert(ys.end(), { r.top, r.bottom + 1 });
+	}
+	sort(xs.begin(), xs.end());
+	xs.erase(unique(xs.begin(), xs.end()), xs.end());
+	sort(ys.begin(), ys.end());
+	ys.erase(unique(ys.begin(), ys.end()), ys.end());
+	if (xs.size() < 2 || ys.size() < 2)
+		return {};
+	auto column = [&xs](unsigned int x) { return (size_t)(lower_bound(xs.cbegin(), xs.cend(), x) - xs.cbegin()); };
+	auto row = [&ys](unsigned int y) { return (size_t)(lower_bound(ys.cbegin(), ys.cend(), y) - ys.cbegin()); };
+	const size_t columns = xs.size() - 1, rows = ys.size() - 1;
+	vector<unsigned char> covered(columns * rows, 0);
+	for (const Rect & r : space) {
+		for (size_t y = row(r.top); y < row(r.bottom + 1); y++)
+			fill(covered.begin() + y * columns + column(r.left), covered.begin() + y * columns + column(r.right + 1), 1);
+	}
+
+	// For each row of cells, find the rectangles of covered cells ending in that row that can't be extended left, right or up
+	// from the number of covered cells above each cell. Those that can't be extended down either are maximal.
+	const size_t targetLeft = column(target.left), targetRight = column(target.right + 1) - 1;
+	const size_t targetTop = row(target.top), targetBottom = row(target.bottom + 1) - 1;
+	vector<size_t> heights(columns, 0);
+	vector<Rect> maximal;
+	for (size_t y = 0; y < rows; y++) {
+		for (size_t x = 0; x < columns; x++)
+			heights[x] = covered[y * columns + x] ? heights[x] + 1 : 0;
+
+		for (size_t x = 0; x < columns; x++) {
+			const size_t height = heights[x];
+			if (height == 0 || y + 1 - height > targetBottom || y < targetTop)
+				continue;
+			// Columns of the same height within the rectangle find the same rectangle, so only the leftmost reports it
+			size_t left = x, right = x;
+			bool duplicate = false;
+			while (left > 0 && heights[left - 1] >= height && !duplicate)
+				duplicate = heights[--left] == height;
+			while (right + 1 < columns && heights[right + 1] >= height)
+				right++;
+			if (duplicate || left > targetRight || right < targetLeft)
+				continue;
+			if (y + 1 < rows && all_of(covered.cbegin() + (y + 1) * columns + left, covered.cbegin() + (y + 1) * columns + right + 1, [](unsigned char c){ return c != 0; }))
+				continue;
+			maximal.push_back(Rect{ xs[left], ys[y + 1 - height], xs[right + 1] - 1, ys[y + 1] - 1 });
+		}
+	}
+	return maximal;
+}
+
+// Sums the clip scores of clip against every region. The sum wraps on overflow
+// identically on every platform, so placements are the same wherever the bin is packed.
+int GetPlacementScore(const std::vector<Rect> & regions, Rect clip) {
+	return (int)std::accumulate(regions.cbegin(), regions.cend(), 0u, [&clip](unsigned int score, const Rect & r){ return score + (unsigned int)GetClipScore(r, clip); });
+}
+
+// A prospective placement of an area. The clip is the space reserved for the area, including padding.
+struct Placement {
+	Rect clip, rect;
+	int score;
+};
+
+// Tries to fit the area into every corner of every empty region (including 90-degree
+// rotation) and returns the candidate with the lowest score, preferring earlier candidates.
+// The scorer is called as score(clip, rect, result) and returns false to skip a candidate.
+template <typename Scorer>
+Placement FindPlacement(const std::vector<Rect> & emptyRegions, Area dimensions, Area area, const PackConstraints & constraints, Scorer score) {
+	using namespace std;
+
+	int minScore = numeric_limits<int>::max();
+	Rect bestClip({1, 1, 0, 0});
+	Rect bestRect({1, 1, 0, 0});
+	const bool fits = (area.width <= dimensions.width && area.height <= dimensions.height)
+		|| (constraints.allowRotation && area.height <= dimensions.width && area.width <= dimensions.height);
+	if (area.width > 0 && area.height > 0 && fits) {
+		const Padding & padding = constraints.padding;
+		const Area alignment = { max(constraints.positionAlignment.width, 1u), max(constraints.positionAlignment.height, 1u) };
+		const Area sizeAlignment = { max(constraints.sizeAlignment.width, 1u), max(constraints.sizeAlignment.height, 1u) };
+
+		const Area orientations[] = { area, {area.height, area.width} };
+		const unsigned int orientationCount = constraints.allowRotation && area.width != area.height ? 2 : 1;
+		for (unsigned int orientation = 0; orientation < orientationCount; orientation++) {
+			const Area area = orientations[orientation];
+			const Area reserved = { AlignUp(area.width, sizeAlignment.width), AlignUp(area.height, sizeAlignment.height) };
 			for (const Rect & r : emptyRegions) {
-				if (r.right - r.left >= area.width - 1 && r.bottom - r.top >= area.height - 1) {	// skip regions in which the area cannot fit
-					// Test fitting in every corner
-					int score;
-					// NW
-					Rect clip = { r.left, r.top, r.left + area.width - 1, r.top + area.height - 1 };
-					score = accumulate(emptyRegions.cbegin(), emptyRegions.cend(), 0, [&clip](const int & score, const Rect & r){ return score + GetClipScore(r, clip); });
-					if (score < minScore) { minScore = score; bestRect = clip; if (score==0) break; }
-
-					// NE
-					clip = { r.right - area.width + 1, r.top, r.right, r.top + area.height - 1 };
-					score = accumulate(emptyRegions.cbegin(), emptyRegions.cend(), 0, [&clip](const int & score, const Rect & r){ return score + GetClipScore(r, clip); });
-					if (score < minScore) { minScore = score; bestRect = clip; if (score==0) break; }
-
-					// SW
-					clip = { r.left, r.bottom - area.height + 1, r.left + area.width - 1, r.bottom };
-					score = accumulate(emptyRegions.cbegin(), emptyRegions.cend(), 0, [&clip](const int & score, const Rect & r){ return score + GetClipScore(r, clip); });
-					if (score < minScore) { minScore = score; bestRect = clip; if (score==0) break; }
-
-					// SE
-					clip = { r.right - area.width + 1, r.bottom - area.height + 1, r.right, r.bottom };
-					score = accumulate(emptyRegions.cbegin(), emptyRegions.cend(), 0, [&clip](const int & score, const Rect & r){ return score + GetClipScore(r, clip); });
-					if (score < minScore) { minScore = score; bestRect = clip; if (score==0) break; }
+				if (r.right - r.left >= reserved.width - 1 && r.bottom - r.top >= reserved.height - 1) {	// skip regions in which the area cannot fit
+					// Position the area against each edge of the region
+					const AxisPlacement columns[] = {
+						PlaceOnAxis(r.left, r.right, dimensions.width, reserved.width, padding.left, padding.right, alignment.width, constraints.padBinEdges, false),
+						PlaceOnAxis(r.left, r.right, dimensions.width, reserved.width, padding.left, padding.right, alignment.width, constraints.padBinEdges, true)
+					};
+					const AxisPlacement rows[] = {
+						PlaceOnAxis(r.top, r.bottom, dimensions.height, reserved.height, padding.top, padding.bottom, alignment.height, constraints.padBinEdges, false),
+						PlaceOnAxis(r.top, r.bottom, dimensions.height, reserved.height, padding.top, padding.bottom, alignment.height, constraints.padBinEdges, true)
+					};
+
+					// Test fitting in every corner (NW, NE, SW, SE)
+					for (const AxisPlacement & y : rows) {
+						for (const AxisPlacement & x : columns) {
+							if (!x.valid || !y.valid)
+								continue;
+							const Rect clip = { x.start, y.start, x.end, y.end };
+							const Rect rect = { x.position, y.position, x.position + area.width - 1, y.position + area.height - 1 };
+							int candidateScore;
+							if (score(clip, rect, candidateScore) && candidateScore < minScore) {
+								minScore = candidateScore;
+								bestClip = clip;
+								bestRect = rect;
+								if (candidateScore == 0) break;
+							}
+						}
+						if (minScore == 0) break;
+					}
+					if (minScore == 0) break;
 				}
 			}
 			if (minScore == 0) break;
 		}
+	}
 
-		if (bestRect.IsValid()) {
-			const Rect & clip = bestRect;
-			// Now remove regions that are clipped and create new empty regions of what remains.
-			vector<Rect> emptyRegionsToInsert;
-			for (auto i = emptyRegions.begin(); i != emptyRegions.end();) {
-				if (clip.left <= i->right && clip.top <= i->bottom && clip.right >= i->left && clip.bottom >= i->top) {
-					if (clip.left > i->left && clip.left <= i->right)
-						emptyRegionsToInsert.emplace_back(Rect{ i->left, i->top, clip.left - 1, i->bottom });
-					if (clip.top > i->top && clip.top <= i->bottom)
-						emptyRegionsToInsert.emplace_back(Rect{ i->left, i->top, i->right, clip.top - 1 });
-					if (clip.right < i->right && clip.right >= i->left)
-						emptyRegionsToInsert.emplace_back(Rect{ clip.right + 1, i->top, i->right, i->bottom });
-					if (clip.bottom < i->bottom && clip.bottom >= i->top)
-						emptyRegionsToInsert.emplace_back(Rect{ i->left, clip.bottom + 1, i->right, i->bottom });
-					i = emptyRegions.erase(i);
-				} else {
-					i++;
-				}
+	return Placement{bestClip, bestRect, minScore};
+}
+
+Rect Bin::TryPackArea(Area area) {
+	return TryPackArea(area, PackConstraints());
+}
+
+Rect Bin::TryPackArea(Area area, const PackConstraints& constraints) {
+	// Compare each placement against every empty region to see which position
+	// and orientation results in the lowest clip score
+	const Placement best = FindPlacement(emptyRegions, dimensions, area, constraints, [this](const Rect & clip, const Rect &, int & score) {
+		score = GetPlacementScore(emptyRegions, clip);
+		return true;
+	});
+
+	if (best.rect.IsValid()) {
+		ClipEmptyRegions(best.clip);
+		if (trackDirtyRegions)
+			dirtyRegions.push_back(best.rect);
+	}
+	return best.rect;
+}
+
+std::vector<Rect> Bin::TryPackAreas(const std::vector<Area>& areas, const PackConstraints& constraints) {
+	std::vector<Rect> results;
+	results.reserve(areas.size());
+	for (const Area & area : areas)
+		results.push_back(TryPackArea(area, constraints));
+	return results;
+}
+
+std::vector<Rect> Bin::TryPackAreasParallel(const std::vector<Area>& areas, const PackConstraints& constraints, unsigned int windowSize, unsigned int threadCount) {
+	using namespace std;
+
+	if (threadCount == 0)
+		threadCount = max(thread::hardware_concurrency(), 1u);
+	windowSize = max(windowSize, 1u);
+
+	auto score = [this](const Rect & clip, const Rect &, int & score) {
+		score = GetPlacementScore(emptyRegions, clip);
+		return true;
+	};
+
+	// Placements for the current window of areas, all evaluated against the same empty regions,
+	// along with the score of every candidate that was evaluated in scan order
+	struct CandidateScore {
+		Rect clip;
+		int score;
+	};
+	vector<Placement> speculative(windowSize);
+	vector<vector<CandidateScore>> candidateScores(windowSize);
+	size_t windowStart = 0, windowEnd = 0;
+	atomic<size_t> next(0);
+	auto evaluate = [&]() {
+		for (size_t i = next++; i < windowEnd; i = next++) {
+			vector<CandidateScore> & scores = candidateScores[i - windowStart];
+			scores.clear();
+			speculative[i - windowStart] = FindPlacement(emptyRegions, dimensions, areas[i], constraints, [&](const Rect & clip, const Rect & rect, int & candidateScore) {
+				score(clip, rect, candidateScore);
+				scores.push_back(CandidateScore{clip, candidateScore});
+				return true;
+			});
+		}
+	};
+
+	// Helper threads evaluate each window alongside the calling thread
+	mutex windowMutex;
+	condition_variable windowStarted, windowFinished;
+	unsigned int generation = 0, busyHelpers = 0;
+	bool stopping = false;
+	vector<thread> helpers;
+	for (unsigned int t = 1; t < threadCount; t++) {
+		helpers.emplace_back([&]() {
+			unsigned int evaluatedGeneration = 0;
+			unique_lock<mutex> lock(windowMutex);
+			while (true) {
+				windowStarted.wait(lock, [&]{ return stopping || generation != evaluatedGeneration; });
+				if (stopping)
+					return;
+				evaluatedGeneration = generation;
+				lock.unlock();
+				evaluate();
+				lock.lock();
+				if (--busyHelpers == 0)
+					windowFinished.notify_one();
 			}
+		});
+	}
 
-			// Erase clipped regions and insert new empty regions
-			for (auto newRegion : emptyRegionsToInsert) {
-				// If the new region has the same width, left position, and intersects
-				// an existing region, or likewise with height, then merge them instead.
-				auto i = find_if(emptyRegions.cbegin(), emptyRegions.cend(), [&newRegion](const Rect & r){
-					return (newRegion.left == r.left && newRegion.right == r.right && newRegion.top <= r.bottom && newRegion.bottom >= r.top)
-						|| (newRegion.top == r.top && newRegion.bottom == r.bottom && newRegion.left <= r.right && newRegion.right >= r.left);
+	vector<Rect> results(areas.size(), Rect{1, 1, 0, 0});
+	vector<Rect> removedRegions, insertedRegions;
+	for (windowStart = 0; windowStart < areas.size(); windowStart = windowEnd) {
+		{
+			lock_guard<mutex> lock(windowMutex);
+			windowEnd = min(areas.size(), windowStart + windowSize);
+			next = windowStart;
+			busyHelpers = (unsigned int)helpers.size();
+			generation++;
+		}
+		windowStarted.notify_all();
+		evaluate();
+		{
+			unique_lock<mutex> lock(windowMutex);
+			windowFinished.wait(lock, [&]{ return busyHelpers == 0; });
+		}
+
+		// Commit placements in order. A candidate's score is the sum of its clip scores against every region, so its score
+		// after earlier commits is its speculative score adjusted by the regions those commits removed and inserted.
+		removedRegions.clear();
+		insertedRegions.clear();
+		for (size_t i = windowStart; i < windowEnd; i++) {
+			Placement best = speculative[i - windowStart];
+			if (!removedRegions.empty()) {
+				const vector<CandidateScore> & scores = candidateScores[i - windowStart];
+				size_t cursor = 0;
+				best = FindPlacement(emptyRegions, dimensions, areas[i], constraints, [&](const Rect & clip, const Rect & rect, int & candidateScore) {
+					// Candidates that were evaluated are visited in the same relative order, so only
+					// candidates of inserted regions (or those after a perfect score) are searched for in vain
+					for (size_t j = cursor; j < scores.size(); j++) {
+						const Rect & c = scores[j].clip;
+						if (c.left == clip.left && c.top == clip.top && c.right == clip.right && c.bottom == clip.bottom) {
+							cursor = j + 1;
+							candidateScore = (int)((unsigned int)scores[j].score + (unsigned int)GetPlacementScore(insertedRegions, clip) - (unsigned int)GetPlacementScore(removedRegions, clip));
+							return true;
+						}
+					}
+					return score(clip, rect, candidateScore);
 				});
-				if (i != emptyRegions.cend()) {
-					newRegion = Rect{
-						min(i->left, newRegion.left),
-						min(i->top, newRegion.top),
-						max(i->right, newRegion.right),
-						max(i->bottom, newRegion.bottom)
-					};
-					emptyRegions.erase(i);
-				}
+			}
 
-				// Insert the new region according to its distance from the origin. (Using std::set instead of std::vector is slower. Ordering by size is less efficient.)
-				emptyRegions.emplace(upper_bound(emptyRegions.cbegin(), emptyRegions.cend(), newRegion, [](const Rect& a, const Rect& b){ return a.left*a.top < b.left*b.top; }), newRegion);
+			if (best.rect.IsValid()) {
+				ClipEmptyRegions(best.clip, &removedRegions, &insertedRegions);
+				if (trackDirtyRegions)
+					dirtyRegions.push_back(best.rect);
+				results[i] = best.rect;
 			}
+		}
+	}
+
+	{
+		lock_guard<mutex> lock(windowMutex);
+		stopping = true;
+	}
+	windowStarted.notify_all();
+	for (thread & helper : helpers)
+		helper.join();
+
+	return results;
+}
+
+void Bin::ClipEmptyRegions(Rect clip, std::vector<Rect>* removedRegions, std::vector<Rect>* insertedRegions) {
+	using namespace std;
+
+	revision++;
+
+	// Now remove regions that are clipped and create new empty regions of what remains.
+	emptyRegionsToInsert.clear();
+	for (auto i = emptyRegions.begin(); i != emptyRegions.end();) {
+		if (clip.left <= i->right && clip.top <= i->bottom && clip.right >= i->left && clip.bottom >= i->top) {
+			if (clip.left > i->left && clip.left <= i->right)
+				emptyRegionsToInsert.emplace_back(Rect{ i->left, i->top, clip.left - 1, i->bottom });
+			if (clip.top > i->top && clip.top <= i->bottom)
+				emptyRegionsToInsert.emplace_back(Rect{ i->left, i->top, i->right, clip.top - 1 });
+			if (clip.right < i->right && clip.right >= i->left)
+				emptyRegionsToInsert.emplace_back(Rect{ clip.right + 1, i->top, i->right, i->bottom });
+			if (clip.bottom < i->bottom && clip.bottom >= i->top)
+				emptyRegionsToInsert.emplace_back(Rect{ i->left, clip.bottom + 1, i->right, i->bottom });
+			if (removedRegions)
+				removedRegions->push_back(*i);
+			i = emptyRegions.erase(i);
+		} else {
+			i++;
+		}
+	}
+
+	// Erase clipped regions and insert new empty regions
+	for (auto newRegion : emptyRegionsToInsert) {
+		// If the new region has the same width, left position, and intersects
+		// an existing region, or likewise with height, then merge them instead.
+		auto i = find_if(emptyRegions.cbegin(), emptyRegions.cend(), [&newRegion](const Rect & r){
+			return (newRegion.left == r.left && newRegion.right == r.right && newRegion.top <= r.bottom && newRegion.bottom >= r.top)
+				|| (newRegion.top == r.top && newRegion.bottom == r.bottom && newRegion.left <= r.right && newRegion.right >= r.left);
+		});
+		if (i != emptyRegions.cend()) {
+			newRegion = Rect{
+				min(i->left, newRegion.left),
+				min(i->top, newRegion.top),
+				max(i->right, newRegion.right),
+				max(i->bottom, newRegion.bottom)
+			};
+			if (removedRegions)
+				removedRegions->push_back(*i);
+			emptyRegions.erase(i);
+		}
+		if (insertedRegions)
+			insertedRegions->push_back(newRegion);
+
+		// Insert the new region according to its distance from the origin. (Using std::set instead of std::vector is slower. Ordering by size is less efficient.)
+		emptyRegions.emplace(upper_bound(emptyRegions.cbegin(), emptyRegions.cend(), newRegion, [](const Rect& a, const Rect& b){ return a.left*a.top < b.left*b.top; }), newRegion);
+	}
+}
+
+void Bin::Release(Rect rect) {
+	using namespace std;
+
+	if (!rect.IsValid() || rect.right >= dimensions.width || rect.bottom >= dimensions.height)
+		return;
+	revision++;
+
+	// Every maximal empty rectangle is one of the empty regions, so the parts of a maximal rectangle including the released space
+	// that lie beyond it are within regions bordering it. The rectangles are found among just those regions, and replace the
+	// regions they contain, so that the regions remain every maximal empty rectangle.
+	vector<Rect> space = { rect };
+	for (const Rect & r : emptyRegions) {
+		if (r.left <= rect.right + 1 && r.right + 1 >= rect.left && r.top <= rect.bottom + 1 && r.bottom + 1 >= rect.top)
+			space.push_back(r);
+	}
+	for (const Rect & r : GetMaximalRects(space, rect))
+		InsertEmptyRegion(r);
+}
+
+void Bin::Release(Rect rect, const PackConstraints& constraints) {
+	Release(GetReservedRect(rect, dimensions, constraints));
+}
+
+bool Bin::Reserve(Rect rect, const PackConstraints& constraints) {
+	const Rect clip = GetReservedRect(rect, dimensions, constraints);
+	if (!clip.IsValid() || !IsCovered(emptyRegions, {clip}))
+		return false;
+
+	ClipEmptyRegions(clip);
+	if (trackDirtyRegions)
+		dirtyRegions.push_back(rect);
+	return true;
+}
+
+void Bin::RebuildEmptyRegions(const std::vector<Rect>& packedRects, const PackConstraints& constraints) {
+	revision++;
+	emptyRegions.clear();
+	if (dimensions.width > 0 && dimensions.height > 0)
+		emptyRegions.push_back(Rect{0, 0, dimensions.width - 1, dimensions.height - 1});
+	for (const Rect & r : packedRects) {
+		const Rect clip = GetReservedRect(r, dimensions, constraints);
+		if (clip.IsValid())
+			ClipEmptyRegions(clip);
+	}
+}
+
+Rect Bin::Resize(Rect rect, Area newSize, const PackConstraints& constraints, bool* moved) {
+	if (moved != nullptr)
+		*moved = false;
+	const Rect reserved = GetReservedRect(rect, dimensions, constraints);
+	if (!reserved.IsValid() || newSize.width == 0 || newSize.height == 0)
+		return Rect{1, 1, 0, 0};
+
+	// Resize in place, in either allowed orientation, if the space needed beyond what the rect already reserves is empty
+	const Area orientations[] = { newSize, {newSize.height, newSize.width} };
+	for (unsigned int orientation = 0; orientation < (constraints.allowRotation ? 2u : 1u); orientation++) {
+		const Area size = orientations[orientation];
+		if (size.width > dimensions.width - rect.left || size.height > dimensions.height - rect.top)
+			continue;
+		const Rect resized = { rect.left, rect.top, rect.left + size.width - 1, rect.top + size.height - 1 };
+		const Rect clip = GetReservedRect(resized, dimensions, constraints);
+		if (clip.IsValid() && IsCovered(emptyRegions, SubtractRect({clip}, reserved))) {
+			Release(reserved);
+			ClipEmptyRegions(clip);
+			if (trackDirtyRegions)
+				dirtyRegions.push_back(resized);
+			return resized;
+		}
+	}
+
+	// Otherwise move it, or leave it where it was if the new size doesn't fit anywhere. The old space stays reserved
+	// while searching so that the contents can be copied from the old rect to the new one without overlapping.
+	const Rect packed = TryPackArea(newSize, constraints);
+	if (!packed.IsValid())
+		return packed;
+	Release(reserved);
+	if (moved != nullptr)
+		*moved = true;
+	return packed;
+}
+
+void Bin::InsertEmptyRegion(Rect region) {
+	using namespace std;
+
+	auto contains = [](const Rect & outer, const Rect & inner) {
+		return outer.left <= inner.left && outer.top <= inner.top && outer.right >= inner.right && outer.bottom >= inner.bottom;
+	};
+	if (any_of(emptyRegions.cbegin(), emptyRegions.cend(), [&](const Rect & r){ return contains(r, region); }))
+		return;
+
+	for (bool merged = true; merged;) {
+		emptyRegions.erase(remove_if(emptyRegions.begin(), emptyRegions.end(), [&](const Rect & r){ return contains(region, r); }), emptyRegions.end());
+
+		// Unlike when clipping, regions that merely touch are merged too, since released space borders packed areas
+		auto i = find_if(emptyRegions.cbegin(), emptyRegions.cend(), [&region](const Rect & r){
+			return (region.left == r.left && region.right == r.right && region.top <= r.bottom + 1 && region.bottom + 1 >= r.top)
+				|| (region.top == r.top && region.bottom == r.bottom && region.left <= r.right + 1 && region.right + 1 >= r.left);
+		});
+		merged = i != emptyRegions.cend();
+		if (merged) {
+			region = Rect{
+				min(i->left, region.left),
+				min(i->top, region.top),
+				max(i->right, region.right),
+				max(i->bottom, region.bottom)
+			};
+			emptyRegions.erase(i);
+		}
+	}
 
-			return clip;
+	emptyRegions.emplace(upper_bound(emptyRegions.cbegin(), emptyRegions.cend(), region, [](const Rect& a, const Rect& b){ return a.left*a.top < b.left*b.top; }), region);
+}
+
+void Bin::SetDirtyTracking(bool enabled) {
+	trackDirtyRegions = enabled;
+	if (!enabled)
+		dirtyRegions.clear();
+}
+
+std::vector<Rect> Bin::FlushDirtyRegions(unsigned int mergeThreshold) {
+	using namespace std;
+
+	// Sort by position so that neighbouring rects are considered for merging first
+	vector<Rect> coalesced;
+	coalesced.swap(dirtyRegions);
+	sort(coalesced.begin(), coalesced.end(), [](const Rect & a, const Rect & b){ return a.top < b.top || (a.top == b.top && a.left < b.left); });
+
+	// Track how many packed pixels each coalesced rect covers to measure the space wasted by merging
+	vector<unsigned long long> packedAreas;
+	packedAreas.reserve(coalesced.size());
+	for (const Rect & r : coalesced)
+		packedAreas.push_back((unsigned long long)(r.right - r.left + 1) * (r.bottom - r.top + 1));
+
+	bool merged = true;
+	while (merged) {
+		merged = false;
+		for (size_t i = 0; i < coalesced.size(); i++) {
+			for (size_t j = i + 1; j < coalesced.size();) {
+				const Rect bounds = {
+					min(coalesced[i].left, coalesced[j].left),
+					min(coalesced[i].top, coalesced[j].top),
+					max(coalesced[i].right, coalesced[j].right),
+					max(coalesced[i].bottom, coalesced[j].bottom)
+				};
+				const unsigned long long boundsArea = (unsigned long long)(bounds.right - bounds.left + 1) * (bounds.bottom - bounds.top + 1);
+				const unsigned long long packedArea = packedAreas[i] + packedAreas[j];
+				if (boundsArea <= packedArea + mergeThreshold) {
+					coalesced[i] = bounds;
+					packedAreas[i] = min(packedArea, boundsArea);
+					coalesced.erase(coalesced.begin() + j);
+					packedAreas.erase(packedAreas.begin() + j);
+					merged = true;
+					j = i + 1;	// The bounds grew, so reconsider every remaining rect
+				} else {
+					j++;
+				}
+			}
 		}
 	}
 
-	return Rect{1, 1, 0, 0};
+	return coalesced;
 }
 
 void Bin::ExtendDimensions(Area extension)
@@ -146,34 +661,33 @@ void Bin::ExtendDimensions(Area extension)
 	const unsigned int bottomEdge = dimensions.height > 0 ? dimensions.height - 1 : 0;
 	// Extend empty regions along edges, and create a new empty region if one doesn't exist that doesn't span the whole axis
 	if (extension.width > 0 && dimensions.height > 0) {
-		// If one empty region spans the entire height, just expand that one to the right.
-		auto i = find_if(emptyRegions.begin(), emptyRegions.end(), [rightEdge, bottomEdge](const Rect & r){ return r.right == rightEdge && r.bottom - r.top == bottomEdge; });
-		if (i != emptyRegions.end()) {
-			i->right += extension.width;
-		} else {
-			// Otherwise, expand all regions along the right edge and create a new empty region that spans the new area.
-			for (auto && r : emptyRegions) {
-				if (r.right == rightEdge)
-					r.right += extension.width;
+		// Expand all regions along the right edge, and if none of them spans the entire height, create a new empty region that spans the new area.
+		// Every region along the edge is expanded so that each maximal empty rectangle remains one of the regions.
+		bool spanned = false;
+		for (auto && r : emptyRegions) {
+			if (r.right == rightEdge) {
+				spanned = spanned || r.bottom - r.top == bottomEdge;
+				r.right += extension.width;
 			}
-			emptyRegions.emplace_back(Rect{ dimensions.width, 0, dimensions.width + extension.width - 1, bottomEdge });
 		}
+		if (!spanned)
+			emptyRegions.emplace_back(Rect{ dimensions.width, 0, dimensions.width + extension.width - 1, bottomEdge });
 	}
 	dimensions.width += extension.width;
-	rightEdge += extension.width;
+	rightEdge = dimensions.width > 0 ? dimensions.width - 1 : 0;
 
 	if (extension.height > 0 && dimensions.width > 0) {
-		auto i = find_if(emptyRegions.begin(), emptyRegions.end(), [rightEdge, bottomEdge](const Rect & r){ return r.bottom == bottomEdge && r.right - r.left == rightEdge; });
-		if (i != emptyRegions.end()) {
-			i->bottom += extension.height;
-		} else {
-			for (auto && r : emptyRegions) {
-				if (r.bottom == bottomEdge)
-					r.bottom += extension.height;
+		bool spanned = false;
+		for (auto && r : emptyRegions) {
+			if (r.bottom == bottomEdge) {
+				spanned = spanned || r.right - r.left == rightEdge;
+				r.bottom += extension.height;
 			}
-			emptyRegions.emplace_back(Rect{ 0, dimensions.height, rightEdge, dimensions.height + extension.height - 1 });
 		}
+		if (!spanned)
+			emptyRegions.emplace_back(Rect{ 0, dimensions.height, rightEdge, dimensions.height + extension.height - 1 });
 	}
 
 	dimensions.height += extension.height;
+	revision++;
 }
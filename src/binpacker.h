@@ -8,6 +8,7 @@
 // multiple candidates exist, the candidate that minimizes the amount of space left behind
 // (effectively maximizing the amount of space filled at the same time) is chosen.
 
+#pragma once
 #include <vector>
 
 namespace BinPacker
@@ -24,12 +25,70 @@ namespace BinPacker
 		unsigned int width, height;
 	};
 
+	/// \brief Amount of space reserved on each side of a packed item.
+	struct Padding {
+		unsigned int left, top, right, bottom;
+	};
+
+	/// \brief Placement constraints applied when packing an item.
+	struct PackConstraints {
+		/// \brief Space reserved around the item in which no other item may be packed.
+		Padding padding = {0, 0, 0, 0};
+		/// \brief If false, padding is not reserved on sides of the item that touch the edges of the bin.
+		bool padBinEdges = true;
+		/// \brief If false, the item is never rotated by 90 degrees to fit.
+		bool allowRotation = true;
+		/// \brief The left and top positions of the item are multiples of this alignment.
+		Area positionAlignment = {1, 1};
+		/// \brief The space reserved for the item (excluding padding) is rounded up to a multiple of this alignment.
+		Area sizeAlignment = {1, 1};
+	};
+
 	/// \brief Class for recording available space.
 	class Bin {
 		public:
+			Bin() = default;
+			/// \brief Creates a bin of \a dimensions whose available space is described by \a emptyRegions,
+			/// e.g. as previously returned by \see GetEmptyRegions.
+			Bin(Area dimensions, std::vector<Rect> emptyRegions);
+
 			/// \brief Attempts to location an optimal area in the bin for packing \a area.
 			/// \return If successful, returns a \see Rect object of the location of the packed area, otherwise returns an invalid \see Rect object.
 			Rect TryPackArea(Area area);
+			/// \brief Attempts to locate an optimal area in the bin for packing \a area subject to \a constraints.
+			/// Padding and size alignment are reserved in the bin but are not included in the returned \see Rect.
+			/// \return If successful, returns a \see Rect object of the location of the packed area, otherwise returns an invalid \see Rect object.
+			Rect TryPackArea(Area area, const PackConstraints& constraints);
+			/// \brief Packs each of \a areas in order, equivalent to calling \see TryPackArea for each area.
+			/// \return A \see Rect for each area, invalid for areas that couldn't be packed.
+			std::vector<Rect> TryPackAreas(const std::vector<Area>& areas, const PackConstraints& constraints = PackConstraints());
+			/// \brief Packs each of \a areas in order with results identical to \see TryPackAreas.
+			/// Placements for up to \a windowSize areas at a time are evaluated in parallel against the same empty regions and then
+			/// committed in order, adjusting their candidates' scores by the regions changed by the areas committed before them.
+			/// \param threadCount The number of threads to evaluate placements on, or 0 for one per hardware thread.
+			std::vector<Rect> TryPackAreasParallel(const std::vector<Area>& areas, const PackConstraints& constraints = PackConstraints(),
+				unsigned int windowSize = 16, unsigned int threadCount = 0);
+			/// \brief Returns the space occupied by \a rect to the empty regions of the bin.
+			/// \a rect must lie within the bin and must not overlap any area that is still packed. The empty regions remain every
+			/// maximal rectangle of empty space, so once every packed area is released a single region covers the bin again.
+			void Release(Rect rect);
+			/// \brief Returns the space reserved for \a rect, as returned by \see TryPackArea with \a constraints, to the empty regions of the bin.
+			/// This includes the padding and size alignment reserved around \a rect.
+			void Release(Rect rect, const PackConstraints& constraints);
+			/// \brief Reserves the space for \a rect as if it had been packed there with \a constraints.
+			/// \return False, leaving the bin unchanged, if any of that space isn't empty.
+			bool Reserve(Rect rect, const PackConstraints& constraints = PackConstraints());
+			/// \brief Replaces the empty regions of the bin with all of its space except that reserved for \a packedRects,
+			/// as returned by \see TryPackArea with \a constraints. Rebuilding the empty regions from scratch is quicker than
+			/// releasing and packing many rects one at a time, and drops regions that lie within others.
+			void RebuildEmptyRegions(const std::vector<Rect>& packedRects, const PackConstraints& constraints = PackConstraints());
+			/// \brief Changes the size of \a rect, as returned by \see TryPackArea with \a constraints, to \a newSize.
+			/// The rect keeps its position if the space it needs beyond what it already reserves is empty, otherwise it is
+			/// packed again elsewhere and then released, so a moved rect never overlaps the old one, even where the old and
+			/// neighbouring space together would have fit it. Like \see TryPackArea, the resized rect may be rotated.
+			/// \param moved If not null, set to true if the rect was moved and its contents need to be copied.
+			/// \return The resized rect, or an invalid \see Rect object if \a newSize doesn't fit, in which case \a rect remains packed.
+			Rect Resize(Rect rect, Area newSize, const PackConstraints& constraints = PackConstraints(), bool* moved = nullptr);
 			/// \brief Increases the dimensions of the bin.
 			void ExtendDimensions(Area extension);
 
@@ -37,8 +96,27 @@ namespace BinPacker
 			Area GetDimensions() const;
 			/// \brief Returns a read-only vector of \see Rect objects representative of available empty space within the bin.
 			const std::vector<Rect>& GetEmptyRegions() const;
+			/// \brief Returns a number that changes whenever the empty regions or dimensions of the bin change.
+			unsigned long long GetRevision() const;
+
+			/// \brief Enables or disables recording of packed areas for \see FlushDirtyRegions.
+			void SetDirtyTracking(bool enabled);
+			/// \brief Returns the areas packed since the last flush coalesced into as few rectangles as possible and clears the record.
+			/// Two rectangles are merged if their bounds contain no more than \a mergeThreshold pixels that weren't packed,
+			/// i.e. \a mergeThreshold is the number of wasted pixels worth trading for one less upload.
+			std::vector<Rect> FlushDirtyRegions(unsigned int mergeThreshold);
 		private:
+			/// \brief Removes \a clip from the empty regions, splitting and merging the regions it intersects.
+			/// Regions that are removed or inserted are appended to \a removedRegions and \a insertedRegions if they aren't null.
+			void ClipEmptyRegions(Rect clip, std::vector<Rect>* removedRegions = nullptr, std::vector<Rect>* insertedRegions = nullptr);
+			/// \brief Adds \a region to the empty regions, merging it with regions of the same width or height that it touches.
+			void InsertEmptyRegion(Rect region);
+
 			Area dimensions = {0, 0};
 			std::vector<Rect> emptyRegions;
+			unsigned long long revision = 0;
+			std::vector<Rect> emptyRegionsToInsert;	// Scratch space reused between clips
+			bool trackDirtyRegions = false;
+			std::vector<Rect> dirtyRegions;
 	};
 }
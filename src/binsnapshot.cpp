@@ -0,0 +1,93 @@
+#include "binsnapshot.h"
+#include <algorithm>
+#include <limits>
+
+using namespace BinPacker;
+
+SnapshotPublisher::Reader::Reader(SnapshotPublisher & publisher)
+	: publisher(publisher), slot(nullptr) {
+	for (unsigned int i = 0; i < publisher.maxReaders; i++) {
+		bool inUse = false;
+		if (publisher.readerSlotsInUse[i].compare_exchange_strong(inUse, true)) {
+			slot = &publisher.readerEpochs[i];
+			break;
+		}
+	}
+}
+
+SnapshotPublisher::Reader::~Reader() {
+	if (slot != nullptr) {
+		slot->store(0);
+		publisher.readerSlotsInUse[slot - publisher.readerEpochs.get()].store(false);
+	}
+}
+
+const BinSnapshot* SnapshotPublisher::Reader::Lock() {
+	if (slot == nullptr)
+		return nullptr;
+
+	// Announce the epoch before loading the pointer so the writer can't reclaim the snapshot while it is in use
+	slot->store(publisher.epoch.load());
+	const BinSnapshot* snapshot = publisher.current.load();
+
+	if (!publisher.requested.exchange(true) && publisher.requestHandler)
+		publisher.requestHandler();
+	return snapshot;
+}
+
+void SnapshotPublisher::Reader::Unlock() {
+	if (slot != nullptr)
+		slot->store(0);
+}
+
+SnapshotPublisher::SnapshotPublisher(unsigned int maxReaders)
+	: current(nullptr), requested(true), epoch(1), maxReaders(maxReaders),
+	readerEpochs(new std::atomic<unsigned long long>[maxReaders]), readerSlotsInUse(new std::atomic<bool>[maxReaders]) {
+	for (unsigned int i = 0; i < maxReaders; i++) {
+		readerEpochs[i].store(0);
+		readerSlotsInUse[i].store(false);
+	}
+}
+
+SnapshotPublisher::~SnapshotPublisher() {
+	delete current.load();
+	for (const RetiredSnapshot & r : retired)
+		delete r.snapshot;
+}
+
+void SnapshotPublisher::SetRequestHandler(std::function<void()> handler) {
+	requestHandler = std::move(handler);
+}
+
+void SnapshotPublisher::Publish(const Bin & bin) {
+	// Cheap check for the common case of nobody having asked for a snapshot
+	if (!requested.load(std::memory_order_relaxed) || !requested.exchange(false))
+		return;
+
+	const BinSnapshot* published = current.load();
+	if (published != nullptr && published->revision == bin.GetRevision())
+		return;
+
+	BinSnapshot* snapshot = new BinSnapshot{bin.GetRevision(), bin.GetDimensions(), bin.GetEmptyRegions()};
+	BinSnapshot* replaced = current.exchange(snapshot);
+	if (replaced != nullptr)
+		retired.push_back(RetiredSnapshot{replaced, epoch.fetch_add(1)});
+	Reclaim();
+}
+
+void SnapshotPublisher::Reclaim() {
+	// Readers that announced an epoch later than a snapshot's retirement loaded the pointer after it was replaced
+	unsigned long long oldestReader = std::numeric_limits<unsigned long long>::max();
+	for (unsigned int i = 0; i < maxReaders; i++) {
+		const unsigned long long readerEpoch = readerEpochs[i].load();
+		if (readerEpoch != 0)
+			oldestReader = std::min(oldestReader, readerEpoch);
+	}
+
+	retired.erase(std::remove_if(retired.begin(), retired.end(), [oldestReader](const RetiredSnapshot & r) {
+		if (r.epoch >= oldestReader)
+			return false;
+		delete r.snapshot;
+		return true;
+	}), retired.end());
+}
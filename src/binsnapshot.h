@@ -0,0 +1,84 @@
+// Lock-free snapshots of the state of a Bin for concurrent readers.
+// The thread that modifies a bin publishes immutable copies of its state by swapping an atomic
+// pointer, and readers access the latest copy without ever blocking the writer. Copies are only
+// made when a reader has asked for one since the last publish, so a writer without readers pays
+// for a single atomic load. Replaced copies are reclaimed once no reader can still be using
+// them, which readers announce by recording the epoch in which they began reading.
+
+#pragma once
+#include "binpacker.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+
+namespace BinPacker
+{
+	/// \brief Immutable copy of the state of a \see Bin.
+	struct BinSnapshot {
+		unsigned long long revision;
+		Area dimensions;
+		std::vector<Rect> emptyRegions;
+	};
+
+	/// \brief Publishes \see BinSnapshot objects from the thread modifying a bin to any number of reading threads.
+	class SnapshotPublisher {
+		public:
+			/// \brief Reader of published snapshots, used by one thread at a time.
+			class Reader {
+				public:
+					/// \brief Registers a reader with \a publisher. At most as many readers as the publisher was created with may exist at once.
+					explicit Reader(SnapshotPublisher& publisher);
+					~Reader();
+
+					Reader(const Reader&) = delete;
+					Reader& operator=(const Reader&) = delete;
+
+					/// \brief Returns the latest published snapshot and requests a newer one if the bin has since changed.
+					/// The snapshot remains valid until \see Unlock is called. Never waits for the writer or other readers, but a
+					/// request calls the request handler on this thread, which blocks if the handler does. PackService's handler
+					/// briefly locks a mutex to wake its packer thread when the packer is asleep.
+					/// \return The latest snapshot, or null if none has been published yet or the publisher had no free reader slots.
+					const BinSnapshot* Lock();
+					/// \brief Releases the snapshot returned by \see Lock.
+					void Unlock();
+				private:
+					SnapshotPublisher& publisher;
+					std::atomic<unsigned long long>* slot;
+			};
+
+			/// \brief Creates a publisher for up to \a maxReaders concurrent readers.
+			explicit SnapshotPublisher(unsigned int maxReaders = 64);
+			/// \brief Frees every snapshot. All readers must have been destroyed.
+			~SnapshotPublisher();
+
+			SnapshotPublisher(const SnapshotPublisher&) = delete;
+			SnapshotPublisher& operator=(const SnapshotPublisher&) = delete;
+
+			/// \brief Publishes a snapshot of \a bin if one has been requested and the bin has changed since the last snapshot.
+			/// Must only be called by the thread modifying \a bin.
+			void Publish(const Bin& bin);
+			/// \brief Sets a function called on a reader's thread when it requests a new snapshot, e.g. to wake the writer. Must be set before any readers exist.
+			/// It is called from \see Reader::Lock, so it should return quickly and avoid locks the writer holds for long.
+			void SetRequestHandler(std::function<void()> handler);
+		private:
+			struct RetiredSnapshot {
+				BinSnapshot* snapshot;
+				unsigned long long epoch;
+			};
+
+			void Reclaim();
+
+			std::atomic<BinSnapshot*> current;
+			std::atomic<bool> requested;
+			std::function<void()> requestHandler;
+
+			// Epoch in which each reader began reading, or 0 if the reader isn't reading
+			std::atomic<unsigned long long> epoch;
+			const unsigned int maxReaders;
+			std::unique_ptr<std::atomic<unsigned long long>[]> readerEpochs;
+			std::unique_ptr<std::atomic<bool>[]> readerSlotsInUse;
+
+			// Only accessed by the writer
+			std::vector<RetiredSnapshot> retired;
+	};
+}
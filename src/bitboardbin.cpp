@@ -0,0 +1,229 @@
+#include "bitboardbin.h"
+#include <algorithm>
+#include <bitset>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace BinPacker;
+
+// Returns the index of the lowest set bit of a non-zero value
+static unsigned int CountTrailingZeros(std::uint64_t value) {
+#if defined(_MSC_VER) && defined(_WIN64)
+	unsigned long index;
+	_BitScanForward64(&index, value);
+	return index;
+#elif defined(__GNUC__) || defined(__clang__)
+	return (unsigned int)__builtin_ctzll(value);
+#else
+	unsigned int index = 0;
+	while ((value & 1) == 0) {
+		value >>= 1;
+		index++;
+	}
+	return index;
+#endif
+}
+
+static unsigned int CountBits(std::uint64_t value) {
+	return (unsigned int)std::bitset<64>(value).count();
+}
+
+// Clears every bit of words that isn't set shift bits higher up in the row as well
+static void AndShiftedRight(std::vector<std::uint64_t>& words, unsigned int shift) {
+	const std::size_t wordShift = shift / 64;
+	const unsigned int bitShift = shift % 64;
+	for (std::size_t i = 0; i < words.size(); i++) {
+		const std::uint64_t low = i + wordShift < words.size() ? words[i + wordShift] : 0;
+		const std::uint64_t high = i + wordShift + 1 < words.size() ? words[i + wordShift + 1] : 0;
+		words[i] &= bitShift == 0 ? low : (low >> bitShift) | (high << (64 - bitShift));
+	}
+}
+
+// Calls onRun with the first and last column of each run of set bits in a row, from left to right
+template<typename F>
+static void ForEachRun(const std::uint64_t* row, std::size_t stride, unsigned int columns, F onRun) {
+	bool inRun = false;
+	unsigned int runStart = 0;
+	for (std::size_t i = 0; i < stride; i++) {
+		// Alternate between looking for the next set bit and the next clear bit
+		unsigned int bit = 0;
+		while (bit < 64) {
+			const std::uint64_t remaining = (inRun ? ~row[i] : row[i]) & (~0ull << bit);
+			if (remaining == 0)
+				break;
+			bit = CountTrailingZeros(remaining);
+			if (inRun)
+				onRun(runStart, (unsigned int)(i * 64 + bit - 1));
+			else
+				runStart = (unsigned int)(i * 64 + bit);
+			inRun = !inRun;
+		}
+	}
+	if (inRun)
+		onRun(runStart, columns - 1);
+}
+
+BitboardBin::BitboardBin(Area dimensions, unsigned int cellSize)
+	: dimensions{0, 0}, cellSize(std::max(cellSize, 1u)) {
+	ExtendDimensions(dimensions);
+}
+
+Rect BitboardBin::TryPackArea(Area area, bool allowRotation) {
+	if (area.width == 0 || area.height == 0)
+		return Rect{1, 1, 0, 0};
+	const unsigned int width = area.width / cellSize + (area.width % cellSize != 0);
+	const unsigned int height = area.height / cellSize + (area.height % cellSize != 0);
+
+	unsigned int left, top;
+	bool found = FindPlacement(width, height, ~0u, left, top);
+	bool rotated = false;
+	if (allowRotation && width != height) {
+		// The rotated orientation only needs to be searched down to the row already found
+		unsigned int rotatedLeft, rotatedTop;
+		if (FindPlacement(height, width, found ? top : ~0u, rotatedLeft, rotatedTop) &&
+			(!found || rotatedTop < top || (rotatedTop == top && rotatedLeft < left))) {
+			left = rotatedLeft;
+			top = rotatedTop;
+			found = rotated = true;
+		}
+	}
+	if (!found)
+		return Rect{1, 1, 0, 0};
+
+	if (rotated)
+		SetCells(left, top, left + height - 1, top + width - 1, false);
+	else
+		SetCells(left, top, left + width - 1, top + height - 1, false);
+	const Area packed = rotated ? Area{area.height, area.width} : area;
+	return Rect{left * cellSize, top * cellSize, left * cellSize + packed.width - 1, top * cellSize + packed.height - 1};
+}
+
+void BitboardBin::Release(Rect rect) {
+	if (!rect.IsValid() || rect.right / cellSize >= columns || rect.bottom / cellSize >= rows)
+		return;
+	SetCells(rect.left / cellSize, rect.top / cellSize, rect.right / cellSize, rect.bottom / cellSize, true);
+}
+
+void BitboardBin::ExtendDimensions(Area extension) {
+	dimensions.width += extension.width;
+	dimensions.height += extension.height;
+
+	const unsigned int oldColumns = columns, oldRows = rows;
+	const std::size_t oldStride = stride;
+	columns = dimensions.width / cellSize;
+	rows = dimensions.height / cellSize;
+	stride = (columns + 63) / 64;
+	if (columns == oldColumns && rows == oldRows)
+		return;
+
+	// Copy the existing rows into the wider rows, then free the new cells
+	std::vector<std::uint64_t> cells(stride * rows, 0);
+	for (unsigned int r = 0; r < oldRows; r++)
+		std::copy(freeCells.begin() + r * oldStride, freeCells.begin() + (r + 1) * oldStride, cells.begin() + r * stride);
+	freeCells.swap(cells);
+	rowFreeCells.resize(rows, 0);
+	runs.resize(stride);
+
+	if (columns > oldColumns && oldRows > 0)
+		SetCells(oldColumns, 0, columns - 1, oldRows - 1, true);
+	if (rows > oldRows && columns > 0)
+		SetCells(0, oldRows, columns - 1, rows - 1, true);
+	emptyRegionsValid = false;
+}
+
+Area BitboardBin::GetDimensions() const {
+	return dimensions;
+}
+
+const std::vector<Rect>& BitboardBin::GetEmptyRegions() const {
+	if (emptyRegionsValid)
+		return emptyRegions;
+	emptyRegions.clear();
+
+	// Extend each rect down while the next row has a run of free cells with exactly the same columns
+	std::vector<Rect> open, next;
+	auto close = [this](const Rect & cells) {
+		emptyRegions.push_back(Rect{cells.left * cellSize, cells.top * cellSize, (cells.right + 1) * cellSize - 1, (cells.bottom + 1) * cellSize - 1});
+	};
+	for (unsigned int r = 0; r < rows; r++) {
+		std::size_t o = 0;
+		ForEachRun(&freeCells[r * stride], stride, columns, [&](unsigned int first, unsigned int last) {
+			while (o < open.size() && open[o].left < first)
+				close(open[o++]);
+			if (o < open.size() && open[o].left == first && open[o].right == last) {
+				next.push_back(open[o++]);
+				next.back().bottom = r;
+			} else {
+				next.push_back(Rect{first, r, last, r});
+			}
+		});
+		while (o < open.size())
+			close(open[o++]);
+		open.swap(next);
+		next.clear();
+	}
+	for (const Rect & cells : open)
+		close(cells);
+
+	emptyRegionsValid = true;
+	return emptyRegions;
+}
+
+bool BitboardBin::FindPlacement(unsigned int width, unsigned int height, unsigned int maxTop, unsigned int& left, unsigned int& top) {
+	if (width > columns || height > rows)
+		return false;
+
+	const unsigned int lastTop = std::min(rows - height, maxTop);
+	for (unsigned int y = 0; y <= lastTop; y++) {
+		// Skip past the lowest row that doesn't have enough free cells, as no placement can cover it
+		unsigned int full = rows;
+		for (unsigned int r = y + height; r-- > y;) {
+			if (rowFreeCells[r] < width) {
+				full = r;
+				break;
+			}
+		}
+		if (full != rows) {
+			y = full;
+			continue;
+		}
+
+		// Intersect the rows, then shift the intersection onto itself, doubling the length of the runs it tests until it reaches the width
+		std::copy(freeCells.begin() + y * stride, freeCells.begin() + (y + 1) * stride, runs.begin());
+		for (unsigned int r = y + 1; r < y + height; r++) {
+			const std::uint64_t* row = &freeCells[r * stride];
+			for (std::size_t i = 0; i < stride; i++)
+				runs[i] &= row[i];
+		}
+		for (unsigned int length = 1; length < width;) {
+			const unsigned int shift = std::min(length, width - length);
+			AndShiftedRight(runs, shift);
+			length += shift;
+		}
+
+		for (std::size_t i = 0; i < stride; i++) {
+			if (runs[i] != 0) {
+				left = (unsigned int)(i * 64 + CountTrailingZeros(runs[i]));
+				top = y;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void BitboardBin::SetCells(unsigned int left, unsigned int top, unsigned int right, unsigned int bottom, bool free) {
+	for (unsigned int r = top; r <= bottom; r++) {
+		for (std::size_t i = left / 64; i <= right / 64; i++) {
+			const unsigned int first = i == left / 64 ? left % 64 : 0;
+			const unsigned int last = i == right / 64 ? right % 64 : 63;
+			const std::uint64_t mask = (~0ull >> (63 - last)) & (~0ull << first);
+			std::uint64_t & word = freeCells[r * stride + i];
+			const std::uint64_t updated = free ? word | mask : word & ~mask;
+			rowFreeCells[r] = rowFreeCells[r] + CountBits(updated) - CountBits(word);
+			word = updated;
+		}
+	}
+	emptyRegionsValid = false;
+}
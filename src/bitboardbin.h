@@ -0,0 +1,59 @@
+// Bin that records its occupancy as a bitmap instead of a collection of empty regions.
+// The bin is divided into square cells of a configurable size, and each row of cells is stored
+// as 64-bit words with a bit set for every free cell. To find a place for an item, the rows it
+// would cover are intersected a word at a time, and the intersection is shifted onto itself so
+// that a bit remains set only where a run of free cells wide enough for the item begins. Pack
+// time depends on the size of the bin rather than on how fragmented it is, which suits bins of up
+// to a few thousand cells per side that are packed with many small items of varied sizes. Items
+// are rounded up to whole cells, so coarser cells pack faster at the cost of wasted space.
+
+#pragma once
+#include "binpacker.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace BinPacker
+{
+	/// \brief Bin that finds free space by searching an occupancy bitmap.
+	class BitboardBin {
+		public:
+			/// \brief Creates an empty bin of \a dimensions.
+			/// \param cellSize Side of each cell of the bitmap in pixels. Items occupy whole cells, and partial cells along the right and bottom edges are never used.
+			explicit BitboardBin(Area dimensions = {0, 0}, unsigned int cellSize = 1);
+
+			/// \brief Attempts to pack \a area at the topmost, then leftmost, free position that fits it.
+			/// \param allowRotation If true, \a area is rotated by 90 degrees when that places it higher or further left.
+			/// \return If successful, returns a \see Rect object of the location of the packed area, otherwise returns an invalid \see Rect object.
+			Rect TryPackArea(Area area, bool allowRotation = true);
+			/// \brief Frees the cells of \a rect, as returned by \see TryPackArea.
+			void Release(Rect rect);
+			/// \brief Increases the dimensions of the bin.
+			void ExtendDimensions(Area extension);
+
+			/// \brief Returns the dimensions of the bin, empty or not.
+			Area GetDimensions() const;
+			/// \brief Returns rects that together cover the free cells of the bin without overlapping.
+			/// Unlike the empty regions of a \see Bin they are not maximal, and they are only recomputed when the bin has changed.
+			const std::vector<Rect>& GetEmptyRegions() const;
+		private:
+			// Finds the topmost, then leftmost, run of free cells of the given size with a top no greater than maxTop
+			bool FindPlacement(unsigned int width, unsigned int height, unsigned int maxTop, unsigned int& left, unsigned int& top);
+			void SetCells(unsigned int left, unsigned int top, unsigned int right, unsigned int bottom, bool free);
+
+			Area dimensions;
+			unsigned int cellSize;
+			unsigned int columns = 0;
+			unsigned int rows = 0;
+			// Number of words per row of cells
+			std::size_t stride = 0;
+			// One bit per cell, set if the cell is free, with each row starting on a new word and unused bits clear
+			std::vector<std::uint64_t> freeCells;
+			// Number of free cells in each row, to skip rows that can't fit an item without searching them
+			std::vector<unsigned int> rowFreeCells;
+			// Scratch row for the intersection of the rows an item would cover
+			std::vector<std::uint64_t> runs;
+
+			mutable std::vector<Rect> emptyRegions;
+			mutable bool emptyRegionsValid = false;
+	};
+}
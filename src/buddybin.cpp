@@ -0,0 +1,166 @@
+#include "buddybin.h"
+#include <algorithm>
+
+using namespace BinPacker;
+
+// Rounds value up to the nearest power of two
+static unsigned int RoundUpToPowerOfTwo(unsigned int value) {
+	unsigned int power = 1;
+	while (power < value && power < 0x80000000u)
+		power <<= 1;
+	return power;
+}
+
+BuddyBin::BuddyBin(unsigned int size, unsigned int minBlockSize)
+	: minBlockSize(RoundUpToPowerOfTwo(std::max(minBlockSize, 1u))), depth(0) {
+	this->size = size > 0 ? RoundUpToPowerOfTwo(size / 2 + 1) : 0;
+	if (this->size < this->minBlockSize) {
+		this->size = 0;
+		return;
+	}
+
+	while ((this->minBlockSize << depth) < this->size)
+		depth++;
+	// The root starts out as a single free block, and is split as areas are packed
+	quads.push_back(Quad{{(unsigned char)(depth + 1), 0, 0, 0}, {0, 0, 0, 0}});
+}
+
+unsigned char BuddyBin::GetOrder(unsigned int side) const {
+	unsigned char order = 1;
+	for (unsigned int block = minBlockSize; block < side; block <<= 1)
+		order++;
+	return order;
+}
+
+Rect BuddyBin::TryPackArea(Area area) {
+	if (area.width == 0 || area.height == 0 || area.width > size || area.height > size)
+		return Rect{1, 1, 0, 0};
+	const unsigned char order = GetOrder(std::max(area.width, area.height));
+	if (quads.empty() || quads[0].largestFree[0] < order)
+		return Rect{1, 1, 0, 0};
+
+	// Descend into the child with the smallest free block that fits, which keeps larger blocks intact
+	Node path[33] = { Node{0, 0} };
+	unsigned int d = 0, left = 0, top = 0;
+	for (; depth - d + 1 > order; d++) {
+		const unsigned int half = size >> (d + 1);
+		unsigned int children = quads[path[d].quad].children[path[d].child];
+		if (children == 0)
+			children = Split(path[d], (unsigned char)(depth - d));
+		const Quad & quad = quads[children];
+		unsigned int best = 4;
+		for (unsigned int c = 0; c < 4; c++) {
+			const unsigned char free = quad.largestFree[c];
+			if (free >= order && (best == 4 || free < quad.largestFree[best]))
+				best = c;
+		}
+		path[d + 1] = Node{children, best};
+		left += (best & 1) * half;
+		top += (best >> 1) * half;
+	}
+
+	quads[path[d].quad].largestFree[path[d].child] = 0;
+	UpdateAncestors(path, d);
+	const unsigned long long side = size >> d;
+	allocatedArea += side * side;
+	usedArea += (unsigned long long)area.width * area.height;
+	return Rect{left, top, left + area.width - 1, top + area.height - 1};
+}
+
+void BuddyBin::Release(Rect rect) {
+	if (!rect.IsValid() || rect.right >= size || rect.bottom >= size)
+		return;
+	const Area area = { rect.right - rect.left + 1, rect.bottom - rect.top + 1 };
+	const unsigned char order = GetOrder(std::max(area.width, area.height));
+	if (order > depth + 1)
+		return;
+
+	// Follow the block's position down to its node, which was only allocated if every block above it is split
+	Node path[33] = { Node{0, 0} };
+	unsigned int d = 0;
+	for (; depth - d + 1 > order; d++) {
+		const unsigned int half = size >> (d + 1);
+		const unsigned int children = quads[path[d].quad].children[path[d].child];
+		if (children == 0)
+			return;
+		path[d + 1] = Node{children, ((rect.left & half) ? 1u : 0u) + ((rect.top & half) ? 2u : 0u)};
+	}
+	const Node node = path[d];
+	if (quads[node.quad].largestFree[node.child] != 0 || quads[node.quad].children[node.child] != 0)
+		return;
+
+	quads[node.quad].largestFree[node.child] = order;
+	UpdateAncestors(path, d);
+	const unsigned long long side = size >> d;
+	allocatedArea -= side * side;
+	usedArea -= (unsigned long long)area.width * area.height;
+}
+
+// Splits the entirely free block of node into four free children, returning the index of their quad
+unsigned int BuddyBin::Split(Node node, unsigned char childOrder) {
+	unsigned int index;
+	if (!freeQuads.empty()) {
+		index = freeQuads.back();
+		freeQuads.pop_back();
+	} else {
+		index = (unsigned int)quads.size();
+		quads.emplace_back();
+	}
+	quads[index] = Quad{{childOrder, childOrder, childOrder, childOrder}, {0, 0, 0, 0}};
+	quads[node.quad].children[node.child] = index;
+	return index;
+}
+
+void BuddyBin::UpdateAncestors(const Node* path, unsigned int d) {
+	// A parent whose four children are entirely free becomes a single free block, and the quad of its children is reused
+	for (; d > 0; d--) {
+		const unsigned int index = path[d].quad;
+		const unsigned char* children = quads[index].largestFree;
+		const unsigned char childOrder = (unsigned char)(depth - d + 1);
+		Quad & parent = quads[path[d - 1].quad];
+		const unsigned int child = path[d - 1].child;
+		unsigned char free;
+		if (children[0] == childOrder && children[1] == childOrder && children[2] == childOrder && children[3] == childOrder) {
+			free = childOrder + 1;
+			parent.children[child] = 0;
+			freeQuads.push_back(index);
+		} else {
+			free = std::max({children[0], children[1], children[2], children[3]});
+		}
+		if (parent.largestFree[child] == free)
+			break;
+		parent.largestFree[child] = free;
+	}
+}
+
+Area BuddyBin::GetDimensions() const {
+	return Area{size, size};
+}
+
+std::vector<Rect> BuddyBin::GetEmptyRegions() const {
+	std::vector<Rect> regions;
+	if (quads.empty())
+		return regions;
+
+	// Depth-first search for nodes that are entirely free
+	struct Block { Node node; unsigned int depth, left, top; };
+	std::vector<Block> stack = { Block{Node{0, 0}, 0, 0, 0} };
+	while (!stack.empty()) {
+		const Block b = stack.back();
+		stack.pop_back();
+		const unsigned int side = size >> b.depth;
+		const unsigned char free = quads[b.node.quad].largestFree[b.node.child];
+		const unsigned int children = quads[b.node.quad].children[b.node.child];
+		if (free == depth - b.depth + 1) {
+			regions.push_back(Rect{b.left, b.top, b.left + side - 1, b.top + side - 1});
+		} else if (free > 0 && children != 0) {
+			for (unsigned int c = 4; c-- > 0;)
+				stack.push_back(Block{Node{children, c}, b.depth + 1, b.left + (c & 1) * side / 2, b.top + (c >> 1) * side / 2});
+		}
+	}
+	return regions;
+}
+
+double BuddyBin::GetInternalFragmentation() const {
+	return allocatedArea > 0 ? 1.0 - (double)usedArea / allocatedArea : 0.0;
+}
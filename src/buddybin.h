@@ -0,0 +1,64 @@
+// Buddy allocator for bins that only hold power-of-two squares.
+// The bin is a square whose side is a power of two, recursively split into four quadrants down to a
+// minimum block size. Each node of this quadtree records the largest free block within it, so an
+// allocation descends from the root to the best fitting free block in O(log n), and a release walks
+// back up, merging four free quadrants back into their parent. Items are rounded up to the next
+// power-of-two block, which wastes space for other sizes, reported as internal fragmentation.
+// Blocks are only split when an allocation needs a smaller block, so the memory used grows with the
+// number of split blocks rather than with the size of the bin: 20 bytes for each split block. A pack
+// splits at most one block per level, and a bin full of minimum blocks has a split block for every
+// three of them, so a 16384 bin of 1x1 blocks starts out at a few bytes rather than 358MB.
+
+#pragma once
+#include "binpacker.h"
+#include <cstddef>
+
+namespace BinPacker
+{
+	/// \brief Bin that packs areas into power-of-two square blocks.
+	class BuddyBin {
+		public:
+			/// \brief Creates a square bin whose side is \a size rounded down to a power of two.
+			/// \param minBlockSize Side of the smallest block, rounded up to a power of two. Smaller areas are packed into a block of this size.
+			explicit BuddyBin(unsigned int size, unsigned int minBlockSize = 1);
+
+			/// \brief Attempts to pack \a area into the smallest free block that fits it.
+			/// \return If successful, returns a \see Rect object of the location of the packed area, otherwise returns an invalid \see Rect object.
+			Rect TryPackArea(Area area);
+			/// \brief Frees the block of \a rect, as returned by \see TryPackArea.
+			void Release(Rect rect);
+
+			/// \brief Returns the dimensions of the bin, empty or not.
+			Area GetDimensions() const;
+			/// \brief Returns the free blocks of the bin.
+			std::vector<Rect> GetEmptyRegions() const;
+			/// \brief Returns the fraction of the area of allocated blocks that isn't covered by the packed areas.
+			double GetInternalFragmentation() const;
+		private:
+			// The four children of a split block, in the order top left, top right, bottom left, bottom right
+			struct Quad {
+				// Order of the largest free block within each child, or 0 if none
+				unsigned char largestFree[4];
+				// Index of the quad that splits each child, or 0 if the child isn't split
+				unsigned int children[4];
+			};
+			// Child of a quad, with the root as the first child of quad 0
+			struct Node {
+				unsigned int quad, child;
+			};
+
+			// Order of a block of the given side: 1 for the minimum block size, increasing by one each time the side doubles
+			unsigned char GetOrder(unsigned int side) const;
+			unsigned int Split(Node node, unsigned char childOrder);
+			void UpdateAncestors(const Node* path, unsigned int depth);
+
+			unsigned int size;
+			unsigned int minBlockSize;
+			unsigned int depth;
+			std::vector<Quad> quads;
+			// Quads of blocks that were merged again, reused by the next split
+			std::vector<unsigned int> freeQuads;
+			unsigned long long usedArea = 0;
+			unsigned long long allocatedArea = 0;
+	};
+}
@@ -0,0 +1,182 @@
+#include "bulkpacker.h"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+
+using namespace BinPacker;
+
+// Packs area, doubling the dimensions of the bin without exceeding the maximum until it fits
+static Rect PackGrowing(Bin& bin, Area area, const PackSettings& settings) {
+	using namespace std;
+
+	Rect packed = bin.TryPackArea(area, settings.constraints);
+	while (!packed.IsValid()) {
+		const Area dimensions = bin.GetDimensions();
+		const Area extension = {
+			min(max(dimensions.width, 1u), settings.maxDimensions.width - min(dimensions.width, settings.maxDimensions.width)),
+			min(max(dimensions.height, 1u), settings.maxDimensions.height - min(dimensions.height, settings.maxDimensions.height))
+		};
+		if (extension.width == 0 && extension.height == 0)
+			break;
+		bin.ExtendDimensions(extension);
+		packed = bin.TryPackArea(area, settings.constraints);
+	}
+	return packed;
+}
+
+PackResult BinPacker::PackItems(const std::vector<Area>& items, const PackSettings& settings) {
+	using namespace std;
+
+	Bin bin;
+	bin.ExtendDimensions({ min(settings.initialDimensions.width, settings.maxDimensions.width), min(settings.initialDimensions.height, settings.maxDimensions.height) });
+
+	PackResult result;
+	result.placements.reserve(items.size());
+	for (const Area & item : items)
+		result.placements.push_back(PackGrowing(bin, item, settings));
+
+	result.dimensions = bin.GetDimensions();
+	result.emptyRegions = bin.GetEmptyRegions();
+	return result;
+}
+
+static bool HasDuplicates(std::vector<unsigned long long> ids) {
+	std::sort(ids.begin(), ids.end());
+	return std::adjacent_find(ids.cbegin(), ids.cend()) != ids.cend();
+}
+
+PackResult BinPacker::UpdateItems(const PackResult& previous, const std::vector<unsigned long long>& previousIds,
+	const std::vector<unsigned long long>& ids, const std::vector<Area>& items, const PackSettings& settings, double minFill, bool* repacked) {
+	using namespace std;
+
+	auto repack = [&]() {
+		if (repacked != nullptr)
+			*repacked = true;
+		return PackItems(items, settings);
+	};
+	if (repacked != nullptr)
+		*repacked = false;
+	if (ids.size() != items.size() || previousIds.size() != previous.placements.size() || HasDuplicates(ids) || HasDuplicates(previousIds))
+		return PackResult{{0, 0}, {}, {}};
+
+	map<unsigned long long, Rect> placed;
+	for (size_t i = 0; i < previousIds.size(); i++) {
+		if (previous.placements[i].IsValid())
+			placed.emplace(previousIds[i], previous.placements[i]);
+	}
+
+	// Items keep their placement if they still exist at the same size (in either orientation)
+	PackResult result;
+	result.placements.assign(items.size(), Rect{1, 1, 0, 0});
+	map<unsigned long long, Rect> kept;
+	for (size_t i = 0; i < items.size(); i++) {
+		auto p = placed.find(ids[i]);
+		if (p == placed.end())
+			continue;
+		const Area size = { p->second.right - p->second.left + 1, p->second.bottom - p->second.top + 1 };
+		if ((size.width == items[i].width && size.height == items[i].height) || (size.width == items[i].height && size.height == items[i].width)) {
+			result.placements[i] = p->second;
+			kept.insert(*p);
+		}
+	}
+
+	Bin bin(previous.dimensions, previous.emptyRegions);
+	for (const auto & p : placed) {
+		if (kept.find(p.first) == kept.end())
+			bin.Release(p.second, settings.constraints);
+	}
+
+	unsigned long long usedArea = 0;
+	for (size_t i = 0; i < items.size(); i++) {
+		if (!result.placements[i].IsValid()) {
+			result.placements[i] = PackGrowing(bin, items[i], settings);
+			if (!result.placements[i].IsValid())
+				return repack();
+		}
+		usedArea += (unsigned long long)items[i].width * items[i].height;
+	}
+
+	const Area dimensions = bin.GetDimensions();
+	if ((double)usedArea < minFill * ((double)dimensions.width * dimensions.height))
+		return repack();
+
+	result.dimensions = dimensions;
+	result.emptyRegions = bin.GetEmptyRegions();
+	return result;
+}
+
+// Estimates the relative cost of packing items. Pack time grows with the number of empty regions,
+// which grows with the number of items packed and with the variation in their sizes.
+static double EstimatePackCost(const std::vector<Area>& items) {
+	if (items.empty())
+		return 0;
+
+	unsigned int minSide = ~0u, maxSide = 0;
+	for (const Area & item : items) {
+		minSide = std::min({minSide, item.width, item.height});
+		maxSide = std::max({maxSide, item.width, item.height});
+	}
+	const double spread = 1 + std::log2((double)std::max(maxSide, 1u) / std::max(minSide, 1u) + 1);
+	return (double)items.size() * items.size() * spread;
+}
+
+std::vector<PackResult> BinPacker::PackBins(const std::vector<std::vector<Area>>& itemLists, const PackSettings& settings, unsigned int threadCount) {
+	using namespace std;
+
+	if (threadCount == 0)
+		threadCount = max(thread::hardware_concurrency(), 1u);
+	threadCount = (unsigned int)min<size_t>(threadCount, max<size_t>(itemLists.size(), 1));
+
+	// Deal lists out round-robin from most to least expensive so each queue starts with its largest list
+	vector<double> costs(itemLists.size());
+	vector<size_t> order(itemLists.size());
+	for (size_t i = 0; i < itemLists.size(); i++) {
+		costs[i] = EstimatePackCost(itemLists[i]);
+		order[i] = i;
+	}
+	stable_sort(order.begin(), order.end(), [&costs](size_t a, size_t b){ return costs[a] > costs[b]; });
+
+	struct Queue {
+		mutex queueMutex;
+		deque<size_t> lists;
+	};
+	vector<Queue> queues(threadCount);
+	for (size_t i = 0; i < order.size(); i++)
+		queues[i % threadCount].lists.push_back(order[i]);
+
+	vector<PackResult> results(itemLists.size());
+	auto work = [&](unsigned int self) {
+		while (true) {
+			// Take the most expensive list from our own queue, otherwise steal the cheapest from another
+			size_t list = itemLists.size();
+			for (unsigned int offset = 0; offset < threadCount && list == itemLists.size(); offset++) {
+				Queue & queue = queues[(self + offset) % threadCount];
+				lock_guard<mutex> lock(queue.queueMutex);
+				if (!queue.lists.empty()) {
+					if (offset == 0) {
+						list = queue.lists.front();
+						queue.lists.pop_front();
+					} else {
+						list = queue.lists.back();
+						queue.lists.pop_back();
+					}
+				}
+			}
+			if (list == itemLists.size())
+				return;
+			results[list] = PackItems(itemLists[list], settings);
+		}
+	};
+
+	vector<thread> threads;
+	for (unsigned int t = 1; t < threadCount; t++)
+		threads.emplace_back(work, t);
+	work(0);
+	for (thread & t : threads)
+		t.join();
+
+	return results;
+}
@@ -0,0 +1,54 @@
+// Packing of item lists into bins that grow as needed, and bulk packing of many independent
+// lists in parallel. Each list is packed into its own Bin by PackItems, which doubles the bin's
+// dimensions whenever an item doesn't fit, like the font atlas example in the README.
+// PackBins estimates the cost of each list from its item count and size spread, deals the lists
+// out to per-thread queues largest first, and lets threads that run out of work steal from the
+// others, so every core stays busy until the last bin is finished. UpdateItems patches an existing
+// layout when only a few items were added or removed, which keeps every other item in place.
+
+#pragma once
+#include "binpacker.h"
+
+namespace BinPacker
+{
+	/// \brief Settings for packing a list of items into a growing bin.
+	struct PackSettings {
+		/// \brief Dimensions of the bin before any items are packed.
+		Area initialDimensions = {128, 128};
+		/// \brief The bin doubles in size when an item doesn't fit until it would exceed these dimensions.
+		Area maxDimensions = {16384, 16384};
+		PackConstraints constraints;
+	};
+
+	/// \brief Result of packing a list of items.
+	struct PackResult {
+		/// \brief Final dimensions of the bin.
+		Area dimensions;
+		/// \brief Location of each item in the order given, or an invalid \see Rect if the item didn't fit within the maximum dimensions.
+		std::vector<Rect> placements;
+		/// \brief Empty regions of the bin after packing every item.
+		std::vector<Rect> emptyRegions;
+	};
+
+	/// \brief Packs \a items in order into a bin that grows as described by \a settings.
+	PackResult PackItems(const std::vector<Area>& items, const PackSettings& settings = PackSettings());
+
+	/// \brief Updates a layout previously returned by \see PackItems or \see UpdateItems for a changed set of items.
+	/// Items that were removed or changed size are released, items that were added or changed size are packed into the
+	/// free space in order, and every other item keeps its placement. Falls back to packing every item from scratch if an
+	/// item doesn't fit within the maximum dimensions or the fraction of the bin covered by items drops below \a minFill.
+	/// \param previousIds Unique id of each item of the previous layout, in the order of its placements.
+	/// \param ids Unique id of each of \a items.
+	/// \param settings The settings the previous layout was packed with.
+	/// \param repacked If not null, set to true if every item was packed from scratch.
+	/// \return The updated layout, or a result of no dimensions and no placements if \a ids and \a items differ in size,
+	/// \a previousIds and the previous placements differ in size, or either list of ids contains an id more than once.
+	PackResult UpdateItems(const PackResult& previous, const std::vector<unsigned long long>& previousIds,
+		const std::vector<unsigned long long>& ids, const std::vector<Area>& items, const PackSettings& settings = PackSettings(),
+		double minFill = 0.25, bool* repacked = nullptr);
+
+	/// \brief Packs each list of items into its own bin on a work-stealing thread pool.
+	/// \param threadCount The number of threads to pack on, including the calling thread, or 0 for one per hardware thread.
+	/// \return The result of packing each list, in the order given.
+	std::vector<PackResult> PackBins(const std::vector<std::vector<Area>>& itemLists, const PackSettings& settings = PackSettings(), unsigned int threadCount = 0);
+}
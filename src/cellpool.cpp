@@ -0,0 +1,122 @@
+#include "cellpool.h"
+#include <algorithm>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace BinPacker;
+
+// Returns the index of the lowest set bit of a non-zero value
+static unsigned int CountTrailingZeros(std::uint64_t value) {
+#if defined(_MSC_VER) && defined(_WIN64)
+	unsigned long index;
+	_BitScanForward64(&index, value);
+	return index;
+#elif defined(__GNUC__) || defined(__clang__)
+	return (unsigned int)__builtin_ctzll(value);
+#else
+	unsigned int index = 0;
+	while ((value & 1) == 0) {
+		value >>= 1;
+		index++;
+	}
+	return index;
+#endif
+}
+
+static std::uint64_t GetPositionKey(unsigned int left, unsigned int top) {
+	return ((std::uint64_t)top << 32) | left;
+}
+
+CellPool::CellPool(Bin& bin, Area cellSize, Area stripCells, const PackConstraints& stripConstraints)
+	: bin(bin), cellSize(cellSize),
+	stripCells{ std::min(std::max(stripCells.width, 1u), 64u), std::min(std::max(stripCells.height, 1u), 64u / std::min(std::max(stripCells.width, 1u), 64u)) },
+	fullStrip(this->stripCells.width * this->stripCells.height == 64 ? ~0ull : (1ull << (this->stripCells.width * this->stripCells.height)) - 1),
+	stripConstraints(stripConstraints) {
+	// Strips aren't rotated so that every cell has the same orientation
+	this->stripConstraints.allowRotation = false;
+}
+
+unsigned int CellPool::Allocate() {
+	// Find the first strip with a free cell, claiming a new strip if there is none
+	while (firstSummary < summary.size() && summary[firstSummary] == 0)
+		firstSummary++;
+	if (firstSummary == summary.size() && !ClaimStrip())
+		return invalidCell;
+
+	const unsigned int strip = firstSummary * 64 + CountTrailingZeros(summary[firstSummary]);
+	std::uint64_t & cells = freeCells[strip];
+	const unsigned int cell = CountTrailingZeros(cells);
+	cells &= cells - 1;
+	if (cells == 0)
+		summary[strip / 64] &= ~(1ull << (strip % 64));
+	freeCount--;
+	return strip * 64 + cell;
+}
+
+Rect CellPool::TryPackArea() {
+	const unsigned int cell = Allocate();
+	return cell != invalidCell ? GetCell(cell) : Rect{1, 1, 0, 0};
+}
+
+void CellPool::Free(unsigned int cell) {
+	const unsigned int strip = cell / 64;
+	const std::uint64_t bit = 1ull << (cell % 64);
+	if (strip >= strips.size() || (fullStrip & bit) == 0 || (freeCells[strip] & bit) != 0)
+		return;
+
+	freeCells[strip] |= bit;
+	summary[strip / 64] |= 1ull << (strip % 64);
+	firstSummary = std::min(firstSummary, strip / 64);
+	freeCount++;
+}
+
+void CellPool::Free(Rect rect) {
+	Free(GetCellIndex(rect));
+}
+
+Rect CellPool::GetCell(unsigned int cell) const {
+	const unsigned int strip = cell / 64;
+	if (strip >= strips.size() || cell % 64 >= stripCells.width * stripCells.height)
+		return Rect{1, 1, 0, 0};
+
+	const unsigned int left = strips[strip].left + (cell % 64) % stripCells.width * cellSize.width;
+	const unsigned int top = strips[strip].top + (cell % 64) / stripCells.width * cellSize.height;
+	return Rect{left, top, left + cellSize.width - 1, top + cellSize.height - 1};
+}
+
+unsigned int CellPool::GetCellIndex(Rect rect) const {
+	const auto cell = cellsByPosition.find(GetPositionKey(rect.left, rect.top));
+	return cell != cellsByPosition.end() ? cell->second : invalidCell;
+}
+
+unsigned int CellPool::GetCapacity() const {
+	return (unsigned int)strips.size() * stripCells.width * stripCells.height;
+}
+
+unsigned int CellPool::GetFreeCells() const {
+	return freeCount;
+}
+
+bool CellPool::ClaimStrip() {
+	if (cellSize.width == 0 || cellSize.height == 0)
+		return false;
+
+	const Rect strip = bin.TryPackArea({ stripCells.width * cellSize.width, stripCells.height * cellSize.height }, stripConstraints);
+	if (!strip.IsValid())
+		return false;
+
+	const unsigned int index = (unsigned int)strips.size();
+	strips.push_back(strip);
+	for (unsigned int cell = 0; cell < stripCells.width * stripCells.height; cell++) {
+		const Rect r = GetCell(index * 64 + cell);
+		cellsByPosition.emplace(GetPositionKey(r.left, r.top), index * 64 + cell);
+	}
+	freeCells.push_back(fullStrip);
+	if (index % 64 == 0)
+		summary.push_back(0);
+	summary[index / 64] |= 1ull << (index % 64);
+	firstSummary = std::min(firstSummary, index / 64);
+	freeCount += stripCells.width * stripCells.height;
+	return true;
+}
@@ -0,0 +1,63 @@
+// Pool of uniformly sized cells for atlases of identical items, such as emoji or icons.
+// Cells are grouped into strips of up to 64 cells that are packed into a Bin as they are needed.
+// Each strip has a 64-bit word with a bit set for each free cell, and a summary level has a bit set
+// for each strip with any free cell, so allocating finds the first free cell with two
+// count-trailing-zeros instructions and freeing sets two bits. Cells can also be freed by position,
+// which is looked up in a hash map of every cell.
+
+#pragma once
+#include "binpacker.h"
+#include <cstdint>
+#include <unordered_map>
+
+namespace BinPacker
+{
+	/// \brief Allocator of fixed size cells within strips packed into a \see Bin.
+	class CellPool {
+		public:
+			/// \brief Returned by \see Allocate when no cell could be allocated.
+			static const unsigned int invalidCell = ~0u;
+
+			/// \brief Creates a pool of cells of \a cellSize that claims strips from \a bin, which must outlive the pool.
+			/// \param stripCells The number of columns and rows of cells in each strip, at most 64 cells in total.
+			/// \param stripConstraints Constraints that strips are packed into the bin with. Strips are never rotated.
+			CellPool(Bin& bin, Area cellSize, Area stripCells = {8, 8}, const PackConstraints& stripConstraints = PackConstraints());
+
+			/// \brief Allocates the first free cell, claiming a new strip from the bin if every cell is in use.
+			/// \return The index of the cell, or \see invalidCell if no strip could be packed into the bin.
+			unsigned int Allocate();
+			/// \brief Allocates a cell and returns its location, or an invalid \see Rect object if no cell could be allocated.
+			Rect TryPackArea();
+			/// \brief Frees the cell with index \a cell.
+			void Free(unsigned int cell);
+			/// \brief Frees the cell at \a rect, as returned by \see TryPackArea or \see GetCell.
+			void Free(Rect rect);
+
+			/// \brief Returns the location of the cell with index \a cell in the bin.
+			Rect GetCell(unsigned int cell) const;
+			/// \brief Returns the index of the cell at \a rect, or \see invalidCell if it isn't a cell of this pool.
+			unsigned int GetCellIndex(Rect rect) const;
+			/// \brief Returns the number of cells in every strip claimed from the bin.
+			unsigned int GetCapacity() const;
+			/// \brief Returns the number of free cells in every strip claimed from the bin.
+			unsigned int GetFreeCells() const;
+		private:
+			bool ClaimStrip();
+
+			Bin& bin;
+			const Area cellSize;
+			const Area stripCells;
+			const std::uint64_t fullStrip;
+			PackConstraints stripConstraints;
+
+			// Position of each strip in the bin, and the index of the cell at each position
+			std::vector<Rect> strips;
+			std::unordered_map<std::uint64_t, unsigned int> cellsByPosition;
+			// Bit c of freeCells[s] is set if cell c of strip s is free, and bit s % 64 of summary[s / 64] is set if any cell of strip s is free
+			std::vector<std::uint64_t> freeCells;
+			std::vector<std::uint64_t> summary;
+			// No summary words before this one have any bits set
+			unsigned int firstSummary = 0;
+			unsigned int freeCount = 0;
+	};
+}
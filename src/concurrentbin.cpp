@@ -0,0 +1,232 @@
+#include "concurrentbin.h"
+#include <algorithm>
+
+using namespace BinPacker;
+
+Rect GetReservedRect(Rect rect, Area dimensions, const PackConstraints & constraints);
+
+// Returns a bin with the columns right of width removed. The removed columns must be empty.
+static Bin ShrinkRight(const Bin & bin, unsigned int width) {
+	std::vector<Rect> regions;
+	for (Rect r : bin.GetEmptyRegions()) {
+		if (r.left < width) {
+			r.right = std::min(r.right, width - 1);
+			regions.push_back(r);
+		}
+	}
+	return Bin({width, bin.GetDimensions().height}, std::move(regions));
+}
+
+// Returns a bin with \a columns empty columns removed from its left edge.
+static Bin ShrinkLeft(const Bin & bin, unsigned int columns) {
+	std::vector<Rect> regions;
+	for (Rect r : bin.GetEmptyRegions()) {
+		if (r.right >= columns) {
+			r.left = std::max(r.left, columns) - columns;
+			r.right -= columns;
+			regions.push_back(r);
+		}
+	}
+	return Bin({bin.GetDimensions().width - columns, bin.GetDimensions().height}, std::move(regions));
+}
+
+// Returns a bin with \a columns empty columns added to its left edge.
+static Bin GrowLeft(const Bin & bin, unsigned int columns) {
+	const Area dimensions = bin.GetDimensions();
+	std::vector<Rect> regions;
+	bool spansHeight = false;
+	for (Rect r : bin.GetEmptyRegions()) {
+		// Regions along the left edge extend into the new columns
+		if (r.left > 0)
+			r.left += columns;
+		r.right += columns;
+		spansHeight = spansHeight || (r.left == 0 && r.top == 0 && r.bottom == dimensions.height - 1);
+		regions.push_back(r);
+	}
+	if (!spansHeight)
+		regions.push_back(Rect{0, 0, columns - 1, dimensions.height - 1});
+	return Bin({dimensions.width + columns, dimensions.height}, std::move(regions));
+}
+
+void ConcurrentBin::Partition::UpdateSummary() {
+	const Area dimensions = bin.GetDimensions();
+	unsigned int width = 0, height = 0;
+	for (const Rect & r : bin.GetEmptyRegions()) {
+		width = std::max(width, r.right - r.left + 1);
+		height = std::max(height, r.bottom - r.top + 1);
+	}
+	maxWidth.store(width);
+	maxHeight.store(height);
+	freeArea.store((unsigned long long)dimensions.width * dimensions.height - usedArea);
+}
+
+ConcurrentBin::ConcurrentBin(Area dimensions, unsigned int partitionCount, unsigned int boundaryAlignment)
+	: boundaryAlignment(std::max(boundaryAlignment, 1u)) {
+	partitionCount = std::max(1u, std::min(partitionCount, dimensions.width / this->boundaryAlignment));
+	unsigned int left = 0;
+	for (unsigned int i = 0; i < partitionCount; i++) {
+		const unsigned int right = i + 1 == partitionCount ? dimensions.width
+			: (unsigned int)((unsigned long long)dimensions.width * (i + 1) / partitionCount) / this->boundaryAlignment * this->boundaryAlignment;
+		std::unique_ptr<Partition> partition(new Partition());
+		partition->left = left;
+		partition->bin.ExtendDimensions({right - left, dimensions.height});
+		partition->UpdateSummary();
+		partitions.push_back(std::move(partition));
+		left = right;
+	}
+}
+
+Rect ConcurrentBin::TryPackPartition(Partition & partition, Area area, const PackConstraints & constraints) {
+	Rect packed = partition.bin.TryPackArea(area, constraints);
+	if (packed.IsValid()) {
+		// Count the space reserved for the item as used, including its padding and size alignment, as the bin does
+		const Rect reserved = GetReservedRect(packed, partition.bin.GetDimensions(), constraints);
+		partition.usedArea += (unsigned long long)(reserved.right - reserved.left + 1) * (reserved.bottom - reserved.top + 1);
+		partition.UpdateSummary();
+		packed.left += partition.left;
+		packed.right += partition.left;
+	}
+	return packed;
+}
+
+Rect ConcurrentBin::TryPackArea(Area area, const PackConstraints & constraints) {
+	static std::atomic<unsigned int> threadCount(0);
+	thread_local const unsigned int thread = threadCount++;
+
+	// Stripe edges are shared with neighbours, so padding can't be dropped along them
+	PackConstraints partitionConstraints = constraints;
+	if (partitions.size() > 1)
+		partitionConstraints.padBinEdges = true;
+
+	auto fits = [area](const Partition & p) {
+		const unsigned int width = p.maxWidth.load(), height = p.maxHeight.load();
+		return (width >= area.width && height >= area.height) || (width >= area.height && height >= area.width);
+	};
+
+	// Small items start at the thread's home stripe to avoid contention, large items at the emptiest stripe that can fit them
+	const int count = (int)partitions.size();
+	int start = (int)(thread % count);
+	const unsigned long long itemArea = (unsigned long long)area.width * area.height;
+	if (itemArea * 16 > partitions[start]->freeArea.load()) {
+		unsigned long long maxFreeArea = 0;
+		for (int i = 0; i < count; i++) {
+			if (fits(*partitions[i]) && partitions[i]->freeArea.load() > maxFreeArea) {
+				maxFreeArea = partitions[i]->freeArea.load();
+				start = i;
+			}
+		}
+	}
+
+	// Visit stripes outward from the starting stripe, first skipping stripes that are busy, then waiting for them
+	for (bool wait : {false, true}) {
+		for (int distance = 0; distance < count; distance++) {
+			for (int side = 0; side < (distance == 0 ? 1 : 2); side++) {
+				const int index = side == 0 ? start + distance : start - distance;
+				if (index < 0 || index >= count)
+					continue;
+				Partition & partition = *partitions[index];
+				if (!fits(partition))
+					continue;
+
+				std::unique_lock<std::mutex> lock(partition.mutex, std::defer_lock);
+				if (wait)
+					lock.lock();
+				else if (!lock.try_lock())
+					continue;
+				const Rect packed = TryPackPartition(partition, area, partitionConstraints);
+				if (packed.IsValid())
+					return packed;
+			}
+		}
+	}
+
+	return Rect{1, 1, 0, 0};
+}
+
+void ConcurrentBin::ExtendDimensions(Area extension) {
+	std::vector<std::unique_lock<std::mutex>> locks;
+	for (auto & partition : partitions)
+		locks.emplace_back(partition->mutex);
+
+	partitions.back()->bin.ExtendDimensions({extension.width, 0});
+	for (auto & partition : partitions) {
+		partition->bin.ExtendDimensions({0, extension.height});
+		partition->UpdateSummary();
+	}
+}
+
+void ConcurrentBin::Rebalance() {
+	for (size_t i = 0; i + 1 < partitions.size(); i++) {
+		Partition & left = *partitions[i];
+		Partition & right = *partitions[i + 1];
+		std::lock_guard<std::mutex> leftLock(left.mutex);
+		std::lock_guard<std::mutex> rightLock(right.mutex);
+
+		const Area leftDimensions = left.bin.GetDimensions();
+		const Area rightDimensions = right.bin.GetDimensions();
+		const unsigned int height = leftDimensions.height;
+		if (height == 0)
+			continue;
+		const unsigned long long leftFree = (unsigned long long)leftDimensions.width * height - left.usedArea;
+		const unsigned long long rightFree = (unsigned long long)rightDimensions.width * height - right.usedArea;
+		const bool giveRight = leftFree > rightFree;
+		const Bin & giver = giveRight ? left.bin : right.bin;
+		const unsigned int giverWidth = giveRight ? leftDimensions.width : rightDimensions.width;
+
+		// Only whole empty columns along the shared boundary can be moved
+		unsigned int emptyColumns = 0;
+		for (const Rect & r : giver.GetEmptyRegions()) {
+			if (r.top == 0 && r.bottom == height - 1 && (giveRight ? r.right == giverWidth - 1 : r.left == 0))
+				emptyColumns = std::max(emptyColumns, r.right - r.left + 1);
+		}
+		unsigned int columns = (unsigned int)(((giveRight ? leftFree - rightFree : rightFree - leftFree) / 2) / height);
+		columns = std::min({columns, emptyColumns, giverWidth - std::min(giverWidth, boundaryAlignment)});
+		columns = columns / boundaryAlignment * boundaryAlignment;
+		if (columns == 0)
+			continue;
+
+		if (giveRight) {
+			left.bin = ShrinkRight(left.bin, leftDimensions.width - columns);
+			right.bin = GrowLeft(right.bin, columns);
+			right.left -= columns;
+		} else {
+			right.bin = ShrinkLeft(right.bin, columns);
+			right.left += columns;
+			left.bin.ExtendDimensions({columns, 0});
+		}
+		left.UpdateSummary();
+		right.UpdateSummary();
+	}
+}
+
+Area ConcurrentBin::GetDimensions() const {
+	Area dimensions = {0, 0};
+	for (auto & partition : partitions) {
+		std::lock_guard<std::mutex> lock(partition->mutex);
+		dimensions.width += partition->bin.GetDimensions().width;
+		dimensions.height = partition->bin.GetDimensions().height;
+	}
+	return dimensions;
+}
+
+unsigned long long ConcurrentBin::GetUsedArea() const {
+	unsigned long long usedArea = 0;
+	for (auto & partition : partitions) {
+		std::lock_guard<std::mutex> lock(partition->mutex);
+		usedArea += partition->usedArea;
+	}
+	return usedArea;
+}
+
+std::vector<Rect> ConcurrentBin::GetEmptyRegions() const {
+	std::vector<Rect> regions;
+	for (auto & partition : partitions) {
+		std::lock_guard<std::mutex> lock(partition->mutex);
+		for (Rect r : partition->bin.GetEmptyRegions()) {
+			r.left += partition->left;
+			r.right += partition->left;
+			regions.push_back(r);
+		}
+	}
+	return regions;
+}
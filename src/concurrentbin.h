@@ -0,0 +1,57 @@
+// Thread-safe bin for concurrent inserts.
+// The bin is partitioned into vertical stripes, each with its own Bin and lock, so threads
+// packing into different stripes never contend. Each thread starts at its own home stripe and
+// falls back to neighbouring stripes when its home is busy or can't fit the item, while large
+// items are routed to the emptiest stripe that can fit them. Rebalance moves stripe boundaries
+// by handing empty columns from emptier stripes to fuller neighbours.
+
+#pragma once
+#include "binpacker.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace BinPacker
+{
+	/// \brief Bin partitioned into independently locked stripes.
+	class ConcurrentBin {
+		public:
+			/// \brief Creates a bin of \a dimensions split into \a partitionCount stripes of roughly equal width.
+			/// \param boundaryAlignment Stripe boundaries are kept at multiples of this value.
+			/// Position alignment constraints are only honoured in bin coordinates if they divide it.
+			ConcurrentBin(Area dimensions, unsigned int partitionCount, unsigned int boundaryAlignment = 16);
+
+			/// \brief Attempts to pack \a area into one of the stripes. Safe to call from any thread.
+			/// When there is more than one stripe, padding is reserved along every stripe edge regardless of \see PackConstraints::padBinEdges.
+			/// \return If successful, returns a \see Rect object of the location of the packed area in bin coordinates, otherwise returns an invalid \see Rect object.
+			Rect TryPackArea(Area area, const PackConstraints& constraints = PackConstraints());
+			/// \brief Increases the dimensions of the bin. Additional width is given to the rightmost stripe.
+			void ExtendDimensions(Area extension);
+			/// \brief Moves stripe boundaries to give empty columns of the emptier of each pair of neighbouring stripes to the fuller one.
+			void Rebalance();
+
+			/// \brief Returns the dimensions of the bin, empty or not.
+			Area GetDimensions() const;
+			/// \brief Returns the area reserved for packed items, including their padding and size alignment.
+			unsigned long long GetUsedArea() const;
+			/// \brief Returns a copy of the empty regions of every stripe in bin coordinates.
+			std::vector<Rect> GetEmptyRegions() const;
+		private:
+			struct Partition {
+				std::mutex mutex;
+				Bin bin;
+				unsigned int left;
+				unsigned long long usedArea = 0;
+				// Summary of the stripe read without locking to route inserts
+				std::atomic<unsigned int> maxWidth, maxHeight;
+				std::atomic<unsigned long long> freeArea;
+
+				void UpdateSummary();
+			};
+
+			Rect TryPackPartition(Partition& partition, Area area, const PackConstraints& constraints);
+
+			const unsigned int boundaryAlignment;
+			std::vector<std::unique_ptr<Partition>> partitions;
+	};
+}
@@ -0,0 +1,105 @@
+#include "coroutinebin.h"
+
+using namespace BinPacker;
+
+bool CoroutineBin::PackOperation::await_suspend(std::coroutine_handle<> handle) {
+	CoroutineBin& coroutineBin = bin;
+	{
+		std::lock_guard<std::mutex> lock(bin.binMutex);
+		// Areas that arrive during a growth wait for it rather than taking space the waiting areas were promised
+		if (!bin.growing) {
+			packed = bin.bin.TryPackArea(area, bin.constraints);
+			if (packed.IsValid())
+				return false;
+		}
+
+		bin.waiters.push_back(Waiter{area, &packed, handle});
+		if (bin.growing)
+			return true;
+		bin.growing = true;
+	}
+
+	// The coroutine may already have been resumed and destroyed by the growth completing, so this operation must not be touched again
+	coroutineBin.StartGrowth();
+	return true;
+}
+
+CoroutineBin::CoroutineBin(Bin bin, GrowthHandler growthHandler, PackConstraints constraints)
+	: bin(std::move(bin)), growthHandler(std::move(growthHandler)), constraints(constraints) {
+}
+
+CoroutineBin::PackOperation CoroutineBin::Pack(Area area) {
+	return PackOperation(*this, area);
+}
+
+void CoroutineBin::StartGrowth() {
+	// Every waiting area is passed, including those that arrived since the growth was requested, so that the handler can size one growth for all of them
+	Area dimensions;
+	std::vector<Area> pending;
+	{
+		std::lock_guard<std::mutex> lock(binMutex);
+		dimensions = bin.GetDimensions();
+		for (const Waiter & w : waiters)
+			pending.push_back(w.area);
+	}
+	if (growthHandler)
+		growthHandler(dimensions, pending, [this](Area extension){ CompleteGrowth(extension); });
+	else
+		CompleteGrowth({0, 0});
+}
+
+void CoroutineBin::CompleteGrowth(Area extension) {
+	using namespace std;
+
+	const bool extended = extension.width > 0 || extension.height > 0;
+	vector<Waiter> resumed;
+	bool regrow;
+	{
+		lock_guard<mutex> lock(binMutex);
+		if (extended)
+			bin.ExtendDimensions(extension);
+
+		vector<Area> areas;
+		areas.reserve(waiters.size());
+		for (const Waiter & w : waiters)
+			areas.push_back(w.area);
+		const vector<Rect> packed = bin.TryPackAreas(areas, constraints);
+
+		// Areas that still don't fit wait for another growth, unless the bin couldn't grow
+		vector<Waiter> waiting;
+		for (size_t i = 0; i < waiters.size(); i++) {
+			*waiters[i].packed = packed[i];
+			if (packed[i].IsValid() || !extended) {
+				resumed.push_back(waiters[i]);
+			} else {
+				waiting.push_back(waiters[i]);
+			}
+		}
+		waiters.swap(waiting);
+		growing = regrow = !waiters.empty();
+	}
+
+	if (regrow)
+		StartGrowth();
+	for (const Waiter & w : resumed)
+		w.handle.resume();
+}
+
+std::vector<Area> CoroutineBin::GetPendingAreas() const {
+	std::lock_guard<std::mutex> lock(binMutex);
+	std::vector<Area> pending;
+	pending.reserve(waiters.size());
+	for (const Waiter & w : waiters)
+		pending.push_back(w.area);
+	return pending;
+}
+
+Area CoroutineBin::GetDimensions() const {
+	std::lock_guard<std::mutex> lock(binMutex);
+	return bin.GetDimensions();
+}
+
+std::vector<Rect> CoroutineBin::GetEmptyRegions() const {
+	std::lock_guard<std::mutex> lock(binMutex);
+	return bin.GetEmptyRegions();
+}
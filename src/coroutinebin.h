@@ -0,0 +1,78 @@
+// Awaitable packing for C++20 coroutines.
+// Awaiting CoroutineBin::Pack packs the area immediately when it fits. Otherwise the coroutine is
+// suspended and the growth handler is asked to grow the bin, e.g. by resizing a texture on another
+// thread, without blocking the awaiting thread. Coroutines that fail to pack while a growth is in
+// progress wait for the same growth, so any number of them share a single resize. When the handler
+// reports that it is done, the bin is extended, the waiting areas are packed in the order they were
+// awaited and their coroutines are resumed on the thread that completed the growth.
+
+#pragma once
+#include "binpacker.h"
+#include <coroutine>
+#include <functional>
+#include <mutex>
+
+namespace BinPacker
+{
+	/// \brief \see Bin whose pack operations can be awaited by coroutines while the bin grows asynchronously.
+	class CoroutineBin {
+		public:
+			/// \brief Reports that a growth has finished and the bin should be extended by \a extension. May be called from any thread, exactly once.
+			/// An empty \a extension means the bin can't grow, which fails every waiting pack.
+			using GrowthCompletion = std::function<void(Area extension)>;
+			/// \brief Called when areas don't fit the bin, without any lock held. Should start growing the bin and return without waiting for it.
+			/// \param dimensions The current dimensions of the bin.
+			/// \param pending Every area waiting for the growth when the handler is called, in the order they were awaited.
+			/// Areas awaited after the handler is called also wait for the growth, and \see GetPendingAreas returns all of them.
+			using GrowthHandler = std::function<void(Area dimensions, const std::vector<Area>& pending, GrowthCompletion complete)>;
+
+			/// \brief Awaitable result of \see Pack.
+			class PackOperation {
+				public:
+					bool await_ready() const noexcept { return false; }
+					bool await_suspend(std::coroutine_handle<> handle);
+					/// \return The location of the packed area, or an invalid \see Rect object if the bin couldn't grow enough to fit it.
+					Rect await_resume() const noexcept { return packed; }
+				private:
+					friend class CoroutineBin;
+					PackOperation(CoroutineBin& bin, Area area) : bin(bin), area(area) {}
+
+					CoroutineBin& bin;
+					Area area;
+					Rect packed = {1, 1, 0, 0};
+			};
+
+			/// \brief Takes ownership of \a bin. The coroutine bin must outlive every pending pack operation.
+			CoroutineBin(Bin bin, GrowthHandler growthHandler, PackConstraints constraints = PackConstraints());
+
+			CoroutineBin(const CoroutineBin&) = delete;
+			CoroutineBin& operator=(const CoroutineBin&) = delete;
+
+			/// \brief Returns an operation that packs \a area when awaited, suspending the coroutine while the bin grows if it doesn't fit.
+			PackOperation Pack(Area area);
+
+			/// \brief Returns the areas waiting for the current growth, in the order they were awaited. Safe to call from any thread.
+			/// A growth handler that finishes asynchronously can call this before completing, to size the growth for areas awaited after it was called.
+			std::vector<Area> GetPendingAreas() const;
+			/// \brief Returns the dimensions of the bin, empty or not. Safe to call from any thread.
+			Area GetDimensions() const;
+			/// \brief Returns a copy of the empty regions of the bin. Safe to call from any thread.
+			std::vector<Rect> GetEmptyRegions() const;
+		private:
+			struct Waiter {
+				Area area;
+				Rect* packed;
+				std::coroutine_handle<> handle;
+			};
+
+			void StartGrowth();
+			void CompleteGrowth(Area extension);
+
+			mutable std::mutex binMutex;
+			Bin bin;
+			const GrowthHandler growthHandler;
+			const PackConstraints constraints;
+			std::vector<Waiter> waiters;
+			bool growing = false;
+	};
+}
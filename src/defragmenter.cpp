@@ -0,0 +1,148 @@
+#include "defragmenter.h"
+#include <algorithm>
+#include <numeric>
+
+using namespace BinPacker;
+
+static bool Overlaps(Rect a, Rect b) {
+	return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+}
+
+static bool IsRotated(Rect from, Rect to) {
+	return from.right - from.left != to.right - to.left;
+}
+
+Defragmenter::Defragmenter(Bin& bin, const std::vector<Rect>& liveRects, const PackConstraints& constraints)
+	: bin(bin), constraints(constraints), expectedRevision(bin.GetRevision()) {
+	planned = Plan(liveRects);
+}
+
+bool Defragmenter::Plan(const std::vector<Rect>& liveRects) {
+	using namespace std;
+
+	// Find the target layout by packing the rects largest first into an empty bin
+	vector<size_t> order(liveRects.size());
+	iota(order.begin(), order.end(), 0);
+	auto area = [](const Rect & r){ return (unsigned long long)(r.right - r.left + 1) * (r.bottom - r.top + 1); };
+	stable_sort(order.begin(), order.end(), [&](size_t a, size_t b){ return area(liveRects[a]) > area(liveRects[b]); });
+
+	Bin target;
+	target.ExtendDimensions(bin.GetDimensions());
+	vector<Rect> targets(liveRects.size());
+	for (size_t i : order) {
+		const Rect & r = liveRects[i];
+		targets[i] = target.TryPackArea({r.right - r.left + 1, r.bottom - r.top + 1}, constraints);
+		if (!targets[i].IsValid())
+			return false;
+	}
+
+	// Simulate the moves on a copy of the bin. A rect moves once its target is empty, otherwise it waits for the rects in the way to move.
+	Bin simulated = bin;
+	vector<Rect> current = liveRects;
+	vector<size_t> pending;
+	for (size_t i : order) {
+		if (current[i].left != targets[i].left || current[i].top != targets[i].top || IsRotated(current[i], targets[i]))
+			pending.push_back(i);
+	}
+
+	// Temporary locations are chosen in a copy that also reserves the targets of pending rects, so they don't block them
+	Bin avoiding = simulated;
+	for (size_t i : pending)
+		avoiding.Reserve(targets[i], constraints);
+
+	// Only rects whose targets are near space that was just vacated need to check if they can move
+	const unsigned int margin = constraints.padding.left + constraints.padding.right + constraints.padding.top + constraints.padding.bottom
+		+ max(constraints.sizeAlignment.width, constraints.sizeAlignment.height);
+	vector<bool> waiting(liveRects.size(), false);
+	for (size_t i : pending)
+		waiting[i] = true;
+	vector<size_t> candidates(pending.rbegin(), pending.rend());
+	auto move = [&](size_t i, Rect to) {
+		const Rect from = current[i];
+		plan.push_back(Relocation{from, to, IsRotated(from, to)});
+		simulated.Release(from, constraints);
+		avoiding.Release(from, constraints);
+		current[i] = to;
+
+		const Rect vacated = { from.left - min(from.left, margin), from.top - min(from.top, margin), from.right + margin, from.bottom + margin };
+		for (size_t j : pending) {
+			if (waiting[j] && j != i && Overlaps(targets[j], vacated))
+				candidates.push_back(j);
+		}
+	};
+
+	// Every move either finishes a rect or moves one out of the way, which bounds the moves even if temporary locations keep colliding
+	size_t remaining = pending.size();
+	for (size_t moves = 0; remaining > 0 && moves < liveRects.size() * 4; moves++) {
+		bool finished = false;
+		while (!candidates.empty() && !finished) {
+			const size_t i = candidates.back();
+			candidates.pop_back();
+			if (waiting[i] && simulated.Reserve(targets[i], constraints)) {
+				avoiding.Reserve(targets[i], constraints);
+				waiting[i] = false;
+				remaining--;
+				move(i, targets[i]);
+				finished = true;
+			}
+		}
+		if (finished)
+			continue;
+
+		// Every remaining rect is blocked, so move the first one out of the way, retrying it last
+		auto blocked = find_if(pending.begin(), pending.end(), [&waiting](size_t i){ return waiting[i]; });
+		const size_t i = *blocked;
+		pending.erase(blocked);
+		pending.push_back(i);
+
+		const Area size = { current[i].right - current[i].left + 1, current[i].bottom - current[i].top + 1 };
+		Rect temporary = avoiding.TryPackArea(size, constraints);
+		if (!temporary.IsValid() || !simulated.Reserve(temporary, constraints)) {
+			temporary = simulated.TryPackArea(size, constraints);
+			if (!temporary.IsValid())
+				break;
+			avoiding.Reserve(temporary, constraints);
+		}
+		move(i, temporary);
+		candidates.push_back(i);
+	}
+
+	for (size_t i : order)
+		layout.push_back(current[i]);
+	return remaining == 0;
+}
+
+std::vector<Relocation> Defragmenter::Step(unsigned int maxMoves) {
+	std::vector<Relocation> applied;
+	if (IsDone())
+		return applied;
+
+	changed = changed || bin.GetRevision() != expectedRevision;
+	while (applied.size() < maxMoves && nextMove < plan.size()) {
+		const Relocation & r = plan[nextMove];
+		if (!bin.Reserve(r.to, constraints)) {
+			nextMove = plan.size();
+			return applied;
+		}
+		bin.Release(r.from, constraints);
+		applied.push_back(r);
+		nextMove++;
+	}
+
+	if (IsDone() && !changed)
+		bin.RebuildEmptyRegions(layout, constraints);
+	expectedRevision = bin.GetRevision();
+	return applied;
+}
+
+bool Defragmenter::IsPlanned() const {
+	return planned;
+}
+
+bool Defragmenter::IsDone() const {
+	return nextMove >= plan.size();
+}
+
+size_t Defragmenter::GetRemainingMoves() const {
+	return plan.size() - nextMove;
+}
@@ -0,0 +1,60 @@
+// Defragmentation of a bin by relocating its packed rects.
+// After many packs and releases, free space ends up scattered in gaps too small for large items.
+// The defragmenter repacks every live rect, largest first, into an empty bin of the same dimensions
+// to find a compact target layout, then plans a sequence of moves that takes each rect from its
+// current location to its target. A rect is only moved once its target is empty, so the moves can be
+// performed one after another directly within the texture, without a staging copy. Rects that block
+// each other in a cycle are broken up by first moving one of them to a temporary location.
+// The plan is applied to the bin a few moves at a time, so the copies can be spread over many frames.
+// Moves fragment the empty regions of the bin, so they are rebuilt from the final layout at the end.
+// Largest first doesn't always find a layout for rects that were packed in another order. The
+// defragmenter then plans no moves and reports the failure, leaving the bin as it is.
+
+#pragma once
+#include "binpacker.h"
+#include <cstddef>
+
+namespace BinPacker
+{
+	/// \brief Move of a packed rect from one location to another.
+	struct Relocation {
+		Rect from, to;
+		/// \brief True if the contents of \a from are rotated by 90 degrees in \a to.
+		bool rotated;
+	};
+
+	/// \brief Plans and applies the relocations that compact a \see Bin.
+	class Defragmenter {
+		public:
+			/// \brief Plans the compaction of \a bin, which must outlive the defragmenter.
+			/// \param liveRects Every rect packed into \a bin with \a constraints.
+			Defragmenter(Bin& bin, const std::vector<Rect>& liveRects, const PackConstraints& constraints = PackConstraints());
+
+			/// \brief Applies up to \a maxMoves of the planned relocations to the bin.
+			/// If the bin was changed since the last step and a relocation's destination is no longer empty, the rest of the plan is abandoned.
+			/// Once the last relocation is applied, the empty regions of the bin are rebuilt unless it was changed in between steps.
+			/// \return The relocations applied, whose contents must be copied in order. Each destination is empty and doesn't overlap its source.
+			std::vector<Relocation> Step(unsigned int maxMoves);
+			/// \brief Returns true if the plan takes every live rect to a compact layout. Returns false if the live rects
+			/// couldn't all be repacked into an empty bin of the same dimensions, in which case no relocations are planned,
+			/// or if no temporary location could be found for a blocked rect, in which case the relocations planned up to
+			/// that point are kept and only partly compact the bin.
+			bool IsPlanned() const;
+			/// \brief Returns true once every planned relocation has been applied or the plan was abandoned.
+			bool IsDone() const;
+			/// \brief Returns the number of relocations that remain to be applied.
+			std::size_t GetRemainingMoves() const;
+		private:
+			bool Plan(const std::vector<Rect>& liveRects);
+
+			Bin& bin;
+			const PackConstraints constraints;
+			std::vector<Relocation> plan;
+			std::size_t nextMove = 0;
+			// Location of every rect after the plan, in the order they were packed in the target layout
+			std::vector<Rect> layout;
+			bool planned;
+			unsigned long long expectedRevision;
+			bool changed = false;
+	};
+}
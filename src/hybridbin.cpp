@@ -0,0 +1,100 @@
+#include "hybridbin.h"
+#include <algorithm>
+
+using namespace BinPacker;
+
+// Defined in binpacker.cpp
+unsigned int AlignUp(unsigned int value, unsigned int alignment);
+
+// Small items are packed into the pools once at least this many items have been packed and this share of them were small.
+// Below it, as in a mix of items from 1x1 to 64x64, pools raise the number of empty regions of the bin instead of lowering it.
+static const unsigned long long minRoutedItems = 32;
+static const double minSmallShare = 0.75;
+
+// Returns the log2 of value rounded up to a power of two
+static unsigned int GetSizeClass(unsigned int value) {
+	unsigned int sizeClass = 0;
+	while ((1u << sizeClass) < value)
+		sizeClass++;
+	return sizeClass;
+}
+
+HybridBin::HybridBin(Bin bin, PackConstraints constraints, unsigned int maxSmallSize)
+	: bin(std::move(bin)), constraints(constraints), classCount(0) {
+	while (classCount < 16 && (1u << classCount) <= maxSmallSize)
+		classCount++;
+	pools.resize(classCount * classCount);
+}
+
+CellPool* HybridBin::GetPool(Area area, bool create) {
+	if (area.width == 0 || area.height == 0)
+		return nullptr;
+	const unsigned int column = GetSizeClass(area.width), row = GetSizeClass(area.height);
+	if (column >= classCount || row >= classCount)
+		return nullptr;
+
+	std::unique_ptr<CellPool> & pool = pools[column * classCount + row];
+	if (!pool && create) {
+		// Items are packed at the top-left corner of their cell, which is followed by their size alignment and padding,
+		// and cells are spaced by the position alignment. Strips reserve the padding before their first cells as the bin would for an item.
+		const Padding & padding = constraints.padding;
+		const Area positionAlignment = { std::max(constraints.positionAlignment.width, 1u), std::max(constraints.positionAlignment.height, 1u) };
+		const Area sizeAlignment = { std::max(constraints.sizeAlignment.width, 1u), std::max(constraints.sizeAlignment.height, 1u) };
+		const Area cellSize = {
+			AlignUp(AlignUp(1u << column, sizeAlignment.width) + padding.left + padding.right, positionAlignment.width),
+			AlignUp(AlignUp(1u << row, sizeAlignment.height) + padding.top + padding.bottom, positionAlignment.height)
+		};
+		PackConstraints stripConstraints;
+		stripConstraints.padding = {padding.left, padding.top, 0, 0};
+		stripConstraints.padBinEdges = constraints.padBinEdges;
+		stripConstraints.positionAlignment = positionAlignment;
+
+		// Keep strips no larger than the smallest items packed into the bin directly, so they fragment it no more than those do
+		const unsigned int stripSize = 16;
+		const Area stripCells = { std::min(std::max(stripSize / cellSize.width, 1u), 8u), std::min(std::max(stripSize / cellSize.height, 1u), 8u) };
+		pool.reset(new CellPool(bin, cellSize, stripCells, stripConstraints));
+	}
+	return pool.get();
+}
+
+Rect HybridBin::TryPackArea(Area area) {
+	// Small items only go to the pools once they make up enough of the items, since among larger items they fill gaps the pools would leave
+	const bool small = area.width > 0 && area.height > 0 && GetSizeClass(area.width) < classCount && GetSizeClass(area.height) < classCount;
+	itemCount++;
+	smallItemCount += small;
+	if (small && itemCount >= minRoutedItems && (double)smallItemCount >= minSmallShare * itemCount) {
+		CellPool* pool = GetPool(area, true);
+		const Rect cell = pool->TryPackArea();
+		if (cell.IsValid())
+			return Rect{cell.left, cell.top, cell.left + area.width - 1, cell.top + area.height - 1};
+	}
+	return bin.TryPackArea(area, constraints);
+}
+
+void HybridBin::Release(Rect rect) {
+	if (!rect.IsValid())
+		return;
+
+	// Small items that didn't fit in a pool were packed into the bin instead, so they aren't in any strip
+	const Area area = { rect.right - rect.left + 1, rect.bottom - rect.top + 1 };
+	if (CellPool* pool = GetPool(area, false)) {
+		const unsigned int index = pool->GetCellIndex(rect);
+		if (index != CellPool::invalidCell) {
+			pool->Free(index);
+			return;
+		}
+	}
+	bin.Release(rect, constraints);
+}
+
+void HybridBin::ExtendDimensions(Area extension) {
+	bin.ExtendDimensions(extension);
+}
+
+Area HybridBin::GetDimensions() const {
+	return bin.GetDimensions();
+}
+
+const std::vector<Rect>& HybridBin::GetEmptyRegions() const {
+	return bin.GetEmptyRegions();
+}
@@ -0,0 +1,362 @@
+#include "journaledbin.h"
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace BinPacker;
+
+enum Operation : unsigned char {
+	PackOperation = 1,
+	ReleaseOperation = 2,
+	ExtendOperation = 3
+};
+
+static const unsigned char journalMagic[4] = {'B', 'P', 'J', '1'};
+static const unsigned char checkpointMagic[4] = {'B', 'P', 'C', '1'};
+
+static void WriteVarint(std::vector<unsigned char>& out, unsigned long long value) {
+	while (value >= 0x80) {
+		out.push_back((unsigned char)(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back((unsigned char)value);
+}
+
+static bool ReadVarint(const unsigned char*& data, const unsigned char* end, unsigned long long& value) {
+	value = 0;
+	for (unsigned int shift = 0; shift < 64 && data < end; shift += 7) {
+		const unsigned char byte = *data++;
+		value |= (unsigned long long)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+			return true;
+	}
+	return false;
+}
+
+static bool ReadUint(const unsigned char*& data, const unsigned char* end, unsigned int& value) {
+	unsigned long long wide;
+	if (!ReadVarint(data, end, wide) || wide > 0xFFFFFFFFull)
+		return false;
+	value = (unsigned int)wide;
+	return true;
+}
+
+static void WriteFixed(std::vector<unsigned char>& out, unsigned long long value, unsigned int bytes) {
+	for (unsigned int i = 0; i < bytes; i++)
+		out.push_back((unsigned char)(value >> (i * 8)));
+}
+
+static unsigned long long ReadFixed(const unsigned char* data, unsigned int bytes) {
+	unsigned long long value = 0;
+	for (unsigned int i = 0; i < bytes; i++)
+		value |= (unsigned long long)data[i] << (i * 8);
+	return value;
+}
+
+// 32-bit FNV-1a
+static unsigned int Checksum(const unsigned char* data, size_t size) {
+	unsigned int hash = 2166136261u;
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ data[i]) * 16777619u;
+	return hash;
+}
+
+static void WriteRect(std::vector<unsigned char>& out, Rect rect) {
+	WriteVarint(out, rect.left);
+	WriteVarint(out, rect.top);
+	WriteVarint(out, rect.right);
+	WriteVarint(out, rect.bottom);
+}
+
+static bool ReadRect(const unsigned char*& data, const unsigned char* end, Rect& rect) {
+	return ReadUint(data, end, rect.left) && ReadUint(data, end, rect.top) && ReadUint(data, end, rect.right) && ReadUint(data, end, rect.bottom);
+}
+
+static bool ReadFile(std::FILE* file, std::vector<unsigned char>& contents) {
+	unsigned char chunk[65536];
+	size_t read;
+	while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+		contents.insert(contents.end(), chunk, chunk + read);
+	return std::ferror(file) == 0;
+}
+
+static bool SyncFile(std::FILE* file) {
+	if (std::fflush(file) != 0)
+		return false;
+#ifdef _WIN32
+	return _commit(_fileno(file)) == 0;
+#else
+	return fsync(fileno(file)) == 0;
+#endif
+}
+
+static bool ReplaceFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+	return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+JournaledBin::JournaledBin(std::string path, unsigned int syncInterval, unsigned int checkpointInterval)
+	: path(std::move(path)), syncInterval(syncInterval > 0 ? syncInterval : 1), checkpointInterval(checkpointInterval) {
+}
+
+JournaledBin::~JournaledBin() {
+	if (journal != nullptr) {
+		Sync();
+		std::fclose(journal);
+	}
+}
+
+bool JournaledBin::Open() {
+	using namespace std;
+
+	if (journal != nullptr) {
+		fclose(journal);
+		journal = nullptr;
+	}
+	bin = Bin();
+	generation = 0;
+	buffer.clear();
+	bufferedOperations = 0;
+	journaledOperations = 0;
+	healthy = false;
+
+	// Load the checkpoint: magic, generation, dimensions, empty regions and a checksum of everything before it
+	if (FILE* file = fopen((path + ".checkpoint").c_str(), "rb")) {
+		vector<unsigned char> contents;
+		const bool read = ReadFile(file, contents);
+		fclose(file);
+		if (!read || contents.size() < 16 || !equal(checkpointMagic, checkpointMagic + 4, contents.begin())
+			|| ReadFixed(contents.data() + contents.size() - 4, 4) != Checksum(contents.data(), contents.size() - 4))
+			return false;
+
+		generation = ReadFixed(contents.data() + 4, 8);
+		const unsigned char* data = contents.data() + 12;
+		const unsigned char* end = contents.data() + contents.size() - 4;
+		Area dimensions;
+		unsigned long long count;
+		if (!ReadUint(data, end, dimensions.width) || !ReadUint(data, end, dimensions.height) || !ReadVarint(data, end, count))
+			return false;
+		vector<Rect> emptyRegions;
+		for (unsigned long long i = 0; i < count; i++) {
+			Rect r;
+			if (!ReadRect(data, end, r))
+				return false;
+			emptyRegions.push_back(r);
+		}
+		bin = Bin(dimensions, move(emptyRegions));
+	}
+
+	bool torn = false;
+	bool current = false;
+	if (FILE* file = fopen(path.c_str(), "rb")) {
+		unsigned char header[12];
+		current = fread(header, 1, sizeof(header), file) == sizeof(header) && equal(journalMagic, journalMagic + 4, header) && ReadFixed(header + 4, 8) == generation;
+		const bool replayed = !current || Replay(file, torn);
+		fclose(file);
+		if (!replayed)
+			return false;
+	}
+
+	// A journal that was torn or written before the checkpoint can't be appended to, so fold it into a new checkpoint instead
+	if (!current || torn) {
+		healthy = true;
+		return Checkpoint();
+	}
+
+	journal = fopen(path.c_str(), "ab");
+	healthy = journal != nullptr;
+	return healthy;
+}
+
+bool JournaledBin::Replay(std::FILE* file, bool& torn) {
+	using namespace std;
+
+	vector<unsigned char> contents;
+	if (!ReadFile(file, contents))
+		return false;
+
+	// Each record is the length of its payload, the payload and a checksum of the payload
+	const unsigned char* data = contents.data();
+	const unsigned char* end = data + contents.size();
+	while (data < end) {
+		unsigned long long length;
+		if (!ReadVarint(data, end, length) || length == 0 || length > (unsigned long long)(end - data) || end - data - length < 4
+			|| ReadFixed(data + length, 4) != Checksum(data, (size_t)length)) {
+			torn = true;
+			return true;
+		}
+
+		const unsigned char* payload = data;
+		const unsigned char* payloadEnd = data + length;
+		data = payloadEnd + 4;
+		journaledOperations++;
+
+		switch (*payload++) {
+			case PackOperation: {
+				Area area;
+				PackConstraints constraints;
+				unsigned int flags;
+				Rect recorded;
+				if (!ReadUint(payload, payloadEnd, area.width) || !ReadUint(payload, payloadEnd, area.height)
+					|| !ReadUint(payload, payloadEnd, constraints.padding.left) || !ReadUint(payload, payloadEnd, constraints.padding.top)
+					|| !ReadUint(payload, payloadEnd, constraints.padding.right) || !ReadUint(payload, payloadEnd, constraints.padding.bottom)
+					|| !ReadUint(payload, payloadEnd, flags)
+					|| !ReadUint(payload, payloadEnd, constraints.positionAlignment.width) || !ReadUint(payload, payloadEnd, constraints.positionAlignment.height)
+					|| !ReadUint(payload, payloadEnd, constraints.sizeAlignment.width) || !ReadUint(payload, payloadEnd, constraints.sizeAlignment.height)
+					|| !ReadRect(payload, payloadEnd, recorded))
+					return false;
+				constraints.padBinEdges = (flags & 1) != 0;
+				constraints.allowRotation = (flags & 2) == 0;
+
+				const Rect packed = bin.TryPackArea(area, constraints);
+				if (packed.left != recorded.left || packed.top != recorded.top || packed.right != recorded.right || packed.bottom != recorded.bottom)
+					return false;
+				break;
+			}
+			case ReleaseOperation: {
+				Rect rect;
+				if (!ReadRect(payload, payloadEnd, rect))
+					return false;
+				bin.Release(rect);
+				break;
+			}
+			case ExtendOperation: {
+				Area extension;
+				if (!ReadUint(payload, payloadEnd, extension.width) || !ReadUint(payload, payloadEnd, extension.height))
+					return false;
+				bin.ExtendDimensions(extension);
+				break;
+			}
+			default:
+				return false;
+		}
+	}
+	return true;
+}
+
+Rect JournaledBin::TryPackArea(Area area, const PackConstraints & constraints) {
+	const Rect packed = bin.TryPackArea(area, constraints);
+
+	std::vector<unsigned char> payload;
+	payload.push_back(PackOperation);
+	WriteVarint(payload, area.width);
+	WriteVarint(payload, area.height);
+	WriteVarint(payload, constraints.padding.left);
+	WriteVarint(payload, constraints.padding.top);
+	WriteVarint(payload, constraints.padding.right);
+	WriteVarint(payload, constraints.padding.bottom);
+	WriteVarint(payload, (constraints.padBinEdges ? 1 : 0) | (constraints.allowRotation ? 0 : 2));
+	WriteVarint(payload, constraints.positionAlignment.width);
+	WriteVarint(payload, constraints.positionAlignment.height);
+	WriteVarint(payload, constraints.sizeAlignment.width);
+	WriteVarint(payload, constraints.sizeAlignment.height);
+	WriteRect(payload, packed);
+	Append(payload);
+
+	return packed;
+}
+
+void JournaledBin::Release(Rect rect) {
+	bin.Release(rect);
+
+	std::vector<unsigned char> payload;
+	payload.push_back(ReleaseOperation);
+	WriteRect(payload, rect);
+	Append(payload);
+}
+
+void JournaledBin::ExtendDimensions(Area extension) {
+	bin.ExtendDimensions(extension);
+
+	std::vector<unsigned char> payload;
+	payload.push_back(ExtendOperation);
+	WriteVarint(payload, extension.width);
+	WriteVarint(payload, extension.height);
+	Append(payload);
+}
+
+void JournaledBin::Append(const std::vector<unsigned char>& payload) {
+	WriteVarint(buffer, payload.size());
+	buffer.insert(buffer.end(), payload.begin(), payload.end());
+	WriteFixed(buffer, Checksum(payload.data(), payload.size()), 4);
+	journaledOperations++;
+
+	if (checkpointInterval > 0 && journaledOperations >= checkpointInterval) {
+		if (Checkpoint())
+			return;
+		// The operations stay in the current journal instead, and the next checkpoint is attempted after another interval
+		journaledOperations = 0;
+		Sync();
+	} else if (++bufferedOperations >= syncInterval) {
+		Sync();
+	}
+}
+
+bool JournaledBin::Sync() {
+	// Without a journal, as after it failed to open, the operations are dropped and reported rather than buffered forever
+	if (!buffer.empty()) {
+		healthy = journal != nullptr && std::fwrite(buffer.data(), 1, buffer.size(), journal) == buffer.size() && SyncFile(journal) && healthy;
+		buffer.clear();
+	}
+	bufferedOperations = 0;
+	return healthy;
+}
+
+bool JournaledBin::Checkpoint() {
+	using namespace std;
+
+	vector<unsigned char> contents(checkpointMagic, checkpointMagic + 4);
+	WriteFixed(contents, generation + 1, 8);
+	WriteVarint(contents, bin.GetDimensions().width);
+	WriteVarint(contents, bin.GetDimensions().height);
+	WriteVarint(contents, bin.GetEmptyRegions().size());
+	for (const Rect & r : bin.GetEmptyRegions())
+		WriteRect(contents, r);
+	WriteFixed(contents, Checksum(contents.data(), contents.size()), 4);
+
+	// Write the checkpoint to a temporary file first so a crash can't leave a partial checkpoint behind
+	const string checkpointPath = path + ".checkpoint";
+	const string temporaryPath = checkpointPath + ".tmp";
+	FILE* file = fopen(temporaryPath.c_str(), "wb");
+	if (file == nullptr)
+		return false;
+	const bool written = fwrite(contents.data(), 1, contents.size(), file) == contents.size() && SyncFile(file);
+	fclose(file);
+	if (!written || !ReplaceFile(temporaryPath, checkpointPath)) {
+		remove(temporaryPath.c_str());
+		return false;
+	}
+
+	// The old journal is now superseded by the checkpoint even if starting a new one fails
+	generation++;
+	buffer.clear();
+	bufferedOperations = 0;
+	journaledOperations = 0;
+	return StartJournal();
+}
+
+bool JournaledBin::StartJournal() {
+	if (journal != nullptr)
+		std::fclose(journal);
+
+	journal = std::fopen(path.c_str(), "wb");
+	if (journal == nullptr) {
+		healthy = false;
+		return false;
+	}
+
+	std::vector<unsigned char> header(journalMagic, journalMagic + 4);
+	WriteFixed(header, generation, 8);
+	healthy = std::fwrite(header.data(), 1, header.size(), journal) == header.size() && SyncFile(journal) && healthy;
+	return healthy;
+}
+
+const Bin& JournaledBin::GetBin() const {
+	return bin;
+}
@@ -0,0 +1,71 @@
+// Crash-safe Bin backed by an append-only journal.
+// Every pack, release and extension is appended to a journal file as a compact binary record of
+// variable length integers followed by a checksum. Records are buffered and written and synced to
+// disk in batches, so the cost of a sync is shared by many operations. A checkpoint writes the whole
+// state of the bin to a separate file, atomically replaces the previous checkpoint and starts a new
+// journal. Opening the bin loads the last checkpoint and replays the journal written after it. Since
+// packing is deterministic, replay rebuilds exactly the same empty regions, which is verified by
+// comparing each replayed pack with the placement that was recorded.
+//
+// The journal is stored at the given path and the checkpoint next to it with ".checkpoint" appended.
+// Both start with a generation number so that a journal left behind by a crash during a checkpoint
+// is recognised as already included in the checkpoint. A record torn by a crash ends the journal.
+
+#pragma once
+#include "binpacker.h"
+#include <cstdio>
+#include <string>
+
+namespace BinPacker
+{
+	/// \brief \see Bin whose operations are journaled to disk for crash recovery.
+	class JournaledBin {
+		public:
+			/// \param path Path of the journal file.
+			/// \param syncInterval The number of operations buffered before they are written and synced to disk.
+			/// \param checkpointInterval The number of journaled operations after which a checkpoint is written automatically, or 0 to only checkpoint when \see Checkpoint is called.
+			JournaledBin(std::string path, unsigned int syncInterval = 64, unsigned int checkpointInterval = 65536);
+			/// \brief Syncs buffered operations to disk.
+			~JournaledBin();
+
+			JournaledBin(const JournaledBin&) = delete;
+			JournaledBin& operator=(const JournaledBin&) = delete;
+
+			/// \brief Rebuilds the bin from the checkpoint and journal on disk, if any, and opens the journal for appending.
+			/// \return False if the files couldn't be read or written, or if replaying the journal didn't reproduce the recorded placements.
+			bool Open();
+
+			/// \brief Packs \a area as \see Bin::TryPackArea does and journals the operation.
+			Rect TryPackArea(Area area, const PackConstraints& constraints = PackConstraints());
+			/// \brief Releases \a rect as \see Bin::Release does and journals the operation.
+			void Release(Rect rect);
+			/// \brief Extends the bin as \see Bin::ExtendDimensions does and journals the operation.
+			void ExtendDimensions(Area extension);
+
+			/// \brief Writes buffered operations to the journal and syncs it to disk.
+			/// \return False if this or any earlier write since \see Open failed.
+			bool Sync();
+			/// \brief Writes the state of the bin to the checkpoint file and starts a new, empty journal.
+			/// \return False if the checkpoint couldn't be written, in which case the journal is kept.
+			bool Checkpoint();
+
+			/// \brief Returns the journaled bin.
+			const Bin& GetBin() const;
+		private:
+			bool Replay(std::FILE* journal, bool& torn);
+			bool StartJournal();
+			void Append(const std::vector<unsigned char>& payload);
+
+			const std::string path;
+			const unsigned int syncInterval;
+			const unsigned int checkpointInterval;
+
+			Bin bin;
+			unsigned long long generation = 0;
+			std::FILE* journal = nullptr;
+			std::vector<unsigned char> buffer;
+			unsigned int bufferedOperations = 0;
+			unsigned int journaledOperations = 0;
+			bool healthy = false;
+	};
+}
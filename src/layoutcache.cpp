@@ -0,0 +1,214 @@
+#include "layoutcache.h"
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+
+using namespace BinPacker;
+
+// Stored in every entry and hashed into every key. Must change whenever packing results or the entry format change.
+static const unsigned int layoutVersion = 2;
+static const unsigned char layoutMagic[4] = {'B', 'P', 'L', '1'};
+
+static void WriteUint(std::vector<unsigned char>& out, unsigned int value) {
+	for (unsigned int i = 0; i < 4; i++)
+		out.push_back((unsigned char)(value >> (i * 8)));
+}
+
+static void WriteArea(std::vector<unsigned char>& out, Area area) {
+	WriteUint(out, area.width);
+	WriteUint(out, area.height);
+}
+
+static void WriteRect(std::vector<unsigned char>& out, Rect rect) {
+	WriteUint(out, rect.left);
+	WriteUint(out, rect.top);
+	WriteUint(out, rect.right);
+	WriteUint(out, rect.bottom);
+}
+
+// Encodes everything that affects the result of packing. Both the key and the stored entry are derived from this.
+static void WriteInput(std::vector<unsigned char>& out, const std::vector<Area>& items, const PackSettings& settings) {
+	WriteUint(out, layoutVersion);
+	WriteArea(out, settings.initialDimensions);
+	WriteArea(out, settings.maxDimensions);
+	const PackConstraints & c = settings.constraints;
+	WriteUint(out, c.padding.left);
+	WriteUint(out, c.padding.top);
+	WriteUint(out, c.padding.right);
+	WriteUint(out, c.padding.bottom);
+	WriteUint(out, (c.padBinEdges ? 1 : 0) | (c.allowRotation ? 0 : 2));
+	WriteArea(out, c.positionAlignment);
+	WriteArea(out, c.sizeAlignment);
+	WriteUint(out, (unsigned int)items.size());
+	for (const Area & item : items)
+		WriteArea(out, item);
+}
+
+// Reads little-endian values from an entry, failing once the end is passed
+struct Reader {
+	const unsigned char* data;
+	const unsigned char* end;
+	bool valid;
+
+	unsigned int ReadUint() {
+		if (end - data < 4) {
+			valid = false;
+			return 0;
+		}
+		const unsigned int value = data[0] | (data[1] << 8) | (data[2] << 16) | ((unsigned int)data[3] << 24);
+		data += 4;
+		return value;
+	}
+
+	Rect ReadRect() {
+		Rect rect;
+		rect.left = ReadUint();
+		rect.top = ReadUint();
+		rect.right = ReadUint();
+		rect.bottom = ReadUint();
+		return rect;
+	}
+};
+
+// Returns a name for a temporary file that no other process or thread writing the same entry uses
+static std::string GetTemporaryPath(const std::string& path) {
+	static std::atomic<unsigned long long> counter(0);
+#ifdef _WIN32
+	const unsigned long long process = (unsigned long long)_getpid();
+#else
+	const unsigned long long process = (unsigned long long)getpid();
+#endif
+	char suffix[64];
+	std::snprintf(suffix, sizeof(suffix), ".%llu.%llu.tmp", process, counter++);
+	return path + suffix;
+}
+
+static bool SameResult(const PackResult& a, const PackResult& b) {
+	auto sameRects = [](const std::vector<Rect>& x, const std::vector<Rect>& y) {
+		return x.size() == y.size() && std::equal(x.begin(), x.end(), y.begin(), [](const Rect& p, const Rect& q) {
+			return p.left == q.left && p.top == q.top && p.right == q.right && p.bottom == q.bottom;
+		});
+	};
+	return a.dimensions.width == b.dimensions.width && a.dimensions.height == b.dimensions.height
+		&& sameRects(a.placements, b.placements) && sameRects(a.emptyRegions, b.emptyRegions);
+}
+
+LayoutCache::LayoutCache(std::string directory, unsigned int verifyInterval)
+	: directory(std::move(directory)), verifyInterval(verifyInterval) {
+}
+
+PackResult LayoutCache::Pack(const std::vector<Area>& items, const PackSettings& settings) {
+	const unsigned long long key = GetKey(items, settings);
+
+	PackResult cached;
+	if (Load(key, items, settings, cached)) {
+		hits++;
+		if (verifyInterval == 0 || hits % verifyInterval != 0)
+			return cached;
+
+		PackResult packed = PackItems(items, settings);
+		if (SameResult(cached, packed))
+			return cached;
+		verificationFailures++;
+		Store(key, items, settings, packed);
+		return packed;
+	}
+
+	misses++;
+	PackResult packed = PackItems(items, settings);
+	Store(key, items, settings, packed);
+	return packed;
+}
+
+unsigned long long LayoutCache::GetKey(const std::vector<Area>& items, const PackSettings& settings) {
+	std::vector<unsigned char> input;
+	WriteInput(input, items, settings);
+
+	// 64-bit FNV-1a
+	unsigned long long hash = 14695981039346656037ull;
+	for (unsigned char byte : input)
+		hash = (hash ^ byte) * 1099511628211ull;
+	return hash;
+}
+
+unsigned long long LayoutCache::GetHits() const {
+	return hits;
+}
+
+unsigned long long LayoutCache::GetMisses() const {
+	return misses;
+}
+
+unsigned long long LayoutCache::GetVerificationFailures() const {
+	return verificationFailures;
+}
+
+std::string LayoutCache::GetPath(unsigned long long key) const {
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.layout", key);
+	return directory + "/" + name;
+}
+
+bool LayoutCache::Load(unsigned long long key, const std::vector<Area>& items, const PackSettings& settings, PackResult& result) const {
+	using namespace std;
+
+	FILE* file = fopen(GetPath(key).c_str(), "rb");
+	if (file == nullptr)
+		return false;
+	vector<unsigned char> contents;
+	unsigned char chunk[65536];
+	size_t read;
+	while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+		contents.insert(contents.end(), chunk, chunk + read);
+	const bool failed = ferror(file) != 0;
+	fclose(file);
+
+	// An entry is the magic, the input it was packed from, the dimensions, the placements and the empty regions
+	vector<unsigned char> input;
+	WriteInput(input, items, settings);
+	if (failed || contents.size() < 4 + input.size() || !equal(layoutMagic, layoutMagic + 4, contents.begin())
+		|| !equal(input.begin(), input.end(), contents.begin() + 4))
+		return false;
+
+	Reader reader = {contents.data() + 4 + input.size(), contents.data() + contents.size(), true};
+	result.dimensions.width = reader.ReadUint();
+	result.dimensions.height = reader.ReadUint();
+	result.placements.resize(items.size());
+	for (Rect & r : result.placements)
+		r = reader.ReadRect();
+	const unsigned int regionCount = reader.ReadUint();
+	if (!reader.valid || (size_t)(reader.end - reader.data) != (size_t)regionCount * 16)
+		return false;
+	result.emptyRegions.resize(regionCount);
+	for (Rect & r : result.emptyRegions)
+		r = reader.ReadRect();
+	return reader.valid;
+}
+
+void LayoutCache::Store(unsigned long long key, const std::vector<Area>& items, const PackSettings& settings, const PackResult& result) const {
+	using namespace std;
+
+	vector<unsigned char> contents(layoutMagic, layoutMagic + 4);
+	WriteInput(contents, items, settings);
+	WriteArea(contents, result.dimensions);
+	for (const Rect & r : result.placements)
+		WriteRect(contents, r);
+	WriteUint(contents, (unsigned int)result.emptyRegions.size());
+	for (const Rect & r : result.emptyRegions)
+		WriteRect(contents, r);
+
+	// Write to a temporary file of our own first so concurrent builds never read or write a partial entry. Failing to store only costs a repack.
+	const string path = GetPath(key);
+	const string temporaryPath = GetTemporaryPath(path);
+	FILE* file = fopen(temporaryPath.c_str(), "wb");
+	if (file == nullptr)
+		return;
+	const bool written = fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+	if (fclose(file) != 0 || !written || rename(temporaryPath.c_str(), path.c_str()) != 0)
+		remove(temporaryPath.c_str());
+}
@@ -0,0 +1,46 @@
+// On-disk cache of packing results.
+// Packing the same items with the same settings always produces the same layout, so the result of
+// PackItems can be stored and returned directly the next time the same list is packed. Entries are
+// keyed by a 64-bit FNV-1a hash of the items and settings and stored one per file in a directory,
+// in an explicit little-endian encoding so caches can be shared between platforms. Each entry also
+// stores the items and settings it was packed from, so a hash collision is a miss rather than a
+// wrong layout. To catch changes to the packing algorithm or platform differences that would make
+// stored layouts stale, every Nth hit is packed again and compared with the stored result.
+
+#pragma once
+#include "bulkpacker.h"
+#include <string>
+
+namespace BinPacker
+{
+	/// \brief Caches the results of \see PackItems in a directory. Used by one thread at a time,
+	/// though caches in several threads or processes may share a directory.
+	class LayoutCache {
+		public:
+			/// \param directory An existing directory in which to store cached layouts.
+			/// \param verifyInterval Every this many hits, the items are packed again to verify the cached layout, or 0 to never verify.
+			LayoutCache(std::string directory, unsigned int verifyInterval = 16);
+
+			/// \brief Returns the result of \see PackItems for \a items and \a settings, from the cache if possible.
+			/// Results that weren't cached are stored for next time.
+			PackResult Pack(const std::vector<Area>& items, const PackSettings& settings = PackSettings());
+
+			/// \brief Returns the key under which the result of packing \a items with \a settings is cached.
+			static unsigned long long GetKey(const std::vector<Area>& items, const PackSettings& settings);
+
+			unsigned long long GetHits() const;
+			unsigned long long GetMisses() const;
+			/// \brief Returns the number of verified hits whose cached layout differed from a fresh pack and was replaced.
+			unsigned long long GetVerificationFailures() const;
+		private:
+			std::string GetPath(unsigned long long key) const;
+			bool Load(unsigned long long key, const std::vector<Area>& items, const PackSettings& settings, PackResult& result) const;
+			void Store(unsigned long long key, const std::vector<Area>& items, const PackSettings& settings, const PackResult& result) const;
+
+			const std::string directory;
+			const unsigned int verifyInterval;
+			unsigned long long hits = 0;
+			unsigned long long misses = 0;
+			unsigned long long verificationFailures = 0;
+	};
+}
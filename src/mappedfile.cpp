@@ -0,0 +1,155 @@
+#include "mappedfile.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace BinPacker;
+
+// Returns the alignment required of the offset of a mapping
+static unsigned long long GetGranularity() {
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwAllocationGranularity;
+#else
+	return (unsigned long long)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+MappedFile::~MappedFile() {
+	Close();
+}
+
+bool MappedFile::Open(const std::string& path) {
+	Close();
+	writable = false;
+#ifdef _WIN32
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	LARGE_INTEGER fileSize;
+	if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize)) {
+		Close();
+		return false;
+	}
+	size = (unsigned long long)fileSize.QuadPart;
+	mapping = size > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+	if (size > 0 && mapping == nullptr) {
+		Close();
+		return false;
+	}
+#else
+	file = open(path.c_str(), O_RDONLY);
+	struct stat status;
+	if (file < 0 || fstat(file, &status) != 0) {
+		Close();
+		return false;
+	}
+	size = (unsigned long long)status.st_size;
+#endif
+	return true;
+}
+
+bool MappedFile::Create(const std::string& path, unsigned long long size) {
+	Close();
+	writable = true;
+#ifdef _WIN32
+	file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	LARGE_INTEGER fileSize;
+	fileSize.QuadPart = (LONGLONG)size;
+	if (file == INVALID_HANDLE_VALUE || !SetFilePointerEx(file, fileSize, nullptr, FILE_BEGIN) || !SetEndOfFile(file)) {
+		Close();
+		return false;
+	}
+	mapping = size > 0 ? CreateFileMappingA(file, nullptr, PAGE_READWRITE, 0, 0, nullptr) : nullptr;
+	if (size > 0 && mapping == nullptr) {
+		Close();
+		return false;
+	}
+#else
+	file = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (file < 0 || ftruncate(file, (off_t)size) != 0) {
+		Close();
+		return false;
+	}
+#endif
+	this->size = size;
+	return true;
+}
+
+void MappedFile::Close() {
+	Unmap();
+#ifdef _WIN32
+	if (mapping != nullptr)
+		CloseHandle(mapping);
+	if (file != nullptr && file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+	mapping = nullptr;
+	file = nullptr;
+#else
+	if (file >= 0)
+		close(file);
+	file = -1;
+#endif
+	size = 0;
+}
+
+unsigned char* MappedFile::Map(unsigned long long offset, std::size_t size) {
+	if (!Unmap() || size == 0 || offset > this->size || size > this->size - offset)
+		return nullptr;
+
+	// Start the mapping at the granularity below the offset
+	const unsigned long long start = offset / GetGranularity() * GetGranularity();
+	const std::size_t length = (std::size_t)(offset - start) + size;
+#ifdef _WIN32
+	if (mapping == nullptr)
+		return nullptr;
+	view = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, (DWORD)(start >> 32), (DWORD)start, length);
+	if (view == nullptr)
+		return nullptr;
+#else
+	if (file < 0)
+		return nullptr;
+	view = mmap(nullptr, length, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, file, (off_t)start);
+	if (view == MAP_FAILED) {
+		view = nullptr;
+		return nullptr;
+	}
+	madvise(view, length, MADV_SEQUENTIAL);
+#endif
+	viewSize = length;
+	return (unsigned char*)view + (offset - start);
+}
+
+bool MappedFile::Flush() {
+	if (view == nullptr || !writable)
+		return true;
+#ifdef _WIN32
+	return FlushViewOfFile(view, viewSize) != 0;
+#else
+	return msync(view, viewSize, MS_SYNC) == 0;
+#endif
+}
+
+unsigned long long MappedFile::GetSize() const {
+	return size;
+}
+
+bool MappedFile::Unmap() {
+	if (view == nullptr)
+		return true;
+	// Start writing the window back without waiting for it, so that its pages can be reclaimed
+#ifdef _WIN32
+	const bool written = !writable || FlushViewOfFile(view, 0) != 0;
+	UnmapViewOfFile(view);
+#else
+	const bool written = !writable || msync(view, viewSize, MS_ASYNC) == 0;
+	munmap(view, viewSize);
+#endif
+	view = nullptr;
+	viewSize = 0;
+	return written;
+}
@@ -0,0 +1,54 @@
+// Memory-mapped access to files larger than memory.
+// A file is mapped one window at a time, so that reading or writing it sequentially only keeps the
+// current window resident. Windows may start at any offset; the mapping itself starts at the
+// allocation granularity of the platform below it.
+
+#pragma once
+#include <cstddef>
+#include <string>
+
+namespace BinPacker
+{
+	/// \brief File mapped into memory one window at a time.
+	class MappedFile {
+		public:
+			MappedFile() = default;
+			/// \brief Unmaps the current window and closes the file.
+			~MappedFile();
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			/// \brief Opens the file at \a path for reading.
+			/// \return False if the file couldn't be opened.
+			bool Open(const std::string& path);
+			/// \brief Creates the file at \a path, or truncates it if it exists, with a size of \a size bytes for writing.
+			/// \return False if the file couldn't be created.
+			bool Create(const std::string& path, unsigned long long size);
+			/// \brief Unmaps the current window and closes the file.
+			void Close();
+
+			/// \brief Maps \a size bytes of the file from \a offset, unmapping the previous window.
+			/// \return A pointer to the byte at \a offset, or null if the window couldn't be mapped or lies outside the file.
+			unsigned char* Map(unsigned long long offset, std::size_t size);
+			/// \brief Writes the modified bytes of the current window to the file.
+			/// \return False if the window couldn't be written.
+			bool Flush();
+
+			/// \brief Returns the size of the open file in bytes.
+			unsigned long long GetSize() const;
+		private:
+			bool Unmap();
+
+#ifdef _WIN32
+			void* file = nullptr;
+			void* mapping = nullptr;
+#else
+			int file = -1;
+#endif
+			bool writable = false;
+			unsigned long long size = 0;
+			void* view = nullptr;
+			std::size_t viewSize = 0;
+	};
+}
@@ -0,0 +1,148 @@
+#include "packservice.h"
+
+using namespace BinPacker;
+
+PackService::PackService(Bin bin, PackConstraints constraints, GrowthHandler growthHandler, unsigned int maxBatchSize, SnapshotPublisher* publisher)
+	: bin(std::move(bin)), constraints(constraints), growthHandler(std::move(growthHandler)), maxBatchSize(maxBatchSize > 0 ? maxBatchSize : 1),
+	publisher(publisher), head(&stub), tail(&stub), pending(0), snapshotRequested(false), sleeping(false), stopping(false) {
+	stub.next.store(nullptr, std::memory_order_relaxed);
+	if (publisher != nullptr) {
+		publisher->SetRequestHandler([this]{
+			snapshotRequested.store(true);
+			Wake();
+		});
+	}
+	thread = std::thread(&PackService::Run, this);
+}
+
+PackService::~PackService() {
+	stopping.store(true);
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+		wake.notify_one();
+	}
+	thread.join();
+}
+
+std::future<Rect> PackService::Pack(Area area) {
+	Request* request = new Request();
+	request->area = area;
+	std::future<Rect> result = request->promise.get_future();
+	Push(request);
+	return result;
+}
+
+void PackService::Pack(Area area, Callback callback) {
+	Request* request = new Request();
+	request->area = area;
+	request->callback = std::move(callback);
+	Push(request);
+}
+
+void PackService::Push(Request* request) {
+	request->next.store(nullptr, std::memory_order_relaxed);
+	Request* previous = head.exchange(request, std::memory_order_acq_rel);
+	previous->next.store(request, std::memory_order_release);
+
+	pending.fetch_add(1);
+	Wake();
+}
+
+void PackService::Wake() {
+	// Only take the lock if the packer thread may be asleep
+	if (sleeping.load()) {
+		std::lock_guard<std::mutex> lock(wakeMutex);
+		wake.notify_one();
+	}
+}
+
+// Returns the oldest request, or null if the queue is empty or a producer has not yet finished linking its request.
+PackService::Request* PackService::Pop() {
+	Request* first = tail;
+	Request* next = first->next.load(std::memory_order_acquire);
+	if (first == &stub) {
+		if (next == nullptr)
+			return nullptr;
+		tail = next;
+		first = next;
+		next = next->next.load(std::memory_order_acquire);
+	}
+	if (next != nullptr) {
+		tail = next;
+		return first;
+	}
+
+	// The last request can only be removed once another node follows it, so recycle the stub behind it
+	if (first != head.load(std::memory_order_acquire))
+		return nullptr;
+	stub.next.store(nullptr, std::memory_order_relaxed);
+	Request* previous = head.exchange(&stub, std::memory_order_acq_rel);
+	previous->next.store(&stub, std::memory_order_release);
+	next = first->next.load(std::memory_order_acquire);
+	if (next != nullptr) {
+		tail = next;
+		return first;
+	}
+	return nullptr;
+}
+
+void PackService::Run() {
+	std::vector<Request*> batch;
+	std::vector<Area> areas;
+	while (true) {
+		while (batch.size() < maxBatchSize && pending.load() > 0) {
+			Request* request = Pop();
+			if (request == nullptr) {
+				// A producer is between publishing and linking its request
+				std::this_thread::yield();
+				continue;
+			}
+			pending.fetch_sub(1);
+			batch.push_back(request);
+		}
+
+		if (batch.empty()) {
+			if (publisher != nullptr) {
+				snapshotRequested.store(false);
+				publisher->Publish(bin);
+			}
+			if (stopping.load())
+				break;
+			sleeping.store(true);
+			{
+				std::unique_lock<std::mutex> lock(wakeMutex);
+				wake.wait(lock, [this]{ return pending.load() > 0 || stopping.load() || snapshotRequested.load(); });
+			}
+			sleeping.store(false);
+			continue;
+		}
+
+		areas.clear();
+		for (const Request* request : batch)
+			areas.push_back(request->area);
+		std::vector<Rect> results = bin.TryPackAreas(areas, constraints);
+
+		bool grown = false;
+		for (size_t i = 0; i < batch.size(); i++) {
+			// Areas that failed before the bin was grown for an earlier area in the batch may fit now
+			if (!results[i].IsValid() && grown)
+				results[i] = bin.TryPackArea(areas[i], constraints);
+			while (!results[i].IsValid() && growthHandler && growthHandler(bin, areas[i])) {
+				grown = true;
+				results[i] = bin.TryPackArea(areas[i], constraints);
+			}
+
+			if (batch[i]->callback)
+				batch[i]->callback(results[i]);
+			else
+				batch[i]->promise.set_value(results[i]);
+			delete batch[i];
+		}
+		batch.clear();
+
+		if (publisher != nullptr) {
+			snapshotRequested.store(false);
+			publisher->Publish(bin);
+		}
+	}
+}
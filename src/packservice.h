@@ -0,0 +1,79 @@
+// Asynchronous front-end for a Bin.
+// Any number of threads may submit pack requests, which are pushed onto a lock-free
+// multi-producer single-consumer queue. A dedicated packer thread drains the queue in
+// batches, packs each batch with Bin::TryPackAreas and then completes the requests'
+// futures or callbacks with the resulting placements. If given a SnapshotPublisher, the packer
+// thread also publishes snapshots of the bin whenever a reader requests one.
+
+#pragma once
+#include "binpacker.h"
+#include "binsnapshot.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+
+namespace BinPacker
+{
+	/// \brief Packs areas into a \see Bin on a dedicated thread.
+	class PackService {
+		public:
+			/// \brief Called on the packer thread when \a area could not be packed.
+			/// \return True if the bin was grown and packing \a area should be retried.
+			using GrowthHandler = std::function<bool(Bin& bin, Area area)>;
+			/// \brief Called on the packer thread with the result of a pack request.
+			using Callback = std::function<void(Rect)>;
+
+			/// \brief Starts the packer thread, which takes ownership of \a bin.
+			/// \param maxBatchSize The maximum number of requests packed per batch.
+			/// \param publisher If not null, publishes snapshots of the bin for readers on other threads. Must outlive the service.
+			PackService(Bin bin, PackConstraints constraints = PackConstraints(), GrowthHandler growthHandler = nullptr, unsigned int maxBatchSize = 256,
+				SnapshotPublisher* publisher = nullptr);
+			/// \brief Completes all submitted requests and stops the packer thread.
+			~PackService();
+
+			PackService(const PackService&) = delete;
+			PackService& operator=(const PackService&) = delete;
+
+			/// \brief Submits \a area for packing. Safe to call from any thread.
+			/// \return A future of the packed \see Rect, which is invalid if the area could not be packed.
+			std::future<Rect> Pack(Area area);
+			/// \brief Submits \a area for packing and calls \a callback on the packer thread with the result. Safe to call from any thread.
+			void Pack(Area area, Callback callback);
+		private:
+			struct Request {
+				std::atomic<Request*> next;
+				Area area;
+				std::promise<Rect> promise;
+				Callback callback;
+			};
+
+			void Push(Request* request);
+			void Wake();
+			Request* Pop();
+			void Run();
+
+			Bin bin;
+			const PackConstraints constraints;
+			const GrowthHandler growthHandler;
+			const unsigned int maxBatchSize;
+			SnapshotPublisher* const publisher;
+
+			// Intrusive MPSC queue. Producers exchange the head, the packer thread consumes from the tail.
+			Request stub;
+			std::atomic<Request*> head;
+			Request* tail;
+
+			// Used only to put the packer thread to sleep when the queue is empty
+			std::atomic<size_t> pending;
+			std::atomic<bool> snapshotRequested;
+			std::atomic<bool> sleeping;
+			std::atomic<bool> stopping;
+			std::mutex wakeMutex;
+			std::condition_variable wake;
+
+			std::thread thread;
+	};
+}
@@ -0,0 +1,252 @@
+#include "sparsebin.h"
+#include <algorithm>
+#include <limits>
+
+using namespace BinPacker;
+
+// Scores the result of clipping region by clip as GetClipScore does for a Bin, without overflowing for large regions
+static unsigned long long GetClipScore64(Rect region, Rect clip) {
+	using namespace std;
+
+	if (clip.left > region.right || clip.right < region.left
+		|| clip.top > region.bottom || clip.bottom < region.top)
+		return 0;
+
+	const unsigned long long score = 2
+		+ (clip.left > region.left && clip.left <= region.right)
+		+ (clip.top > region.top && clip.top <= region.bottom)
+		- (clip.bottom == region.bottom && clip.top == region.top)
+		- (clip.left == region.left && clip.right == region.right);
+	const Rect intersection = {
+		max(region.left, clip.left),
+		max(region.top, clip.top),
+		min(region.right, clip.right),
+		min(region.bottom, clip.bottom)
+	};
+	const unsigned long long intersectionArea = (unsigned long long)(intersection.right - intersection.left + 1) * (intersection.bottom - intersection.top + 1);
+	const unsigned long long boundsArea = (unsigned long long)(region.right - region.left + 1) * (region.bottom - region.top + 1);
+	return score * (boundsArea - intersectionArea);
+}
+
+static bool Fits(unsigned int width, unsigned int height, Area area, bool allowRotation) {
+	return (width >= area.width && height >= area.height) || (allowRotation && width >= area.height && height >= area.width);
+}
+
+SparseBin::SparseBin(Area dimensions, unsigned int tileSize, unsigned int activeTileCount)
+	: dimensions(dimensions), tileSize(std::max(tileSize, 1u)),
+	tileColumns(dimensions.width / this->tileSize + (dimensions.width % this->tileSize != 0)),
+	tileRows(dimensions.height / this->tileSize + (dimensions.height % this->tileSize != 0)),
+	activeTileCount(std::max(activeTileCount, 1u)) {
+}
+
+SparseBin::Placement SparseBin::FindPlacement(const Tile & tile, Area area, bool allowRotation) const {
+	// Try every corner of every empty region of the tile, in both orientations, as a Bin does
+	Placement best = { Rect{1, 1, 0, 0}, std::numeric_limits<unsigned long long>::max() };
+	const std::vector<Rect> & regions = tile.bin.GetEmptyRegions();
+	const Area orientations[] = { area, {area.height, area.width} };
+	const unsigned int orientationCount = allowRotation && area.width != area.height ? 2 : 1;
+	for (unsigned int orientation = 0; orientation < orientationCount; orientation++) {
+		const Area size = orientations[orientation];
+		for (const Rect & r : regions) {
+			if (r.right - r.left + 1 < size.width || r.bottom - r.top + 1 < size.height)
+				continue;
+			const unsigned int columns[] = { r.left, r.right + 1 - size.width };
+			const unsigned int rows[] = { r.top, r.bottom + 1 - size.height };
+			for (unsigned int top : rows) {
+				for (unsigned int left : columns) {
+					const Rect clip = { left, top, left + size.width - 1, top + size.height - 1 };
+					unsigned long long score = 0;
+					for (const Rect & region : regions)
+						score += GetClipScore64(region, clip);
+					if (score < best.score) {
+						best = Placement{clip, score};
+						if (score == 0)
+							return best;
+					}
+				}
+			}
+		}
+	}
+	return best;
+}
+
+Rect SparseBin::Pack(unsigned long long key, Tile & tile, Rect rect) {
+	tile.bin.Reserve(rect);
+	UpdateSummary(key, tile);
+	const unsigned long long area = (unsigned long long)(rect.right - rect.left + 1) * (rect.bottom - rect.top + 1);
+	tile.usedArea += area;
+	usedArea += area;
+
+	const Rect tileRect = GetTileRect(key);
+	return Rect{tileRect.left + rect.left, tileRect.top + rect.top, tileRect.left + rect.right, tileRect.top + rect.bottom};
+}
+
+Rect SparseBin::TryPackArea(Area area, bool allowRotation) {
+	if (area.width == 0 || area.height == 0 || !Fits(tileSize, tileSize, area, allowRotation))
+		return Rect{1, 1, 0, 0};
+
+	// Pack into the active tile with the best placement
+	Placement best = { Rect{1, 1, 0, 0}, std::numeric_limits<unsigned long long>::max() };
+	unsigned long long bestKey = 0;
+	for (unsigned long long key : activeTiles) {
+		const Tile & tile = tiles.at(key);
+		if (!Fits(tile.maxWidth, tile.maxHeight, area, allowRotation))
+			continue;
+		const Placement placement = FindPlacement(tile, area, allowRotation);
+		if (placement.score < best.score) {
+			best = placement;
+			bestKey = key;
+		}
+	}
+	if (best.rect.IsValid())
+		return Pack(bestKey, tiles.at(bestKey), best.rect);
+
+	// Then into a new tile
+	unsigned long long key;
+	if (Tile* tile = MaterializeTile(area, allowRotation, key)) {
+		Activate(key);
+		return Pack(key, *tile, FindPlacement(*tile, area, allowRotation).rect);
+	}
+
+	// Once every tile has been materialized, fall back to searching the inactive tiles with enough free space
+	const unsigned int minSide = std::min(area.width, area.height);
+	for (auto i = tilesBySpace.lower_bound({minSide, 0}); i != tilesBySpace.end(); ++i) {
+		const Tile & tile = tiles.at(i->second);
+		if (std::find(activeTiles.begin(), activeTiles.end(), i->second) != activeTiles.end()
+			|| !Fits(tile.maxWidth, tile.maxHeight, area, allowRotation))
+			continue;
+		const Placement placement = FindPlacement(tile, area, allowRotation);
+		if (placement.score < best.score) {
+			best = placement;
+			bestKey = i->second;
+		}
+	}
+	if (!best.rect.IsValid())
+		return best.rect;
+	Activate(bestKey);
+	return Pack(bestKey, tiles.at(bestKey), best.rect);
+}
+
+void SparseBin::Release(Rect rect) {
+	if (!rect.IsValid() || rect.right >= dimensions.width || rect.bottom >= dimensions.height)
+		return;
+	const unsigned long long key = (unsigned long long)(rect.top / tileSize) * tileColumns + rect.left / tileSize;
+	auto i = tiles.find(key);
+	const Rect tileRect = GetTileRect(key);
+	if (i == tiles.end() || rect.right > tileRect.right || rect.bottom > tileRect.bottom)
+		return;
+
+	Tile & tile = i->second;
+	tile.bin.Release(Rect{rect.left - tileRect.left, rect.top - tileRect.top, rect.right - tileRect.left, rect.bottom - tileRect.top});
+	const unsigned long long area = std::min(tile.usedArea, (unsigned long long)(rect.right - rect.left + 1) * (rect.bottom - rect.top + 1));
+	tile.usedArea -= area;
+	usedArea -= area;
+	if (tile.usedArea > 0) {
+		UpdateSummary(key, tile);
+		return;
+	}
+
+	// Forget the tile entirely once it is empty
+	tilesBySpace.erase({std::min(tile.maxWidth, tile.maxHeight), key});
+	tiles.erase(i);
+	activeTiles.erase(std::remove(activeTiles.begin(), activeTiles.end(), key), activeTiles.end());
+	untouchedTiles.push_back(key);
+}
+
+Area SparseBin::GetDimensions() const {
+	return dimensions;
+}
+
+std::vector<Rect> SparseBin::GetEmptyRegions(Rect area) const {
+	std::vector<Rect> regions;
+	if (!area.IsValid() || area.left >= dimensions.width || area.top >= dimensions.height)
+		return regions;
+	area.right = std::min(area.right, dimensions.width - 1);
+	area.bottom = std::min(area.bottom, dimensions.height - 1);
+
+	auto addClipped = [&](Rect r) {
+		r = Rect{std::max(r.left, area.left), std::max(r.top, area.top), std::min(r.right, area.right), std::min(r.bottom, area.bottom)};
+		if (r.IsValid())
+			regions.push_back(r);
+	};
+	for (unsigned int y = area.top / tileSize; y <= area.bottom / tileSize; y++) {
+		for (unsigned int x = area.left / tileSize; x <= area.right / tileSize; x++) {
+			const unsigned long long key = (unsigned long long)y * tileColumns + x;
+			const Rect tileRect = GetTileRect(key);
+			auto i = tiles.find(key);
+			if (i == tiles.end()) {
+				addClipped(tileRect);
+				continue;
+			}
+			for (const Rect & r : i->second.bin.GetEmptyRegions())
+				addClipped(Rect{tileRect.left + r.left, tileRect.top + r.top, tileRect.left + r.right, tileRect.top + r.bottom});
+		}
+	}
+	return regions;
+}
+
+std::size_t SparseBin::GetMaterializedTileCount() const {
+	return tiles.size();
+}
+
+unsigned long long SparseBin::GetUsedArea() const {
+	return usedArea;
+}
+
+Rect SparseBin::GetTileRect(unsigned long long key) const {
+	const unsigned int left = (unsigned int)(key % tileColumns) * tileSize;
+	const unsigned int top = (unsigned int)(key / tileColumns) * tileSize;
+	return Rect{left, top, left + std::min(tileSize, dimensions.width - left) - 1, top + std::min(tileSize, dimensions.height - top) - 1};
+}
+
+SparseBin::Tile* SparseBin::MaterializeTile(Area area, bool allowRotation, unsigned long long& key) {
+	auto fits = [&](unsigned long long k) {
+		const Rect r = GetTileRect(k);
+		return Fits(r.right - r.left + 1, r.bottom - r.top + 1, area, allowRotation);
+	};
+
+	// Prefer tiles that were released or skipped earlier, then continue in order.
+	// Tiles along the right and bottom edges that are too small for the item are skipped for now.
+	auto i = std::find_if(untouchedTiles.rbegin(), untouchedTiles.rend(), fits);
+	if (i != untouchedTiles.rend()) {
+		key = *i;
+		untouchedTiles.erase(std::next(i).base());
+	} else {
+		const unsigned long long tileCount = (unsigned long long)tileColumns * tileRows;
+		while (nextTile < tileCount && !fits(nextTile))
+			untouchedTiles.push_back(nextTile++);
+		if (nextTile == tileCount)
+			return nullptr;
+		key = nextTile++;
+	}
+
+	const Rect tileRect = GetTileRect(key);
+	Tile & tile = tiles[key];
+	tile.bin.ExtendDimensions({tileRect.right - tileRect.left + 1, tileRect.bottom - tileRect.top + 1});
+	UpdateSummary(key, tile);
+	return &tile;
+}
+
+void SparseBin::UpdateSummary(unsigned long long key, Tile & tile) {
+	const unsigned int oldSpace = std::min(tile.maxWidth, tile.maxHeight);
+	tile.maxWidth = tile.maxHeight = 0;
+	for (const Rect & r : tile.bin.GetEmptyRegions()) {
+		tile.maxWidth = std::max(tile.maxWidth, r.right - r.left + 1);
+		tile.maxHeight = std::max(tile.maxHeight, r.bottom - r.top + 1);
+	}
+
+	// Most packs leave the largest empty regions of a tile as they were, and then so is its index entry
+	const unsigned int space = std::min(tile.maxWidth, tile.maxHeight);
+	if (space == oldSpace)
+		return;
+	if (oldSpace > 0)
+		tilesBySpace.erase({oldSpace, key});
+	if (space > 0)
+		tilesBySpace.insert({space, key});
+}
+
+void SparseBin::Activate(unsigned long long key) {
+	if (activeTiles.size() == activeTileCount)
+		activeTiles.erase(activeTiles.begin());
+	activeTiles.push_back(key);
+}
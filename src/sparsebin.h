@@ -0,0 +1,83 @@
+// Bin with very large logical dimensions whose region state is only kept where items are packed.
+// The bin is divided into square tiles, and a tile is only materialized, with a Bin of its own
+// recording its empty regions, once an item is packed into it. Untouched tiles cost no memory, so
+// a bin of a million by a million pixels takes memory in proportion to the area that is used. Items
+// are packed into a few active tiles, materializing the next untouched tile once none of them can
+// fit an item, so the time to pack depends on the size of a tile rather than of the bin. Once every
+// tile is materialized, items that fit no active tile are packed into an inactive tile found through
+// an index of the tiles by their free space, which skips full tiles without visiting them.
+// Placements are scored like those of a Bin, but with 64-bit arithmetic so that large regions
+// don't overflow their scores.
+
+#pragma once
+#include "binpacker.h"
+#include <cstddef>
+#include <set>
+#include <unordered_map>
+#include <utility>
+
+namespace BinPacker
+{
+	/// \brief Bin of very large logical dimensions that materializes tiles as they are packed.
+	class SparseBin {
+		public:
+			/// \brief Creates an empty bin of \a dimensions, which can't be extended later.
+			/// \param tileSize Side of each tile in pixels. Items larger than a tile in either orientation are never packed.
+			/// \param activeTileCount The number of partially filled tiles that items are packed into before a new tile is materialized.
+			explicit SparseBin(Area dimensions, unsigned int tileSize = 256, unsigned int activeTileCount = 4);
+
+			/// \brief Attempts to pack \a area into an active tile, materializing a new tile if none of them can fit it.
+			/// \param allowRotation If false, \a area is never rotated by 90 degrees to fit.
+			/// \return If successful, returns a \see Rect object of the location of the packed area, otherwise returns an invalid \see Rect object.
+			Rect TryPackArea(Area area, bool allowRotation = true);
+			/// \brief Returns the space occupied by \a rect, as returned by \see TryPackArea, to the empty regions of its tile.
+			/// Tiles that become entirely empty are released and may be materialized again later.
+			void Release(Rect rect);
+
+			/// \brief Returns the logical dimensions of the bin, empty or not.
+			Area GetDimensions() const;
+			/// \brief Returns the empty regions that intersect \a area, clipped to it, including untouched tiles as single regions.
+			std::vector<Rect> GetEmptyRegions(Rect area) const;
+			/// \brief Returns the number of tiles that are currently materialized.
+			std::size_t GetMaterializedTileCount() const;
+			/// \brief Returns the total area of the items currently packed.
+			unsigned long long GetUsedArea() const;
+		private:
+			struct Tile {
+				// Empty regions of the tile in coordinates relative to its top-left corner
+				Bin bin;
+				unsigned long long usedArea = 0;
+				// Largest width and height of the tile's empty regions, to skip tiles that can't fit an item
+				unsigned int maxWidth = 0, maxHeight = 0;
+			};
+			// Best placement found in a tile, in tile coordinates
+			struct Placement {
+				Rect rect;
+				unsigned long long score;
+			};
+
+			Placement FindPlacement(const Tile& tile, Area area, bool allowRotation) const;
+			Rect Pack(unsigned long long key, Tile& tile, Rect rect);
+			Rect GetTileRect(unsigned long long key) const;
+			void UpdateSummary(unsigned long long key, Tile& tile);
+			// Materializes the next untouched tile that can fit area, or returns null if there is none
+			Tile* MaterializeTile(Area area, bool allowRotation, unsigned long long& key);
+			void Activate(unsigned long long key);
+
+			const Area dimensions;
+			const unsigned int tileSize;
+			const unsigned int tileColumns, tileRows;
+			const unsigned int activeTileCount;
+			// Materialized tiles by their row times the number of tile columns plus their column
+			std::unordered_map<unsigned long long, Tile> tiles;
+			// Materialized tiles with any free space by the smaller of their largest empty region width and height, which is
+			// at least the smaller side of any item that fits them
+			std::set<std::pair<unsigned int, unsigned long long>> tilesBySpace;
+			// Keys of the tiles that items are packed into, most recently activated last
+			std::vector<unsigned long long> activeTiles;
+			// Untouched tiles are materialized in order from this key, then from those skipped or released behind it
+			unsigned long long nextTile = 0;
+			std::vector<unsigned long long> untouchedTiles;
+			unsigned long long usedArea = 0;
+	};
+}
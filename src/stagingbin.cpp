@@ -0,0 +1,79 @@
+#include "stagingbin.h"
+
+using namespace BinPacker;
+
+Rect StagingBin::TryPackArea(Area area) {
+	if (!IsValid())
+		return Rect{1, 1, 0, 0};
+
+	Rect packed = bin.TryPackArea(area, constraints);
+	if (!packed.IsValid())
+		return packed;
+	return Rect{packed.left + block.left, packed.top + block.top, packed.right + block.left, packed.bottom + block.top};
+}
+
+bool StagingBin::IsValid() const {
+	return block.IsValid();
+}
+
+Rect StagingBin::GetBlock() const {
+	return block;
+}
+
+SharedBin::SharedBin(Bin bin)
+	: bin(std::move(bin)) {
+}
+
+StagingBin SharedBin::Lease(Area blockSize, const PackConstraints & constraints) {
+	// Items in the block are padded against the block's edges instead, so neighbouring blocks and items still end up padded from each other
+	// The block isn't rotated, since its staging bin is laid out with the requested width and height
+	PackConstraints blockConstraints;
+	blockConstraints.positionAlignment = constraints.positionAlignment;
+	blockConstraints.allowRotation = false;
+
+	StagingBin staging;
+	{
+		std::lock_guard<std::mutex> lock(binMutex);
+		staging.block = bin.TryPackArea(blockSize, blockConstraints);
+	}
+	if (!staging.IsValid())
+		return staging;
+
+	staging.constraints = constraints;
+	staging.constraints.padBinEdges = true;
+	staging.bin.ExtendDimensions(blockSize);
+	return staging;
+}
+
+void SharedBin::Return(StagingBin && staging) {
+	if (!staging.IsValid())
+		return;
+
+	const Rect block = staging.block;
+	std::vector<Rect> emptyRegions = staging.bin.GetEmptyRegions();
+	staging = StagingBin();
+
+	std::lock_guard<std::mutex> lock(binMutex);
+	for (const Rect & r : emptyRegions)
+		bin.Release(Rect{r.left + block.left, r.top + block.top, r.right + block.left, r.bottom + block.top});
+}
+
+Rect SharedBin::TryPackArea(Area area, const PackConstraints & constraints) {
+	std::lock_guard<std::mutex> lock(binMutex);
+	return bin.TryPackArea(area, constraints);
+}
+
+void SharedBin::ExtendDimensions(Area extension) {
+	std::lock_guard<std::mutex> lock(binMutex);
+	bin.ExtendDimensions(extension);
+}
+
+Area SharedBin::GetDimensions() const {
+	std::lock_guard<std::mutex> lock(binMutex);
+	return bin.GetDimensions();
+}
+
+std::vector<Rect> SharedBin::GetEmptyRegions() const {
+	std::lock_guard<std::mutex> lock(binMutex);
+	return bin.GetEmptyRegions();
+}
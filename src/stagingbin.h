@@ -0,0 +1,65 @@
+// Thread-local staging of packs into a shared Bin.
+// A producer thread leases a fixed size block from a SharedBin and packs its items into a private
+// Bin covering the block, so the shared bin is only locked once per block rather than once per
+// item. When the producer is done, returning the lease releases the block's remaining empty
+// regions back into the shared bin, where they merge with the surrounding empty space and can be
+// packed by anyone.
+
+#pragma once
+#include "binpacker.h"
+#include <mutex>
+
+namespace BinPacker
+{
+	class SharedBin;
+
+	/// \brief Block of a \see SharedBin leased for the private use of one thread.
+	class StagingBin {
+		public:
+			/// \brief Creates an invalid staging bin that doesn't lease any block.
+			StagingBin() = default;
+
+			/// \brief Attempts to pack \a area into the leased block with the constraints the block was leased with.
+			/// Padding is reserved along every edge of the block regardless of \see PackConstraints::padBinEdges.
+			/// \return If successful, returns a \see Rect object of the location of the packed area in the coordinates of the shared bin, otherwise returns an invalid \see Rect object.
+			Rect TryPackArea(Area area);
+
+			/// \brief Returns true if the staging bin leases a block.
+			bool IsValid() const;
+			/// \brief Returns the leased block in the coordinates of the shared bin.
+			Rect GetBlock() const;
+		private:
+			friend class SharedBin;
+
+			Rect block = {1, 1, 0, 0};
+			PackConstraints constraints;
+			Bin bin;
+	};
+
+	/// \brief \see Bin that leases blocks to \see StagingBin objects. Every method is safe to call from any thread.
+	class SharedBin {
+		public:
+			/// \brief Takes ownership of \a bin.
+			explicit SharedBin(Bin bin);
+
+			/// \brief Reserves a block of \a blockSize, never rotated, for packing with \a constraints.
+			/// The block's position honours the position alignment of \a constraints, while its padding is reserved within the block.
+			/// \return The lease, which is invalid if no block of \a blockSize is available.
+			StagingBin Lease(Area blockSize, const PackConstraints& constraints = PackConstraints());
+			/// \brief Releases the empty regions of \a staging back into the shared bin and invalidates it. Areas packed into it remain packed.
+			void Return(StagingBin&& staging);
+
+			/// \brief Attempts to pack \a area directly into the shared bin. \see Bin::TryPackArea
+			Rect TryPackArea(Area area, const PackConstraints& constraints = PackConstraints());
+			/// \brief Increases the dimensions of the bin.
+			void ExtendDimensions(Area extension);
+
+			/// \brief Returns the dimensions of the bin, empty or not.
+			Area GetDimensions() const;
+			/// \brief Returns a copy of the empty regions of the bin, excluding the empty space of leased blocks.
+			std::vector<Rect> GetEmptyRegions() const;
+		private:
+			mutable std::mutex binMutex;
+			Bin bin;
+	};
+}
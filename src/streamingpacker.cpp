@@ -0,0 +1,134 @@
+#include "streamingpacker.h"
+#include "mappedfile.h"
+#include <algorithm>
+#include <memory>
+
+using namespace BinPacker;
+
+static const unsigned char placementMagic[4] = {'B', 'P', 'S', '1'};
+static const std::size_t headerSize = 24;
+static const std::size_t itemSize = 8;
+static const std::size_t recordSize = 20;
+
+static unsigned int ReadUint(const unsigned char* data) {
+	return data[0] | (data[1] << 8) | (data[2] << 16) | ((unsigned int)data[3] << 24);
+}
+
+static void WriteUint(unsigned char* data, unsigned long long value, unsigned int bytes = 4) {
+	for (unsigned int i = 0; i < bytes; i++)
+		data[i] = (unsigned char)(value >> (i * 8));
+}
+
+namespace {
+	struct Page {
+		Bin bin;
+		unsigned int index;
+		unsigned long long usedArea = 0;
+		std::size_t memory = 0;
+	};
+}
+
+// Approximates the memory held by a page, counting the scratch space its bin keeps alongside its empty regions
+static std::size_t GetPageMemory(const Page & page) {
+	return sizeof(Page) + 2 * page.bin.GetEmptyRegions().capacity() * sizeof(Rect);
+}
+
+bool BinPacker::PackFile(const std::string& itemPath, const std::string& placementPath, const StreamingSettings& settings, StreamingStats* stats) {
+	using namespace std;
+
+	MappedFile items, placements;
+	if (!items.Open(itemPath) || items.GetSize() % itemSize != 0)
+		return false;
+	const unsigned long long itemCount = items.GetSize() / itemSize;
+	if (!placements.Create(placementPath, headerSize + itemCount * recordSize))
+		return false;
+
+	// A quarter of the budget goes to the windows of the two files, and the rest to the open pages
+	const size_t windowSize = min<size_t>(max<size_t>(settings.memoryBudget / 8, 1 << 16), 16 << 20);
+	const size_t windowItems = windowSize / itemSize, windowRecords = windowSize / recordSize;
+	const size_t pageBudget = settings.memoryBudget - min(settings.memoryBudget, 2 * windowSize);
+	const unsigned int maxOpenPages = max(settings.maxOpenPages, 1u);
+	const Area pageDimensions = settings.pageDimensions;
+	const PackConstraints & constraints = settings.constraints;
+
+	StreamingStats result;
+	result.itemCount = itemCount;
+	vector<unique_ptr<Page>> pages;
+	size_t pageMemory = 0;
+	auto closeFullestPage = [&]() {
+		auto fullest = max_element(pages.begin(), pages.end(), [](const unique_ptr<Page> & a, const unique_ptr<Page> & b) { return a->usedArea < b->usedArea; });
+		pageMemory -= (*fullest)->memory;
+		pages.erase(fullest);
+	};
+	const unsigned char* itemWindow = nullptr;
+	unsigned char* recordWindow = nullptr;
+	for (unsigned long long i = 0; i < itemCount; i++) {
+		if (i % windowItems == 0 && (itemWindow = items.Map(i * itemSize, (size_t)min<unsigned long long>(windowItems, itemCount - i) * itemSize)) == nullptr)
+			return false;
+		if (i % windowRecords == 0 && (recordWindow = placements.Map(headerSize + i * recordSize, (size_t)min<unsigned long long>(windowRecords, itemCount - i) * recordSize)) == nullptr)
+			return false;
+		const unsigned char* item = itemWindow + (i % windowItems) * itemSize;
+		const Area area = { ReadUint(item), ReadUint(item + 4) };
+
+		// Pack into the first open page that fits the item, otherwise into a new page
+		Rect packed = {1, 1, 0, 0};
+		Page* page = nullptr;
+		for (auto & p : pages) {
+			packed = p->bin.TryPackArea(area, constraints);
+			if (packed.IsValid()) {
+				page = p.get();
+				break;
+			}
+		}
+		if (page == nullptr) {
+			unique_ptr<Page> newPage(new Page());
+			newPage->bin.ExtendDimensions(pageDimensions);
+			packed = newPage->bin.TryPackArea(area, constraints);
+			if (packed.IsValid()) {
+				if (pages.size() == maxOpenPages)
+					closeFullestPage();
+				newPage->index = result.pageCount++;
+				page = newPage.get();
+				pages.push_back(move(newPage));
+				result.peakOpenPages = max(result.peakOpenPages, (unsigned int)pages.size());
+			}
+		}
+
+		unsigned char* record = recordWindow + (i % windowRecords) * recordSize;
+		if (page == nullptr) {
+			WriteUint(record, 0xFFFFFFFF);
+			fill(record + 4, record + recordSize, (unsigned char)0);
+			continue;
+		}
+		WriteUint(record, page->index);
+		WriteUint(record + 4, packed.left);
+		WriteUint(record + 8, packed.top);
+		WriteUint(record + 12, packed.right);
+		WriteUint(record + 16, packed.bottom);
+		result.packedCount++;
+
+		page->usedArea += (unsigned long long)area.width * area.height;
+		pageMemory -= page->memory;
+		page->memory = GetPageMemory(*page);
+		pageMemory += page->memory;
+
+		// Close the fullest pages until the rest fit in the budget
+		while (pageMemory > pageBudget && pages.size() > 1)
+			closeFullestPage();
+	}
+
+	unsigned char* header = placements.Map(0, headerSize);
+	if (header == nullptr)
+		return false;
+	copy(placementMagic, placementMagic + 4, header);
+	WriteUint(header + 4, pageDimensions.width);
+	WriteUint(header + 8, pageDimensions.height);
+	WriteUint(header + 12, result.pageCount);
+	WriteUint(header + 16, itemCount, 8);
+	if (!placements.Flush())
+		return false;
+
+	if (stats != nullptr)
+		*stats = result;
+	return true;
+}
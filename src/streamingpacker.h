@@ -0,0 +1,46 @@
+// Packing of item lists too large to hold in memory into many fixed-size pages.
+// Items are read in order from a memory-mapped file of little-endian 32-bit width and height pairs,
+// one window at a time. Each item is packed into the first open page that can fit it, and a new page
+// is opened when none can. Only open pages keep their empty regions in memory: once there are too
+// many open pages, or their regions would exceed the memory budget, the fullest page is closed and
+// its regions are discarded. Placements are written through a memory-mapped window onto the
+// placement file as they are made, so memory use doesn't grow with the number of items.
+//
+// The placement file starts with a header of the magic "BPS1", the page width, page height and page
+// count as little-endian 32-bit values and the item count as a 64-bit value. It is followed by a
+// record of the page, left, top, right and bottom of each item's placement as 32-bit values, in the
+// order of the items. Items that are larger than a page have a page of 0xFFFFFFFF.
+
+#pragma once
+#include "binpacker.h"
+#include <cstddef>
+#include <string>
+
+namespace BinPacker
+{
+	/// \brief Settings for packing a file of items into pages.
+	struct StreamingSettings {
+		/// \brief Dimensions of every page.
+		Area pageDimensions = {1024, 1024};
+		PackConstraints constraints;
+		/// \brief The number of pages that items are packed into before the fullest is closed.
+		unsigned int maxOpenPages = 16;
+		/// \brief Approximate limit in bytes on the memory used for open pages and for the mapped windows of the files.
+		std::size_t memoryBudget = 256 << 20;
+	};
+
+	/// \brief Statistics of packing a file of items.
+	struct StreamingStats {
+		unsigned long long itemCount = 0;
+		/// \brief The number of items that were packed, which excludes items larger than a page.
+		unsigned long long packedCount = 0;
+		unsigned int pageCount = 0;
+		/// \brief The largest number of pages open at once.
+		unsigned int peakOpenPages = 0;
+	};
+
+	/// \brief Packs the items in the file at \a itemPath into pages and writes their placements to \a placementPath.
+	/// \param stats If not null, receives statistics of the packing.
+	/// \return False if either file couldn't be read or written, or if the item file isn't a whole number of items.
+	bool PackFile(const std::string& itemPath, const std::string& placementPath, const StreamingSettings& settings = StreamingSettings(), StreamingStats* stats = nullptr);
+}
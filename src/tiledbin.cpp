@@ -0,0 +1,329 @@
+#include "tiledbin.h"
+#include <algorithm>
+#include <limits>
+
+using namespace BinPacker;
+
+// Defined in binpacker.cpp, so that placements are scored exactly as they are by a Bin
+int GetClipScore(Rect region, Rect clip);
+std::vector<Rect> GetMaximalRects(const std::vector<Rect> & space, Rect target);
+
+// Returns rect extended by a pixel on each side, to find the regions that touch it
+static Rect Expand(Rect rect) {
+	return Rect{rect.left - (rect.left > 0), rect.top - (rect.top > 0), rect.right + 1, rect.bottom + 1};
+}
+
+static bool Intersects(const Rect & a, const Rect & b) {
+	return a.left <= b.right && a.right >= b.left && a.top <= b.bottom && a.bottom >= b.top;
+}
+
+static bool Contains(const Rect & outer, const Rect & inner) {
+	return outer.left <= inner.left && outer.top <= inner.top && outer.right >= inner.right && outer.bottom >= inner.bottom;
+}
+
+TiledBin::TiledBin(Area dimensions, unsigned int tileSize)
+	: tileSize(std::max(tileSize, 1u)) {
+	Rebuild({});
+	ExtendDimensions(dimensions);
+}
+
+template <typename F>
+void TiledBin::ForEachRegion(Rect area, F f) const {
+	if (tiles.empty())
+		return;
+	const unsigned int lastColumn = std::min(area.right / tileSize, tileColumns - 1);
+	const unsigned int lastRow = std::min(area.bottom / tileSize, tileRows - 1);
+	for (unsigned int y = area.top / tileSize; y <= lastRow; y++) {
+		for (unsigned int x = area.left / tileSize; x <= lastColumn; x++) {
+			for (unsigned int index : tiles[y * tileColumns + x].regions) {
+				// A region overlapping several of the tiles is only visited in the tile containing the top-left corner of its intersection with area
+				const Rect & r = regions[index];
+				if (Intersects(r, area) && std::max(r.left, area.left) / tileSize == x && std::max(r.top, area.top) / tileSize == y)
+					f(index, r);
+			}
+		}
+	}
+}
+
+template <typename F>
+bool TiledBin::ForEachCandidate(unsigned int level, unsigned int x, unsigned int y, Area area, bool allowRotation, F f) const {
+	auto fits = [&](unsigned int width, unsigned int height) {
+		return (width >= area.width && height >= area.height) || (allowRotation && width >= area.height && height >= area.width);
+	};
+
+	const unsigned int columns = (tileColumns + (1u << level) - 1) >> level;
+	const unsigned int rows = (tileRows + (1u << level) - 1) >> level;
+	if (x >= columns || y >= rows)
+		return true;
+	const Summary & summary = levels[level][y * columns + x];
+	if (!fits(summary.maxWidth, summary.maxHeight))
+		return true;
+
+	if (level > 0) {
+		for (unsigned int child = 0; child < 4; child++) {
+			if (!ForEachCandidate(level - 1, x * 2 + child % 2, y * 2 + child / 2, area, allowRotation, f))
+				return false;
+		}
+		return true;
+	}
+	for (unsigned int index : tiles[y * tileColumns + x].owned) {
+		const Rect & r = regions[index];
+		if (fits(r.right - r.left + 1, r.bottom - r.top + 1) && !f(index, r))
+			return false;
+	}
+	return true;
+}
+
+void TiledBin::FindRegions(Rect area, std::vector<unsigned int>& indices) const {
+	indices.clear();
+	ForEachRegion(area, [&indices](unsigned int index, const Rect &) { indices.push_back(index); });
+}
+
+Rect TiledBin::TryPackArea(Area area, bool allowRotation) {
+	using namespace std;
+
+	int minScore = numeric_limits<int>::max();
+	Rect best = {1, 1, 0, 0};
+	if (area.width == 0 || area.height == 0)
+		return best;
+
+	// Try each corner of each region large enough for the area, in both orientations, scoring each
+	// against the regions it would clip. Regions it doesn't intersect add nothing to the score.
+	const Area orientations[] = { area, {area.height, area.width} };
+	const unsigned int orientationCount = allowRotation && area.width != area.height ? 2 : 1;
+	ForEachCandidate((unsigned int)levels.size() - 1, 0, 0, area, allowRotation, [&](unsigned int, const Rect & r) {
+		for (unsigned int orientation = 0; orientation < orientationCount; orientation++) {
+			const Area size = orientations[orientation];
+			if (r.right - r.left + 1 < size.width || r.bottom - r.top + 1 < size.height)
+				continue;
+			const unsigned int columns[] = { r.left, r.right + 1 - size.width };
+			const unsigned int rows[] = { r.top, r.bottom + 1 - size.height };
+			for (unsigned int top : rows) {
+				for (unsigned int left : columns) {
+					const Rect clip = { left, top, left + size.width - 1, top + size.height - 1 };
+					unsigned int score = 0;
+					ForEachRegion(clip, [&](unsigned int, const Rect & region) { score += (unsigned int)GetClipScore(region, clip); });
+					if ((int)score < minScore) {
+						minScore = (int)score;
+						best = clip;
+						if (minScore == 0)
+							return false;
+					}
+				}
+			}
+		}
+		return true;
+	});
+	if (!best.IsValid())
+		return best;
+
+	ClipEmptyRegions(best);
+	UpdateSummaries();
+	return best;
+}
+
+void TiledBin::Release(Rect rect) {
+	if (!rect.IsValid() || rect.right >= dimensions.width || rect.bottom >= dimensions.height)
+		return;
+
+	// As in a Bin, the maximal empty rectangles including the released space lie within it and the regions bordering it
+	std::vector<Rect> space = { rect };
+	ForEachRegion(Expand(rect), [&space](unsigned int, const Rect & r) { space.push_back(r); });
+	for (const Rect & r : GetMaximalRects(space, rect))
+		InsertEmptyRegion(r);
+	UpdateSummaries();
+}
+
+void TiledBin::ExtendDimensions(Area extension) {
+	// Extending is rare, so the regions are extended by a Bin and the tiles are rebuilt around them
+	Bin bin(dimensions, GetEmptyRegions());
+	bin.ExtendDimensions(extension);
+	dimensions = bin.GetDimensions();
+	Rebuild(bin.GetEmptyRegions());
+}
+
+Area TiledBin::GetDimensions() const {
+	return dimensions;
+}
+
+std::vector<Rect> TiledBin::GetEmptyRegions() const {
+	std::vector<Rect> emptyRegions;
+	emptyRegions.reserve(regions.size() - freeSlots.size());
+	for (const Rect & r : regions) {
+		if (r.IsValid())
+			emptyRegions.push_back(r);
+	}
+	return emptyRegions;
+}
+
+void TiledBin::AddRegion(Rect region) {
+	unsigned int index;
+	if (freeSlots.empty()) {
+		index = (unsigned int)regions.size();
+		regions.push_back(region);
+	} else {
+		index = freeSlots.back();
+		freeSlots.pop_back();
+		regions[index] = region;
+	}
+
+	for (unsigned int y = region.top / tileSize; y <= region.bottom / tileSize; y++) {
+		for (unsigned int x = region.left / tileSize; x <= region.right / tileSize; x++)
+			tiles[y * tileColumns + x].regions.push_back(index);
+	}
+
+	// A new region can only grow the summaries of its owner and the owner's ancestors
+	const unsigned int width = region.right - region.left + 1, height = region.bottom - region.top + 1;
+	unsigned int x = region.left / tileSize, y = region.top / tileSize;
+	tiles[y * tileColumns + x].owned.push_back(index);
+	for (unsigned int level = 0; level < levels.size(); level++, x /= 2, y /= 2) {
+		Summary & summary = levels[level][y * ((tileColumns + (1u << level) - 1) >> level) + x];
+		summary.maxWidth = std::max(summary.maxWidth, width);
+		summary.maxHeight = std::max(summary.maxHeight, height);
+	}
+}
+
+void TiledBin::RemoveRegion(unsigned int index) {
+	const Rect region = regions[index];
+	for (unsigned int y = region.top / tileSize; y <= region.bottom / tileSize; y++) {
+		for (unsigned int x = region.left / tileSize; x <= region.right / tileSize; x++) {
+			std::vector<unsigned int> & indices = tiles[y * tileColumns + x].regions;
+			*std::find(indices.begin(), indices.end(), index) = indices.back();
+			indices.pop_back();
+		}
+	}
+
+	const unsigned int owner = region.top / tileSize * tileColumns + region.left / tileSize;
+	std::vector<unsigned int> & owned = tiles[owner].owned;
+	*std::find(owned.begin(), owned.end(), index) = owned.back();
+	owned.pop_back();
+	const Summary & summary = levels[0][owner];
+	if (region.right - region.left + 1 == summary.maxWidth || region.bottom - region.top + 1 == summary.maxHeight)
+		staleTiles.push_back(owner);
+	regions[index] = Rect{1, 1, 0, 0};
+	freeSlots.push_back(index);
+}
+
+void TiledBin::ClipEmptyRegions(Rect clip) {
+	using namespace std;
+
+	// Remove regions that are clipped and create new empty regions of what remains
+	vector<Rect> remaining;
+	FindRegions(clip, scratch);
+	for (unsigned int index : scratch) {
+		const Rect r = regions[index];
+		if (clip.left > r.left)
+			remaining.push_back(Rect{ r.left, r.top, clip.left - 1, r.bottom });
+		if (clip.top > r.top)
+			remaining.push_back(Rect{ r.left, r.top, r.right, clip.top - 1 });
+		if (clip.right < r.right)
+			remaining.push_back(Rect{ clip.right + 1, r.top, r.right, r.bottom });
+		if (clip.bottom < r.bottom)
+			remaining.push_back(Rect{ r.left, clip.bottom + 1, r.right, r.bottom });
+		RemoveRegion(index);
+	}
+
+	for (Rect newRegion : remaining) {
+		// If the new region has the same width, left position, and intersects
+		// an existing region, or likewise with height, then merge them instead.
+		unsigned int merge = numeric_limits<unsigned int>::max();
+		ForEachRegion(newRegion, [&](unsigned int index, const Rect & r) {
+			if (merge == numeric_limits<unsigned int>::max()
+				&& ((newRegion.left == r.left && newRegion.right == r.right) || (newRegion.top == r.top && newRegion.bottom == r.bottom)))
+				merge = index;
+		});
+		if (merge != numeric_limits<unsigned int>::max()) {
+			const Rect & r = regions[merge];
+			newRegion = Rect{ min(r.left, newRegion.left), min(r.top, newRegion.top), max(r.right, newRegion.right), max(r.bottom, newRegion.bottom) };
+			RemoveRegion(merge);
+		}
+		AddRegion(newRegion);
+	}
+}
+
+void TiledBin::InsertEmptyRegion(Rect region) {
+	using namespace std;
+
+	bool contained = false;
+	ForEachRegion(region, [&](unsigned int, const Rect & r) { contained = contained || Contains(r, region); });
+	if (contained)
+		return;
+
+	for (bool merged = true; merged;) {
+		FindRegions(region, scratch);
+		for (unsigned int index : scratch) {
+			if (Contains(region, regions[index]))
+				RemoveRegion(index);
+		}
+
+		// Unlike when clipping, regions that merely touch are merged too, since released space borders packed areas
+		unsigned int merge = numeric_limits<unsigned int>::max();
+		ForEachRegion(Expand(region), [&](unsigned int index, const Rect & r) {
+			if (merge == numeric_limits<unsigned int>::max()
+				&& ((region.left == r.left && region.right == r.right) || (region.top == r.top && region.bottom == r.bottom)))
+				merge = index;
+		});
+		merged = merge != numeric_limits<unsigned int>::max();
+		if (merged) {
+			const Rect & r = regions[merge];
+			region = Rect{ min(r.left, region.left), min(r.top, region.top), max(r.right, region.right), max(r.bottom, region.bottom) };
+			RemoveRegion(merge);
+		}
+	}
+
+	AddRegion(region);
+}
+
+void TiledBin::UpdateSummaries() {
+	std::sort(staleTiles.begin(), staleTiles.end());
+	staleTiles.erase(std::unique(staleTiles.begin(), staleTiles.end()), staleTiles.end());
+	for (unsigned int tile : staleTiles) {
+		unsigned int x = tile % tileColumns, y = tile / tileColumns;
+		Summary summary = {0, 0};
+		for (unsigned int index : tiles[tile].owned) {
+			const Rect & r = regions[index];
+			summary.maxWidth = std::max(summary.maxWidth, r.right - r.left + 1);
+			summary.maxHeight = std::max(summary.maxHeight, r.bottom - r.top + 1);
+		}
+		levels[0][tile] = summary;
+
+		// Each ancestor summarizes its (up to) four children
+		for (unsigned int level = 1; level < levels.size(); level++) {
+			const unsigned int childColumns = (tileColumns + (1u << (level - 1)) - 1) >> (level - 1);
+			const unsigned int childRows = (tileRows + (1u << (level - 1)) - 1) >> (level - 1);
+			x /= 2;
+			y /= 2;
+			summary = {0, 0};
+			for (unsigned int cy = y * 2; cy < std::min(y * 2 + 2, childRows); cy++) {
+				for (unsigned int cx = x * 2; cx < std::min(x * 2 + 2, childColumns); cx++) {
+					const Summary & child = levels[level - 1][cy * childColumns + cx];
+					summary.maxWidth = std::max(summary.maxWidth, child.maxWidth);
+					summary.maxHeight = std::max(summary.maxHeight, child.maxHeight);
+				}
+			}
+			levels[level][y * ((childColumns + 1) / 2) + x] = summary;
+		}
+	}
+	staleTiles.clear();
+}
+
+void TiledBin::Rebuild(const std::vector<Rect>& emptyRegions) {
+	tileColumns = (dimensions.width + tileSize - 1) / tileSize;
+	tileRows = (dimensions.height + tileSize - 1) / tileSize;
+	tiles.assign((size_t)tileColumns * tileRows, Tile());
+
+	levels.clear();
+	unsigned int columns = tileColumns, rows = tileRows;
+	levels.emplace_back((size_t)columns * rows, Summary{0, 0});
+	while (columns > 1 || rows > 1) {
+		columns = (columns + 1) / 2;
+		rows = (rows + 1) / 2;
+		levels.emplace_back((size_t)columns * rows, Summary{0, 0});
+	}
+
+	regions.clear();
+	freeSlots.clear();
+	staleTiles.clear();
+	for (const Rect & r : emptyRegions)
+		AddRegion(r);
+}
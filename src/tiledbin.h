@@ -0,0 +1,77 @@
+// Bin whose empty regions are indexed by a grid of tiles to avoid searching all of them.
+// A Bin compares every candidate placement against every empty region, so each pack takes time
+// proportional to the square of the number of regions. The tiled bin keeps the same empty regions
+// and scoring, but lists each region in every tile it overlaps, so scoring a placement only visits
+// the regions of the tiles it covers. Each region is owned by the tile that contains its top-left
+// corner, and a quadtree over the tiles records the widest and tallest region owned within each
+// node, so the search skips whole quadrants that own no region large enough for the item. Regions
+// aren't split at tile borders, so items pack about as tightly as they would into a Bin. Candidates
+// are visited in tile order rather than in the order of the bin's regions, so placements with equal
+// scores are resolved differently and layouts diverge from a Bin's, with equivalent utilisation.
+
+#pragma once
+#include "binpacker.h"
+
+namespace BinPacker
+{
+	/// \brief \see Bin that indexes its empty regions by tile.
+	class TiledBin {
+		public:
+			/// \brief Creates an empty bin of \a dimensions.
+			/// \param tileSize Side of each tile in pixels. Smaller tiles narrow the search but list large regions in more tiles.
+			explicit TiledBin(Area dimensions = {0, 0}, unsigned int tileSize = 128);
+
+			/// \brief Attempts to locate an optimal area in the bin for packing \a area, scored as by \see Bin::TryPackArea.
+			/// \param allowRotation If false, \a area is never rotated by 90 degrees to fit.
+			/// \return If successful, returns a \see Rect object of the location of the packed area, otherwise returns an invalid \see Rect object.
+			Rect TryPackArea(Area area, bool allowRotation = true);
+			/// \brief Returns the space occupied by \a rect to the empty regions of the bin.
+			/// \a rect must lie within the bin and must not overlap any area that is still packed.
+			void Release(Rect rect);
+			/// \brief Increases the dimensions of the bin.
+			void ExtendDimensions(Area extension);
+
+			/// \brief Returns the dimensions of the bin, empty or not.
+			Area GetDimensions() const;
+			/// \brief Returns a copy of the empty regions of the bin.
+			std::vector<Rect> GetEmptyRegions() const;
+		private:
+			struct Tile {
+				// Indices of the regions that overlap the tile, and of those whose top-left corner lies within it
+				std::vector<unsigned int> regions, owned;
+			};
+			// Widest and tallest region owned by a tile or quadtree node
+			struct Summary {
+				unsigned int maxWidth, maxHeight;
+			};
+
+			// Calls f(index, region) once for each region that intersects area
+			template <typename F>
+			void ForEachRegion(Rect area, F f) const;
+			// Calls f(index, region) for each region owned by the tiles of the quadtree node at (x, y) of level that could fit area,
+			// until f returns false, in which case false is returned
+			template <typename F>
+			bool ForEachCandidate(unsigned int level, unsigned int x, unsigned int y, Area area, bool allowRotation, F f) const;
+			void FindRegions(Rect area, std::vector<unsigned int>& indices) const;
+			void AddRegion(Rect region);
+			void RemoveRegion(unsigned int index);
+			void ClipEmptyRegions(Rect clip);
+			void InsertEmptyRegion(Rect region);
+			void UpdateSummaries();
+			void Rebuild(const std::vector<Rect>& emptyRegions);
+
+			Area dimensions = {0, 0};
+			const unsigned int tileSize;
+			unsigned int tileColumns = 0;
+			unsigned int tileRows = 0;
+			std::vector<Tile> tiles;
+			// Summaries of the tiles, followed by each coarser level of the quadtree up to a single root
+			std::vector<std::vector<Summary>> levels;
+			// Regions by index, with invalid rects in slots that are free to reuse
+			std::vector<Rect> regions;
+			std::vector<unsigned int> freeSlots;
+			// Tiles that lost an owned region, whose summaries may have shrunk
+			std::vector<unsigned int> staleTiles;
+			std::vector<unsigned int> scratch;
+	};
+}
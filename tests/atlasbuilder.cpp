@@ -0,0 +1,95 @@
+#include "check.h"
+#include "atlasbuilder.h"
+#include <cstring>
+#include <filesystem>
+
+using namespace BinPacker;
+
+// Writes an RGBA PAM image whose pixels are opaque within opaque, or transparent with nonzero colour samples elsewhere
+static std::vector<unsigned char> WriteImage(const std::string& path, Area dimensions, Rect opaque) {
+	std::vector<unsigned char> pixels((std::size_t)dimensions.width * dimensions.height * 4);
+	for (unsigned int y = 0; y < dimensions.height; y++) {
+		for (unsigned int x = 0; x < dimensions.width; x++) {
+			unsigned char* pixel = &pixels[((std::size_t)y * dimensions.width + x) * 4];
+			pixel[0] = (unsigned char)(x * 7 + 1);
+			pixel[1] = (unsigned char)(y * 13 + 1);
+			pixel[2] = 200;
+			pixel[3] = opaque.IsValid() && x >= opaque.left && x <= opaque.right && y >= opaque.top && y <= opaque.bottom ? 255 : 0;
+		}
+	}
+	std::FILE* file = std::fopen(path.c_str(), "wb");
+	std::fprintf(file, "P7\nWIDTH %u\nHEIGHT %u\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n", dimensions.width, dimensions.height);
+	std::fwrite(pixels.data(), 1, pixels.size(), file);
+	std::fclose(file);
+	return pixels;
+}
+
+static bool SameRect(Rect a, Rect b) {
+	return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+// Trimmed sprites are packed and copied at their opaque bounds, rotated or not, and entirely transparent sprites aren't copied
+static void TestTrimmedComposite() {
+	const std::vector<unsigned char> margin = WriteImage("atlasbuildertest0.pam", {20, 12}, Rect{3, 2, 15, 8});
+	const std::vector<unsigned char> rotated = WriteImage("atlasbuildertest1.pam", {9, 17}, Rect{1, 4, 6, 14});
+	WriteImage("atlasbuildertest2.pam", {16, 16}, Rect{1, 1, 0, 0});
+
+	std::vector<Sprite> sprites(3);
+	for (std::size_t i = 0; i < sprites.size(); i++)
+		sprites[i].path = "atlasbuildertest" + std::to_string(i) + ".pam";
+	const Area trimmed0 = TrimSprite(sprites[0]), trimmed1 = TrimSprite(sprites[1]), trimmed2 = TrimSprite(sprites[2]);
+	CHECK(SameRect(sprites[0].bounds, Rect{3, 2, 15, 8}) && trimmed0.width == 13 && trimmed0.height == 7);
+	CHECK(SameRect(sprites[1].bounds, Rect{1, 4, 6, 14}) && trimmed1.width == 6 && trimmed1.height == 11);
+	CHECK(sprites[2].trimmed && !sprites[2].bounds.IsValid() && trimmed2.width == 0 && trimmed2.height == 0);
+
+	// The second sprite is placed rotated, and the transparent one is given a placement that must stay untouched
+	sprites[0].placement = {0, 0, 12, 6};
+	sprites[1].placement = {20, 0, 30, 5};
+	sprites[2].placement = {0, 16, 15, 31};
+	AtlasBuilder atlas({32, 32}, 4);
+	CHECK(atlas.Composite(sprites, 2).empty());
+
+	const std::vector<unsigned char> & pixels = atlas.GetPixels();
+	auto atlasPixel = [&](unsigned int x, unsigned int y) { return &pixels[((std::size_t)y * 32 + x) * 4]; };
+	for (unsigned int y = 0; y < 7; y++) {
+		for (unsigned int x = 0; x < 13; x++)
+			CHECK(std::memcmp(atlasPixel(x, y), &margin[((std::size_t)(y + 2) * 20 + x + 3) * 4], 4) == 0);
+	}
+	// Rotated clockwise: the bottom row of the bounds becomes the left column of the placement
+	for (unsigned int y = 0; y < 6; y++) {
+		for (unsigned int x = 0; x < 11; x++)
+			CHECK(std::memcmp(atlasPixel(20 + x, y), &rotated[((std::size_t)(14 - x) * 9 + 1 + y) * 4], 4) == 0);
+	}
+	for (unsigned int y = 16; y < 32; y++) {
+		for (unsigned int x = 0; x < 16; x++)
+			CHECK(atlasPixel(x, y)[0] == 0 && atlasPixel(x, y)[3] == 0);
+	}
+
+	for (std::size_t i = 0; i < sprites.size(); i++)
+		std::filesystem::remove(sprites[i].path);
+}
+
+// Untrimmed sprites are copied whole, and sprites that can't be read are reported
+static void TestUntrimmedAndMissing() {
+	const std::vector<unsigned char> image = WriteImage("atlasbuildertest3.pam", {5, 4}, Rect{1, 1, 0, 0});
+	std::vector<Sprite> sprites(2);
+	sprites[0].path = "atlasbuildertest3.pam";
+	sprites[0].placement = {2, 2, 6, 5};
+	sprites[1].path = "atlasbuildertestmissing.pam";
+	CHECK(TrimSprite(sprites[1]).width == 0 && !sprites[1].trimmed);
+	sprites[1].placement = {0, 10, 4, 13};
+
+	AtlasBuilder atlas({16, 16}, 4);
+	const std::vector<std::size_t> failed = atlas.Composite(sprites, 1);
+	CHECK(failed.size() == 1 && failed[0] == 1);
+	const std::vector<unsigned char> & pixels = atlas.GetPixels();
+	for (unsigned int y = 0; y < 4; y++)
+		CHECK(std::memcmp(&pixels[((std::size_t)(y + 2) * 16 + 2) * 4], &image[(std::size_t)y * 5 * 4], 5 * 4) == 0);
+	std::filesystem::remove(sprites[0].path);
+}
+
+int main() {
+	TestTrimmedComposite();
+	TestUntrimmedAndMissing();
+	return ExitStatus();
+}
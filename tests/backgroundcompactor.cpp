@@ -0,0 +1,153 @@
+#include "check.h"
+#include "backgroundcompactor.h"
+#include <algorithm>
+#include <chrono>
+
+using namespace BinPacker;
+
+static bool SameRect(Rect a, Rect b) {
+	return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+static bool Overlap(Rect a, Rect b) {
+	return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+}
+
+static unsigned int Random(unsigned int& state, unsigned int range) {
+	state = state * 1103515245u + 12345u;
+	return (state >> 16) % range;
+}
+
+static unsigned long long LargestRegion(const Bin& bin) {
+	unsigned long long largest = 0;
+	for (const Rect & r : bin.GetEmptyRegions())
+		largest = std::max(largest, (unsigned long long)(r.right - r.left + 1) * (r.bottom - r.top + 1));
+	return largest;
+}
+
+// Whether the empty regions cover exactly the pixels of the bin outside every one of reserved
+static bool IsEmptyExcept(const Bin& bin, const std::vector<Rect>& reserved) {
+	const Area dimensions = bin.GetDimensions();
+	const std::vector<Rect> & regions = bin.GetEmptyRegions();
+	auto covers = [](const Rect & r, unsigned int x, unsigned int y) { return x >= r.left && x <= r.right && y >= r.top && y <= r.bottom; };
+	for (unsigned int y = 0; y < dimensions.height; y++) {
+		for (unsigned int x = 0; x < dimensions.width; x++) {
+			const bool empty = std::any_of(regions.cbegin(), regions.cend(), [&](const Rect & r){ return covers(r, x, y); });
+			if (empty == std::any_of(reserved.cbegin(), reserved.cend(), [&](const Rect & r){ return covers(r, x, y); }))
+				return false;
+		}
+	}
+	return true;
+}
+
+// Packs random rects into a 128x128 bin and releases every other one, leaving about a third of the free space outside the largest empty region
+static std::vector<Rect> Fragment(Bin& bin, unsigned int& state) {
+	bin.ExtendDimensions({128, 128});
+	std::vector<Rect> live;
+	for (unsigned int i = 0; i < 300; i++) {
+		const Rect r = bin.TryPackArea({2 + Random(state, 14), 2 + Random(state, 14)});
+		if (!r.IsValid())
+			continue;
+		if (i % 2 == 0)
+			bin.Release(r);
+		else
+			live.push_back(r);
+	}
+	return live;
+}
+
+// Applies relocations to the live rects, checking that each moves a live rect to space no other live rect occupies
+static void Apply(std::vector<Rect>& live, const std::vector<Relocation>& relocations) {
+	for (const Relocation & r : relocations) {
+		auto from = std::find_if(live.begin(), live.end(), [&](const Rect & l){ return SameRect(l, r.from); });
+		CHECK(from != live.end());
+		CHECK(std::none_of(live.cbegin(), live.cend(), [&](const Rect & l){ return Overlap(l, r.to); }));
+		if (from != live.end())
+			*from = r.to;
+	}
+}
+
+// Polls until the bin hasn't changed for a while, returning false if it never settles
+static bool PollUntilSettled(BackgroundCompactor& compactor, const Bin& bin, std::vector<Rect>& live, unsigned int& moves) {
+	unsigned long long revision = bin.GetRevision();
+	unsigned int quietPolls = 0;
+	for (unsigned int poll = 0; poll < 20000; poll++) {
+		const std::vector<Relocation> applied = compactor.Poll(live);
+		Apply(live, applied);
+		moves += (unsigned int)applied.size();
+		if (bin.GetRevision() == revision) {
+			if (++quietPolls == 1000)
+				return true;
+		} else {
+			quietPolls = 0;
+			revision = bin.GetRevision();
+		}
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+	}
+	return false;
+}
+
+// The compactor moves rects until the bin is compact, then stops planning until the bin changes
+static void TestSettles() {
+	unsigned int state = 7;
+	Bin bin;
+	std::vector<Rect> live = Fragment(bin, state);
+	const unsigned long long largestBefore = LargestRegion(bin);
+
+	BackgroundCompactor compactor(bin, PackConstraints(), 16, 0.2);
+	unsigned int moves = 0;
+	CHECK(PollUntilSettled(compactor, bin, live, moves));
+	CHECK(moves > 0);
+	CHECK(LargestRegion(bin) > largestBefore);
+
+	// Each live rect is packed exactly where the caller believes it is
+	CHECK(IsEmptyExcept(bin, live));
+	for (std::size_t i = 0; i < live.size(); i++) {
+		for (std::size_t j = i + 1; j < live.size(); j++)
+			CHECK(!Overlap(live[i], live[j]));
+	}
+
+	// A settled bin stays as it is when polled again
+	const unsigned long long settled = bin.GetRevision();
+	for (unsigned int i = 0; i < 50; i++) {
+		CHECK(compactor.Poll(live).empty());
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+	}
+	CHECK(bin.GetRevision() == settled);
+}
+
+// Packs and releases between polls skip the relocations they invalidate, and the compactor still settles
+static void TestSettlesWhileChanging() {
+	unsigned int state = 11;
+	Bin bin;
+	std::vector<Rect> live = Fragment(bin, state);
+
+	BackgroundCompactor compactor(bin, PackConstraints(), 16, 0.2);
+	unsigned int moves = 0;
+	for (unsigned int poll = 0; poll < 400; poll++) {
+		const std::vector<Relocation> applied = compactor.Poll(live);
+		Apply(live, applied);
+		moves += (unsigned int)applied.size();
+		if (poll % 10 == 0 && !live.empty()) {
+			const std::size_t released = Random(state, (unsigned int)live.size());
+			bin.Release(live[released]);
+			live.erase(live.begin() + released);
+		}
+		if (poll % 10 == 5) {
+			const Rect r = bin.TryPackArea({2 + Random(state, 14), 2 + Random(state, 14)});
+			CHECK(std::none_of(live.cbegin(), live.cend(), [&](const Rect & l){ return r.IsValid() && Overlap(l, r); }));
+			if (r.IsValid())
+				live.push_back(r);
+		}
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+	}
+	CHECK(PollUntilSettled(compactor, bin, live, moves));
+	CHECK(moves > 0);
+	CHECK(IsEmptyExcept(bin, live));
+}
+
+int main() {
+	TestSettles();
+	TestSettlesWhileChanging();
+	return ExitStatus();
+}
@@ -0,0 +1,306 @@
+// Tests of the binpack command-line tool, which run the tool through the shell.
+// Build the tool first and pass its path, e.g.
+//   g++ -std=c++17 -O2 -Isrc tools/binpack.cpp src/binpacker.cpp src/mappedfile.cpp -o binpack -pthread
+//   g++ -std=c++17 -O2 -Isrc tests/binpack.cpp src/binpacker.cpp -o binpacktest && ./binpacktest ./binpack
+
+#include "check.h"
+#include "binpacker.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#ifndef _WIN32
+#include <sys/wait.h>
+#endif
+
+using namespace BinPacker;
+
+static const std::uint32_t unpackedPage = 0xFFFFFFFF;
+static std::string binpack = "./binpack";
+
+// Placement of an item as read back from either output format
+struct Placement {
+	std::uint32_t page;
+	Rect rect;
+};
+
+// Everything written by a run of the tool
+struct Output {
+	std::vector<Placement> placements;
+	std::vector<Area> pages;
+	bool valid = false;
+};
+
+static bool Overlap(Rect a, Rect b) {
+	return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+}
+
+static bool SamePlacement(const Placement& a, const Placement& b) {
+	return a.page == b.page && a.rect.left == b.rect.left && a.rect.top == b.rect.top && a.rect.right == b.rect.right && a.rect.bottom == b.rect.bottom;
+}
+
+static bool SameOutput(const Output& a, const Output& b) {
+	return a.valid && b.valid && a.placements.size() == b.placements.size() && a.pages.size() == b.pages.size()
+		&& std::equal(a.placements.begin(), a.placements.end(), b.placements.begin(), SamePlacement)
+		&& std::equal(a.pages.begin(), a.pages.end(), b.pages.begin(), [](Area x, Area y){ return x.width == y.width && x.height == y.height; });
+}
+
+static std::string TempPath(const char* name) {
+	return (std::filesystem::temp_directory_path() / name).string();
+}
+
+static std::vector<unsigned char> ReadFile(const std::string& path) {
+	std::ifstream file(path, std::ios::binary);
+	return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static std::uint64_t ReadLittleEndian(const unsigned char* data, unsigned int bytes) {
+	std::uint64_t value = 0;
+	for (unsigned int i = bytes; i-- > 0;)
+		value = (value << 8) | data[i];
+	return value;
+}
+
+static void WriteItems(const std::string& textPath, const std::string& binaryPath, const std::vector<Area>& items) {
+	std::ofstream text(textPath, std::ios::trunc);
+	text << "# width height\n";
+	std::vector<unsigned char> data;
+	for (std::size_t i = 0; i < items.size(); i++) {
+		// Every separator the text format allows
+		text << items[i].width << (i % 3 == 0 ? " " : i % 3 == 1 ? "," : "x") << items[i].height << "\n";
+		for (std::uint32_t value : {items[i].width, items[i].height}) {
+			for (unsigned int j = 0; j < 4; j++)
+				data.push_back((unsigned char)(value >> (j * 8)));
+		}
+	}
+	std::ofstream binary(binaryPath, std::ios::binary | std::ios::trunc);
+	binary.write((const char*)data.data(), (std::streamsize)data.size());
+}
+
+// Runs the tool with arguments, returning its exit code
+static int Run(const std::string& arguments) {
+	const int status = std::system(("\"" + binpack + "\" --quiet " + arguments).c_str());
+#ifdef _WIN32
+	return status;
+#else
+	return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#endif
+}
+
+static Output ReadTextOutput(const std::string& path) {
+	Output output;
+	std::ifstream file(path);
+	std::string line;
+	bool pagesStarted = false;
+	while (std::getline(file, line)) {
+		std::istringstream fields(line);
+		if (line.compare(0, 7, "# page ") == 0) {
+			std::string hash, word;
+			std::size_t index;
+			Area page;
+			if (!(fields >> hash >> word >> index >> page.width >> page.height) || index != output.pages.size())
+				return output;
+			output.pages.push_back(page);
+			pagesStarted = true;
+			continue;
+		}
+		long long index, page;
+		unsigned int left, top, width, height, rotated;
+		if (pagesStarted || !(fields >> index >> page >> left >> top >> width >> height >> rotated) || index != (long long)output.placements.size())
+			return output;
+		if (page < 0)
+			output.placements.push_back(Placement{unpackedPage, Rect{1, 1, 0, 0}});
+		else
+			output.placements.push_back(Placement{(std::uint32_t)page, Rect{left, top, left + width - 1, top + height - 1}});
+	}
+	output.valid = true;
+	return output;
+}
+
+// Reads the records and footer of binary output, checking that the footer accounts for every byte
+static Output ReadBinaryOutput(const std::string& path) {
+	Output output;
+	const std::vector<unsigned char> data = ReadFile(path);
+	if (data.size() < 16 || !std::equal(data.end() - 4, data.end(), "BPP1"))
+		return output;
+	const std::uint64_t itemCount = ReadLittleEndian(&data[data.size() - 12], 8);
+	const std::uint64_t pageCount = ReadLittleEndian(&data[data.size() - 16], 4);
+	if (data.size() != itemCount * 20 + pageCount * 8 + 16)
+		return output;
+	for (std::uint64_t i = 0; i < itemCount; i++) {
+		const unsigned char* record = &data[i * 20];
+		const std::uint32_t page = (std::uint32_t)ReadLittleEndian(record, 4);
+		const Rect r = { (unsigned int)ReadLittleEndian(record + 4, 4), (unsigned int)ReadLittleEndian(record + 8, 4),
+			(unsigned int)ReadLittleEndian(record + 12, 4), (unsigned int)ReadLittleEndian(record + 16, 4) };
+		output.placements.push_back(Placement{page, page == unpackedPage ? Rect{1, 1, 0, 0} : r});
+	}
+	for (std::uint64_t i = 0; i < pageCount; i++) {
+		const unsigned char* page = &data[itemCount * 20 + i * 8];
+		output.pages.push_back(Area{(unsigned int)ReadLittleEndian(page, 4), (unsigned int)ReadLittleEndian(page + 4, 4)});
+	}
+	output.valid = true;
+	return output;
+}
+
+// Whether every packed item has its own size in either orientation, lies within its page and overlaps nothing on it
+static bool IsValidPacking(const Output& output, const std::vector<Area>& items) {
+	if (!output.valid || output.placements.size() != items.size())
+		return false;
+	std::vector<std::vector<Rect>> pages(output.pages.size());
+	for (std::size_t i = 0; i < items.size(); i++) {
+		const Placement & p = output.placements[i];
+		if (p.page == unpackedPage)
+			continue;
+		const Area size = { p.rect.right - p.rect.left + 1, p.rect.bottom - p.rect.top + 1 };
+		if (p.page >= pages.size() || !p.rect.IsValid() || p.rect.right >= output.pages[p.page].width || p.rect.bottom >= output.pages[p.page].height
+			|| !((size.width == items[i].width && size.height == items[i].height) || (size.width == items[i].height && size.height == items[i].width)))
+			return false;
+		for (const Rect & r : pages[p.page]) {
+			if (Overlap(r, p.rect))
+				return false;
+		}
+		pages[p.page].push_back(p.rect);
+	}
+	return true;
+}
+
+static std::vector<Area> RandomItems(unsigned int count, unsigned int maxSide) {
+	std::vector<Area> items;
+	unsigned int state = 1;
+	for (unsigned int i = 0; i < count; i++) {
+		state = state * 1103515245u + 12345u;
+		const unsigned int width = 1 + (state >> 16) % maxSide;
+		state = state * 1103515245u + 12345u;
+		const unsigned int height = 1 + (state >> 16) % maxSide;
+		items.push_back(Area{width, height});
+	}
+	return items;
+}
+
+// Text and binary input give the same placements and pages in text and binary output, and the binary footer
+// describes the pages and items
+static void TestFormats() {
+	const std::vector<Area> items = RandomItems(3000, 40);
+	const std::string textIn = TempPath("binpacktest.txt"), binaryIn = TempPath("binpacktest.items");
+	const std::string textOut = TempPath("binpacktest.out.txt"), binaryOut = TempPath("binpacktest.out.bin");
+	WriteItems(textIn, binaryIn, items);
+	const std::string packing = "--size 64x64 --max-size 256x256 --grow alternate --pages 0 --padding 1 --align 2 ";
+
+	CHECK(Run(packing + "\"" + textIn + "\" -o \"" + textOut + "\"") == 0);
+	const Output text = ReadTextOutput(textOut);
+	CHECK(text.valid && text.pages.size() > 1);
+	CHECK(IsValidPacking(text, items));
+	CHECK(Run(packing + "--binary-in --binary-out \"" + binaryIn + "\" -o \"" + binaryOut + "\"") == 0);
+	const Output binary = ReadBinaryOutput(binaryOut);
+	CHECK(SameOutput(text, binary));
+	CHECK(Run(packing + "--binary-out \"" + textIn + "\" -o \"" + binaryOut + "\"") == 0);
+	CHECK(SameOutput(text, ReadBinaryOutput(binaryOut)));
+	CHECK(Run(packing + "--binary-in \"" + binaryIn + "\" -o \"" + textOut + "\"") == 0);
+	CHECK(SameOutput(text, ReadTextOutput(textOut)));
+
+	for (const char* file : {textIn.c_str(), binaryIn.c_str(), textOut.c_str(), binaryOut.c_str()})
+		std::filesystem::remove(file);
+}
+
+// Reading a memory-mapped file and writing a memory-mapped output give the same bytes as streaming through stdin and stdout
+static void TestMappedMatchesStreamed() {
+	const std::vector<Area> items = RandomItems(5000, 24);
+	const std::string textIn = TempPath("binpacktest.txt"), binaryIn = TempPath("binpacktest.items");
+	const std::string mapped = TempPath("binpacktest.mapped"), streamed = TempPath("binpacktest.streamed");
+	WriteItems(textIn, binaryIn, items);
+	const std::string packing = "--size 128x128 --max-size 512x512 --pages 4 ";
+
+	CHECK(Run(packing + "--binary-in --binary-out \"" + binaryIn + "\" -o \"" + mapped + "\"") == 0);
+	CHECK(Run(packing + "--binary-in --binary-out < \"" + binaryIn + "\" > \"" + streamed + "\"") == 0);
+	const std::vector<unsigned char> mappedBytes = ReadFile(mapped);
+	CHECK(!mappedBytes.empty() && mappedBytes == ReadFile(streamed));
+	CHECK(IsValidPacking(ReadBinaryOutput(mapped), items));
+
+	CHECK(Run(packing + "\"" + textIn + "\" -o \"" + mapped + "\"") == 0);
+	CHECK(Run(packing + "< \"" + textIn + "\" > \"" + streamed + "\"") == 0);
+	CHECK(ReadFile(mapped) == ReadFile(streamed));
+
+	for (const char* file : {textIn.c_str(), binaryIn.c_str(), mapped.c_str(), streamed.c_str()})
+		std::filesystem::remove(file);
+}
+
+// An empty input gives a footer with the single empty page and no items
+static void TestEmptyInput() {
+	const std::string binaryIn = TempPath("binpacktest.items"), binaryOut = TempPath("binpacktest.out.bin");
+	WriteItems(TempPath("binpacktest.txt"), binaryIn, {});
+	CHECK(Run("--size 32x16 --binary-in --binary-out \"" + binaryIn + "\" -o \"" + binaryOut + "\"") == 0);
+	const std::vector<unsigned char> data = ReadFile(binaryOut);
+	CHECK(data.size() == 24);
+	if (data.size() == 24) {
+		CHECK(ReadLittleEndian(&data[0], 4) == 32 && ReadLittleEndian(&data[4], 4) == 16);
+		CHECK(ReadLittleEndian(&data[8], 4) == 1 && ReadLittleEndian(&data[12], 8) == 0);
+		CHECK(std::equal(data.begin() + 20, data.end(), "BPP1"));
+	}
+	std::filesystem::remove(TempPath("binpacktest.txt"));
+	std::filesystem::remove(binaryIn);
+	std::filesystem::remove(binaryOut);
+}
+
+// Items that don't fit a page grown as far as it can, in either orientation with padding and alignment, and items
+// without area are left unpacked without growing the page or starting a new one
+static void TestUnpackable() {
+	std::vector<Area> items = RandomItems(400, 30), fitting;
+	const std::vector<Area> unpackable = { {300, 10}, {0, 0}, {10, 300}, {256, 1}, {0, 5}, {253, 253} };
+	for (std::size_t i = 0; i < unpackable.size(); i++)
+		items.insert(items.begin() + i * 60 + 1, unpackable[i]);
+	for (const Area & item : items) {
+		if (std::find_if(unpackable.begin(), unpackable.end(), [&](Area u){ return u.width == item.width && u.height == item.height; }) == unpackable.end())
+			fitting.push_back(item);
+	}
+
+	const std::string textIn = TempPath("binpacktest.txt"), binaryIn = TempPath("binpacktest.items");
+	const std::string allOut = TempPath("binpacktest.all"), fittingOut = TempPath("binpacktest.fitting");
+	const std::string packing = "--size 64x64 --max-size 256x256 --pages 0 --padding 2 --align 4 --binary-in --binary-out ";
+	WriteItems(textIn, binaryIn, items);
+	CHECK(Run(packing + "\"" + binaryIn + "\" -o \"" + allOut + "\"") == 3);
+	WriteItems(textIn, binaryIn, fitting);
+	CHECK(Run(packing + "\"" + binaryIn + "\" -o \"" + fittingOut + "\"") == 0);
+
+	const Output all = ReadBinaryOutput(allOut), withoutUnpackable = ReadBinaryOutput(fittingOut);
+	CHECK(IsValidPacking(all, items));
+	CHECK(all.valid && withoutUnpackable.valid && all.pages.size() == withoutUnpackable.pages.size());
+	if (all.valid && withoutUnpackable.valid && all.placements.size() == items.size()) {
+		std::vector<Placement> packed;
+		for (std::size_t i = 0; i < items.size(); i++) {
+			const bool unpacked = all.placements[i].page == unpackedPage;
+			CHECK(unpacked == (i % 60 == 1 && i / 60 < unpackable.size()));
+			if (!unpacked)
+				packed.push_back(all.placements[i]);
+		}
+		Output fittingOnly = all;
+		fittingOnly.placements = packed;
+		CHECK(SameOutput(fittingOnly, withoutUnpackable));
+	}
+
+	// With a single page and no growth, an item larger than the page is refused while the page still has room
+	WriteItems(textIn, binaryIn, {{10, 10}, {65, 1}, {1, 65}, {10, 10}});
+	CHECK(Run("--size 64x64 --grow none --pages 1 --binary-in --binary-out \"" + binaryIn + "\" -o \"" + allOut + "\"") == 3);
+	const Output single = ReadBinaryOutput(allOut);
+	CHECK(single.valid && single.pages.size() == 1 && single.placements.size() == 4);
+	if (single.valid && single.placements.size() == 4) {
+		CHECK(single.placements[0].page == 0 && single.placements[3].page == 0);
+		CHECK(single.placements[1].page == unpackedPage && single.placements[2].page == unpackedPage);
+	}
+
+	for (const char* file : {textIn.c_str(), binaryIn.c_str(), allOut.c_str(), fittingOut.c_str()})
+		std::filesystem::remove(file);
+}
+
+int main(int argc, char** argv) {
+	if (argc > 1)
+		binpack = argv[1];
+	TestFormats();
+	TestMappedMatchesStreamed();
+	TestEmptyInput();
+	TestUnpackable();
+	return ExitStatus();
+}
@@ -0,0 +1,357 @@
+#include "check.h"
+#include "binpacker.h"
+#include <algorithm>
+
+using namespace BinPacker;
+
+static bool SameRect(Rect a, Rect b) {
+	return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+static unsigned int Random(unsigned int& state, unsigned int range) {
+	state = state * 1103515245u + 12345u;
+	return (state >> 16) % range;
+}
+
+static void Shuffle(std::vector<Rect>& rects, unsigned int& state) {
+	for (std::size_t i = rects.size(); i > 1; i--)
+		std::swap(rects[i - 1], rects[Random(state, (unsigned int)i)]);
+}
+
+// Packing random items and releasing all of them in random order leaves a single region covering the bin
+static void TestReleaseAll() {
+	for (unsigned int run = 0; run < 100; run++) {
+		unsigned int state = run + 1;
+		Bin bin;
+		bin.ExtendDimensions({128, 96});
+		std::vector<Rect> packed;
+		for (unsigned int i = 0; i < 200; i++) {
+			const Rect r = bin.TryPackArea({1 + Random(state, 24), 1 + Random(state, 24)});
+			if (r.IsValid())
+				packed.push_back(r);
+		}
+		Shuffle(packed, state);
+		for (const Rect & r : packed)
+			bin.Release(r);
+		const std::vector<Rect> & regions = bin.GetEmptyRegions();
+		CHECK(regions.size() == 1 && SameRect(regions[0], Rect{0, 0, 127, 95}));
+	}
+}
+
+// The same holds for a bin that grew while it was packed, and for items released with the constraints they were packed with
+static void TestReleaseAllAfterGrowth() {
+	PackConstraints constraints;
+	constraints.padding = {1, 2, 0, 1};
+	constraints.sizeAlignment = {2, 2};
+	for (unsigned int run = 0; run < 50; run++) {
+		unsigned int state = run + 1;
+		Bin bin;
+		bin.ExtendDimensions({32, 32});
+		std::vector<Rect> packed;
+		for (unsigned int i = 0; i < 150; i++) {
+			const Area item = {1 + Random(state, 20), 1 + Random(state, 20)};
+			Rect r = bin.TryPackArea(item, constraints);
+			while (!r.IsValid()) {
+				const Area dimensions = bin.GetDimensions();
+				bin.ExtendDimensions(dimensions.width <= dimensions.height ? Area{dimensions.width, 0} : Area{0, dimensions.height});
+				r = bin.TryPackArea(item, constraints);
+			}
+			packed.push_back(r);
+		}
+		Shuffle(packed, state);
+		for (const Rect & r : packed)
+			bin.Release(r, constraints);
+		const Area dimensions = bin.GetDimensions();
+		const std::vector<Rect> & regions = bin.GetEmptyRegions();
+		CHECK(regions.size() == 1 && SameRect(regions[0], Rect{0, 0, dimensions.width - 1, dimensions.height - 1}));
+	}
+}
+
+// While items are packed and released in any order, the empty regions are empty and include every maximal empty rectangle,
+// found by brute force over the occupancy of each pixel
+static void TestRegionsAreMaximal() {
+	const unsigned int width = 24, height = 20;
+	for (unsigned int run = 0; run < 20; run++) {
+		unsigned int state = run + 1;
+		Bin bin;
+		bin.ExtendDimensions({width, height});
+		std::vector<Rect> packed;
+		for (unsigned int step = 0; step < 200; step++) {
+			if (!packed.empty() && Random(state, 3) == 0) {
+				const unsigned int index = Random(state, (unsigned int)packed.size());
+				bin.Release(packed[index]);
+				packed.erase(packed.begin() + index);
+			} else {
+				const Rect r = bin.TryPackArea({1 + Random(state, 6), 1 + Random(state, 6)});
+				if (r.IsValid())
+					packed.push_back(r);
+			}
+
+			// Number of occupied pixels above and left of each pixel
+			std::vector<unsigned int> occupied((width + 1) * (height + 1), 0);
+			for (unsigned int y = 0; y < height; y++) {
+				for (unsigned int x = 0; x < width; x++) {
+					const bool used = std::any_of(packed.cbegin(), packed.cend(), [&](const Rect & r){ return x >= r.left && x <= r.right && y >= r.top && y <= r.bottom; });
+					occupied[(y + 1) * (width + 1) + x + 1] = used + occupied[y * (width + 1) + x + 1] + occupied[(y + 1) * (width + 1) + x] - occupied[y * (width + 1) + x];
+				}
+			}
+			// Whether a rect lies within the bin and is entirely empty
+			auto isEmpty = [&](long long left, long long top, long long right, long long bottom) {
+				if (left < 0 || top < 0 || right >= width || bottom >= height)
+					return false;
+				return occupied[(bottom + 1) * (width + 1) + right + 1] - occupied[top * (width + 1) + right + 1]
+					- occupied[(bottom + 1) * (width + 1) + left] + occupied[top * (width + 1) + left] == 0;
+			};
+
+			const std::vector<Rect> & regions = bin.GetEmptyRegions();
+			for (const Rect & r : regions)
+				CHECK(isEmpty(r.left, r.top, r.right, r.bottom));
+			for (unsigned int top = 0; top < height; top++) {
+				for (unsigned int left = 0; left < width; left++) {
+					for (unsigned int bottom = top; bottom < height; bottom++) {
+						for (unsigned int right = left; right < width; right++) {
+							if (!isEmpty(left, top, right, bottom) || isEmpty(left - 1ll, top, right, bottom) || isEmpty(left, top - 1ll, right, bottom)
+								|| isEmpty(left, top, right + 1ll, bottom) || isEmpty(left, top, right, bottom + 1ll))
+								continue;
+							CHECK(std::any_of(regions.cbegin(), regions.cend(), [&](const Rect & r){ return SameRect(r, Rect{left, top, right, bottom}); }));
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+// Whether the empty regions cover exactly the pixels of the bin outside every one of reserved
+static bool IsEmptyExcept(const Bin& bin, const std::vector<Rect>& reserved) {
+	const Area dimensions = bin.GetDimensions();
+	const std::vector<Rect> & regions = bin.GetEmptyRegions();
+	auto covers = [](const Rect & r, unsigned int x, unsigned int y) { return x >= r.left && x <= r.right && y >= r.top && y <= r.bottom; };
+	for (unsigned int y = 0; y < dimensions.height; y++) {
+		for (unsigned int x = 0; x < dimensions.width; x++) {
+			const bool empty = std::any_of(regions.cbegin(), regions.cend(), [&](const Rect & r){ return covers(r, x, y); });
+			if (empty == std::any_of(reserved.cbegin(), reserved.cend(), [&](const Rect & r){ return covers(r, x, y); }))
+				return false;
+		}
+	}
+	return true;
+}
+
+// Padding is reserved on each side of an item without being part of its rect, and can be dropped along the edges of the bin
+static void TestPadding() {
+	PackConstraints constraints;
+	constraints.padding = {1, 2, 3, 4};
+	constraints.allowRotation = false;
+	Bin bin;
+	bin.ExtendDimensions({20, 20});
+	const Rect padded = bin.TryPackArea({5, 6}, constraints);
+	CHECK(padded.IsValid() && padded.right - padded.left + 1 == 5 && padded.bottom - padded.top + 1 == 6);
+	CHECK(padded.left >= 1 && padded.top >= 2 && padded.right + 3 < 20 && padded.bottom + 4 < 20);
+	CHECK(IsEmptyExcept(bin, {Rect{padded.left - 1, padded.top - 2, padded.right + 3, padded.bottom + 4}}));
+
+	// Only 20 pixels wide with padding, which doesn't fit unless it is dropped along the edges
+	CHECK(!bin.TryPackArea({17, 1}, constraints).IsValid());
+	constraints.padBinEdges = false;
+	Bin edges;
+	edges.ExtendDimensions({20, 20});
+	const Rect corner = edges.TryPackArea({20, 3}, constraints);
+	CHECK(SameRect(corner, Rect{0, 0, 19, 2}) || SameRect(corner, Rect{0, 17, 19, 19}));
+	const Rect reserved = corner.top == 0 ? Rect{0, 0, 19, 6} : Rect{0, 15, 19, 19};
+	CHECK(IsEmptyExcept(edges, {reserved}));
+}
+
+// Positions are multiples of the position alignment, and the space reserved for each item is rounded up to the size alignment
+static void TestAlignment() {
+	PackConstraints constraints;
+	constraints.positionAlignment = {4, 8};
+	constraints.sizeAlignment = {4, 4};
+	unsigned int state = 3;
+	Bin bin;
+	bin.ExtendDimensions({64, 64});
+	std::vector<Rect> packed, reserved;
+	for (unsigned int i = 0; i < 40; i++) {
+		const Rect r = bin.TryPackArea({1 + Random(state, 9), 1 + Random(state, 9)}, constraints);
+		if (!r.IsValid())
+			continue;
+		CHECK(r.left % 4 == 0 && r.top % 8 == 0);
+		packed.push_back(r);
+		reserved.push_back(Rect{r.left, r.top, r.left + (r.right - r.left + 4) / 4 * 4 - 1, r.top + (r.bottom - r.top + 4) / 4 * 4 - 1});
+	}
+	CHECK(packed.size() > 10);
+	CHECK(IsEmptyExcept(bin, reserved));
+}
+
+// An item is rotated, padding and all, when only its rotation fits
+static void TestRotationWithPadding() {
+	PackConstraints constraints;
+	constraints.padding = {1, 2, 1, 2};
+	Bin bin;
+	bin.ExtendDimensions({12, 30});
+	const Rect rotated = bin.TryPackArea({20, 8}, constraints);
+	CHECK(rotated.IsValid() && rotated.right - rotated.left + 1 == 8 && rotated.bottom - rotated.top + 1 == 20);
+	CHECK(IsEmptyExcept(bin, {Rect{rotated.left - 1, rotated.top - 2, rotated.right + 1, rotated.bottom + 2}}));
+
+	constraints.allowRotation = false;
+	Bin fixed;
+	fixed.ExtendDimensions({12, 30});
+	CHECK(!fixed.TryPackArea({20, 8}, constraints).IsValid());
+}
+
+// Releasing with the constraints an item was packed with returns its padding and size alignment too
+static void TestReleaseWithConstraints() {
+	PackConstraints constraints;
+	constraints.padding = {2, 1, 3, 1};
+	constraints.sizeAlignment = {4, 4};
+	constraints.positionAlignment = {2, 2};
+	Bin bin;
+	bin.ExtendDimensions({40, 40});
+	const Rect a = bin.TryPackArea({5, 7}, constraints);
+	const Rect b = bin.TryPackArea({9, 3}, constraints);
+	CHECK(a.IsValid() && b.IsValid());
+	bin.Release(a, constraints);
+	const Rect bReserved = {b.left - 2, b.top - 1, b.left + (b.right - b.left + 4) / 4 * 4 - 1 + 3, b.top + (b.bottom - b.top + 4) / 4 * 4 - 1 + 1};
+	CHECK(IsEmptyExcept(bin, {bReserved}));
+	bin.Release(b, constraints);
+	CHECK(bin.GetEmptyRegions().size() == 1 && SameRect(bin.GetEmptyRegions()[0], Rect{0, 0, 39, 39}));
+}
+
+// Resizing grows a rect in place when the space beside it is empty, and otherwise moves it to space that doesn't overlap it
+static void TestResize() {
+	PackConstraints constraints;
+	constraints.allowRotation = false;
+	Bin bin;
+	bin.ExtendDimensions({4, 14});
+	const Rect rect = {0, 4, 3, 7};
+	const Rect blocker = {0, 10, 3, 10};
+	CHECK(bin.Reserve(rect, constraints) && bin.Reserve(blocker, constraints));
+
+	bool moved = true;
+	const Rect grown = bin.Resize(rect, {4, 6}, constraints, &moved);
+	CHECK(!moved && SameRect(grown, Rect{0, 4, 3, 9}));
+	CHECK(IsEmptyExcept(bin, {grown, blocker}));
+	const Rect shrunk = bin.Resize(grown, {4, 4}, constraints, &moved);
+	CHECK(!moved && SameRect(shrunk, rect));
+	CHECK(IsEmptyExcept(bin, {rect, blocker}));
+
+	// The free rows beside the rect and below the blocker are too few, so the rect fits only by overlapping its old space
+	const Rect overlapping = bin.Resize(rect, {4, 7}, constraints, &moved);
+	CHECK(!overlapping.IsValid() && !moved);
+	CHECK(IsEmptyExcept(bin, {rect, blocker}));
+
+	// Rows 0 to 7 are free once the rect is released, but the moved rect must not overlap the old one
+	Bin moving;
+	moving.ExtendDimensions({4, 20});
+	CHECK(moving.Reserve(rect, constraints) && moving.Reserve(Rect{0, 8, 3, 8}, constraints));
+	const Rect movedRect = moving.Resize(rect, {4, 6}, constraints, &moved);
+	CHECK(moved && movedRect.IsValid() && movedRect.right - movedRect.left + 1 == 4 && movedRect.bottom - movedRect.top + 1 == 6);
+	CHECK(movedRect.top > 8);
+	CHECK(IsEmptyExcept(moving, {movedRect, Rect{0, 8, 3, 8}}));
+}
+
+// Returns the rects recorded by a bin that reserves each of rects, flushed with mergeThreshold
+static std::vector<Rect> FlushReserved(const std::vector<Rect>& rects, unsigned int mergeThreshold) {
+	Bin bin;
+	bin.ExtendDimensions({64, 64});
+	bin.SetDirtyTracking(true);
+	for (const Rect & r : rects)
+		CHECK(bin.Reserve(r));
+	std::vector<Rect> flushed = bin.FlushDirtyRegions(mergeThreshold);
+	CHECK(bin.FlushDirtyRegions(mergeThreshold).empty());
+	return flushed;
+}
+
+// Dirty rects are merged only when the bounds of the merge waste no more than the threshold's pixels
+static void TestDirtyRegions() {
+	// Adjacent rects whose bounds they fill exactly merge at no cost
+	std::vector<Rect> flushed = FlushReserved({Rect{0, 0, 9, 9}, Rect{10, 0, 19, 9}}, 0);
+	CHECK(flushed.size() == 1 && SameRect(flushed[0], Rect{0, 0, 19, 9}));
+
+	// A gap of 100 pixels is merged across at a threshold of 100 but not 99
+	flushed = FlushReserved({Rect{0, 0, 9, 9}, Rect{0, 20, 9, 29}}, 99);
+	CHECK(flushed.size() == 2);
+	flushed = FlushReserved({Rect{0, 0, 9, 9}, Rect{0, 20, 9, 29}}, 100);
+	CHECK(flushed.size() == 1 && SameRect(flushed[0], Rect{0, 0, 9, 29}));
+
+	// Merges accumulate their waste, so a third rect isn't merged if the total waste would exceed the threshold
+	flushed = FlushReserved({Rect{0, 0, 9, 9}, Rect{0, 20, 9, 29}, Rect{0, 40, 9, 49}}, 150);
+	CHECK(flushed.size() == 2);
+
+	// Every packed pixel is covered by the flushed rects, none of which hold more than the threshold of pixels that weren't packed,
+	// and nothing is recorded while tracking is off
+	unsigned int state = 9;
+	Bin bin;
+	bin.ExtendDimensions({128, 128});
+	bin.TryPackArea({5, 5});
+	bin.SetDirtyTracking(true);
+	std::vector<Rect> packed;
+	for (unsigned int i = 0; i < 60; i++)
+		packed.push_back(bin.TryPackArea({1 + Random(state, 12), 1 + Random(state, 12)}));
+	flushed = bin.FlushDirtyRegions(32);
+	CHECK(!flushed.empty() && flushed.size() < packed.size());
+	for (const Rect & p : packed) {
+		CHECK(std::any_of(flushed.cbegin(), flushed.cend(), [&](const Rect & r){
+			return r.left <= p.left && r.top <= p.top && r.right >= p.right && r.bottom >= p.bottom;
+		}));
+	}
+	for (const Rect & r : flushed) {
+		unsigned long long packedArea = 0;
+		for (const Rect & p : packed) {
+			if (p.left <= r.right && p.right >= r.left && p.top <= r.bottom && p.bottom >= r.top)
+				packedArea += (unsigned long long)(std::min(p.right, r.right) - std::max(p.left, r.left) + 1) * (std::min(p.bottom, r.bottom) - std::max(p.top, r.top) + 1);
+		}
+		CHECK((unsigned long long)(r.right - r.left + 1) * (r.bottom - r.top + 1) <= packedArea + 32);
+	}
+	bin.SetDirtyTracking(false);
+	bin.TryPackArea({3, 3});
+	CHECK(bin.FlushDirtyRegions(0).empty());
+}
+
+// Packing in parallel windows gives exactly the placements and empty regions of packing in order, for any window size and thread count
+static void TestParallelMatchesSequential() {
+	PackConstraints constrained;
+	constrained.padding = {1, 0, 2, 1};
+	constrained.positionAlignment = {2, 1};
+	constrained.sizeAlignment = {1, 2};
+	for (unsigned int run = 0; run < 6; run++) {
+		unsigned int state = run + 1;
+		// Start from a bin whose free space is already fragmented by packs and releases
+		Bin start;
+		start.ExtendDimensions({160 + Random(state, 100), 160 + Random(state, 100)});
+		std::vector<Rect> packed;
+		for (unsigned int i = 0; i < 60; i++)
+			packed.push_back(start.TryPackArea({1 + Random(state, 20), 1 + Random(state, 20)}));
+		for (std::size_t i = 0; i < packed.size(); i += 3)
+			start.Release(packed[i]);
+
+		std::vector<Area> items;
+		for (unsigned int i = 0; i < 150; i++)
+			items.push_back({1 + Random(state, run % 2 == 0 ? 8 : 24), 1 + Random(state, run % 2 == 0 ? 8 : 24)});
+		const PackConstraints & constraints = run < 3 ? PackConstraints() : constrained;
+		Bin sequential = start;
+		const std::vector<Rect> expected = sequential.TryPackAreas(items, constraints);
+
+		for (unsigned int windowSize : {1u, 4u, 16u, 64u}) {
+			for (unsigned int threadCount : {1u, 2u, 4u, 8u}) {
+				Bin parallel = start;
+				const std::vector<Rect> results = parallel.TryPackAreasParallel(items, constraints, windowSize, threadCount);
+				CHECK(results.size() == expected.size() && std::equal(results.cbegin(), results.cend(), expected.cbegin(), SameRect));
+				const std::vector<Rect> & regions = parallel.GetEmptyRegions(), & expectedRegions = sequential.GetEmptyRegions();
+				CHECK(regions.size() == expectedRegions.size() && std::equal(regions.cbegin(), regions.cend(), expectedRegions.cbegin(), SameRect));
+			}
+		}
+	}
+}
+
+int main() {
+	TestReleaseAll();
+	TestReleaseAllAfterGrowth();
+	TestRegionsAreMaximal();
+	TestPadding();
+	TestAlignment();
+	TestRotationWithPadding();
+	TestReleaseWithConstraints();
+	TestResize();
+	TestDirtyRegions();
+	TestParallelMatchesSequential();
+	return ExitStatus();
+}
@@ -0,0 +1,163 @@
+#include "check.h"
+#include "bitboardbin.h"
+
+using namespace BinPacker;
+
+static bool SameRect(Rect a, Rect b) {
+	return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+static bool Overlap(Rect a, Rect b) {
+	return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+}
+
+static unsigned int Random(unsigned int& state, unsigned int range) {
+	state = state * 1103515245u + 12345u;
+	return (state >> 16) % range;
+}
+
+// Occupancy of every cell of a bin, searched cell by cell
+struct OccupancyGrid {
+	unsigned int columns = 0, rows = 0;
+	std::vector<std::vector<bool>> used;
+
+	void Extend(unsigned int newColumns, unsigned int newRows) {
+		for (std::vector<bool> & row : used)
+			row.resize(newColumns, false);
+		used.resize(newRows, std::vector<bool>(newColumns, false));
+		columns = newColumns;
+		rows = newRows;
+	}
+
+	bool IsFree(unsigned int left, unsigned int top, unsigned int width, unsigned int height) const {
+		for (unsigned int y = top; y < top + height; y++) {
+			for (unsigned int x = left; x < left + width; x++) {
+				if (used[y][x])
+					return false;
+			}
+		}
+		return true;
+	}
+
+	// Finds the topmost, then leftmost, free position for width by height cells
+	bool Find(unsigned int width, unsigned int height, unsigned int& left, unsigned int& top) const {
+		for (top = 0; top + height <= rows; top++) {
+			for (left = 0; left + width <= columns; left++) {
+				if (IsFree(left, top, width, height))
+					return true;
+			}
+		}
+		return false;
+	}
+
+	void Set(Rect cells, bool value) {
+		for (unsigned int y = cells.top; y <= cells.bottom; y++) {
+			for (unsigned int x = cells.left; x <= cells.right; x++)
+				used[y][x] = value;
+		}
+	}
+};
+
+// Returns the rect that packing area into the grid should give, following the search order documented by BitboardBin
+static Rect ExpectedPlacement(const OccupancyGrid& grid, Area area, unsigned int cellSize, bool allowRotation) {
+	const unsigned int width = (area.width + cellSize - 1) / cellSize, height = (area.height + cellSize - 1) / cellSize;
+	unsigned int left = 0, top = 0, rotatedLeft = 0, rotatedTop = 0;
+	bool found = grid.Find(width, height, left, top);
+	if (allowRotation && width != height && grid.Find(height, width, rotatedLeft, rotatedTop)
+		&& (!found || rotatedTop < top || (rotatedTop == top && rotatedLeft < left))) {
+		return Rect{rotatedLeft * cellSize, rotatedTop * cellSize, rotatedLeft * cellSize + area.height - 1, rotatedTop * cellSize + area.width - 1};
+	}
+	if (!found)
+		return Rect{1, 1, 0, 0};
+	return Rect{left * cellSize, top * cellSize, left * cellSize + area.width - 1, top * cellSize + area.height - 1};
+}
+
+// Whether the empty regions cover exactly the free cells of the grid without overlapping
+static bool MatchesEmptyRegions(const BitboardBin& bin, const OccupancyGrid& grid, unsigned int cellSize) {
+	std::vector<std::vector<unsigned int>> covered(grid.rows, std::vector<unsigned int>(grid.columns, 0));
+	for (const Rect & r : bin.GetEmptyRegions()) {
+		if (r.left % cellSize != 0 || r.top % cellSize != 0 || (r.right + 1) % cellSize != 0 || (r.bottom + 1) % cellSize != 0)
+			return false;
+		if (r.right / cellSize >= grid.columns || r.bottom / cellSize >= grid.rows)
+			return false;
+		for (unsigned int y = r.top / cellSize; y <= r.bottom / cellSize; y++) {
+			for (unsigned int x = r.left / cellSize; x <= r.right / cellSize; x++)
+				covered[y][x]++;
+		}
+	}
+	for (unsigned int y = 0; y < grid.rows; y++) {
+		for (unsigned int x = 0; x < grid.columns; x++) {
+			if (covered[y][x] != (grid.used[y][x] ? 0u : 1u))
+				return false;
+		}
+	}
+	return true;
+}
+
+// Packs and releases random items, comparing every placement and the empty regions with a brute-force occupancy grid.
+// The bins are wider than 64 cells so that runs cross words, and aren't a whole number of cells so that partial cells are left unused.
+static void TestMatchesOccupancyGrid(Area dimensions, unsigned int cellSize, unsigned int maxItemSize, unsigned int seed) {
+	BitboardBin bin(dimensions, cellSize);
+	OccupancyGrid grid;
+	grid.Extend(dimensions.width / cellSize, dimensions.height / cellSize);
+	std::vector<Rect> live;
+	unsigned int state = seed;
+	for (unsigned int i = 0; i < 1500; i++) {
+		if (i == 750) {
+			// Growing keeps every packed cell and frees the new ones
+			bin.ExtendDimensions({dimensions.width / 2, dimensions.height / 3});
+			const Area extended = bin.GetDimensions();
+			CHECK(extended.width == dimensions.width + dimensions.width / 2 && extended.height == dimensions.height + dimensions.height / 3);
+			grid.Extend(extended.width / cellSize, extended.height / cellSize);
+		}
+
+		if (Random(state, 4) < 3 || live.empty()) {
+			const Area area = { 1 + Random(state, maxItemSize), 1 + Random(state, maxItemSize) };
+			const bool allowRotation = Random(state, 4) != 0;
+			const Rect expected = ExpectedPlacement(grid, area, cellSize, allowRotation);
+			const Rect packed = bin.TryPackArea(area, allowRotation);
+			CHECK(SameRect(packed, expected) || (!packed.IsValid() && !expected.IsValid()));
+			if (!packed.IsValid())
+				continue;
+			for (const Rect & r : live)
+				CHECK(!Overlap(r, packed));
+			grid.Set(Rect{packed.left / cellSize, packed.top / cellSize, packed.right / cellSize, packed.bottom / cellSize}, true);
+			live.push_back(packed);
+		} else {
+			const std::size_t released = Random(state, (unsigned int)live.size());
+			const Rect r = live[released];
+			bin.Release(r);
+			grid.Set(Rect{r.left / cellSize, r.top / cellSize, r.right / cellSize, r.bottom / cellSize}, false);
+			live.erase(live.begin() + released);
+		}
+		if (i % 50 == 0)
+			CHECK(MatchesEmptyRegions(bin, grid, cellSize));
+	}
+
+	for (const Rect & r : live) {
+		bin.Release(r);
+		grid.Set(Rect{r.left / cellSize, r.top / cellSize, r.right / cellSize, r.bottom / cellSize}, false);
+	}
+	CHECK(MatchesEmptyRegions(bin, grid, cellSize));
+}
+
+// Items that don't fit, or have no area, are refused without changing the bin
+static void TestRefused() {
+	BitboardBin bin({100, 40}, 4);
+	CHECK(!bin.TryPackArea({0, 4}).IsValid());
+	CHECK(!bin.TryPackArea({101, 4}).IsValid());
+	// 100 pixels is exactly 25 cells, but only 10 rows of cells
+	CHECK(!bin.TryPackArea({41, 41}).IsValid());
+	CHECK(!bin.TryPackArea({30, 50}, false).IsValid());
+	const Rect rotated = bin.TryPackArea({30, 50});
+	CHECK(SameRect(rotated, Rect{0, 0, 49, 29}));
+	CHECK(bin.GetEmptyRegions().size() == 2);
+}
+
+int main() {
+	TestMatchesOccupancyGrid({150, 90}, 1, 12, 1);
+	TestMatchesOccupancyGrid({300, 130}, 2, 20, 2);
+	TestMatchesOccupancyGrid({530, 203}, 4, 40, 3);
+	TestRefused();
+	return ExitStatus();
+}
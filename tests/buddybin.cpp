@@ -0,0 +1,101 @@
+#include "check.h"
+#include "buddybin.h"
+#include <algorithm>
+
+using namespace BinPacker;
+
+static bool Overlap(Rect a, Rect b) {
+	return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+}
+
+static unsigned int Random(unsigned int& state, unsigned int range) {
+	state = state * 1103515245u + 12345u;
+	return (state >> 16) % range;
+}
+
+// Side of the power-of-two block that holds rect
+static unsigned int BlockSide(Rect rect, unsigned int minBlockSize) {
+	unsigned int side = minBlockSize;
+	while (side < rect.right - rect.left + 1 || side < rect.bottom - rect.top + 1)
+		side <<= 1;
+	return side;
+}
+
+// Packs and releases random areas in a bin whose side is requestedSize rounded down to a power of two,
+// checking that blocks are aligned, never overlap, and tile the bin together with the empty regions
+static void TestPackAndRelease(unsigned int requestedSize, unsigned int minBlockSize, unsigned int seed) {
+	BuddyBin bin(requestedSize, minBlockSize);
+	const unsigned int size = bin.GetDimensions().width;
+	CHECK(size <= requestedSize && size * 2 > requestedSize && bin.GetDimensions().height == size);
+	unsigned int state = seed;
+	std::vector<Rect> live;
+	for (unsigned int i = 0; i < 3000; i++) {
+		if (Random(state, 3) < 2 || live.empty()) {
+			const Rect r = bin.TryPackArea({1 + Random(state, size / 8), 1 + Random(state, size / 8)});
+			if (!r.IsValid())
+				continue;
+			const unsigned int side = BlockSide(r, minBlockSize);
+			CHECK(r.left % side == 0 && r.top % side == 0 && r.left + side <= size && r.top + side <= size);
+			CHECK(std::none_of(live.cbegin(), live.cend(), [&](const Rect & l){ return Overlap(l, r); }));
+			live.push_back(r);
+		} else {
+			const std::size_t released = Random(state, (unsigned int)live.size());
+			bin.Release(live[released]);
+			live.erase(live.begin() + released);
+		}
+
+		if (i % 100 == 0) {
+			unsigned long long area = 0;
+			for (const Rect & r : bin.GetEmptyRegions()) {
+				area += (unsigned long long)(r.right - r.left + 1) * (r.bottom - r.top + 1);
+				CHECK(std::none_of(live.cbegin(), live.cend(), [&](const Rect & l){ return Overlap(l, r); }));
+			}
+			for (const Rect & r : live)
+				area += (unsigned long long)BlockSide(r, minBlockSize) * BlockSide(r, minBlockSize);
+			CHECK(area == (unsigned long long)size * size);
+		}
+	}
+
+	// Releasing every block merges the bin back into a single free block
+	for (const Rect & r : live)
+		bin.Release(r);
+	const std::vector<Rect> regions = bin.GetEmptyRegions();
+	CHECK(regions.size() == 1 && regions[0].left == 0 && regions[0].top == 0 && regions[0].right == size - 1 && regions[0].bottom == size - 1);
+	CHECK(bin.GetInternalFragmentation() == 0.0);
+}
+
+// Releasing a rect that isn't an allocated block leaves the bin unchanged
+static void TestInvalidRelease() {
+	BuddyBin bin(64, 4);
+	const Rect a = bin.TryPackArea({8, 8});
+	const Rect b = bin.TryPackArea({3, 3});
+	CHECK(a.IsValid() && b.IsValid());
+	const std::vector<Rect> before = bin.GetEmptyRegions();
+	bin.Release(Rect{32, 32, 39, 39});
+	bin.Release(Rect{a.left, a.top, a.left + 15, a.top + 15});
+	bin.Release(Rect{0, 0, 63, 63});
+	CHECK(bin.GetEmptyRegions().size() == before.size());
+	CHECK(!bin.TryPackArea({64, 64}).IsValid());
+}
+
+// A large bin of 1x1 blocks only splits the blocks it packs into
+static void TestLargeBin() {
+	BuddyBin bin(16384, 1);
+	CHECK(bin.GetDimensions().width == 16384);
+	const Rect pixel = bin.TryPackArea({1, 1});
+	const Rect half = bin.TryPackArea({8192, 8192});
+	CHECK(pixel.IsValid() && half.IsValid() && !Overlap(pixel, half));
+	CHECK(bin.GetEmptyRegions().size() == 2 + 3 * 13);
+	bin.Release(pixel);
+	bin.Release(half);
+	CHECK(bin.GetEmptyRegions().size() == 1);
+}
+
+int main() {
+	TestPackAndRelease(256, 1, 1);
+	TestPackAndRelease(512, 8, 2);
+	TestPackAndRelease(300, 4, 3);
+	TestInvalidRelease();
+	TestLargeBin();
+	return ExitStatus();
+}
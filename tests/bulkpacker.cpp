@@ -0,0 +1,91 @@
+#include "check.h"
+#include "bulkpacker.h"
+
+using namespace BinPacker;
+
+static bool SameRect(Rect a, Rect b) {
+	return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+static std::vector<Area> MakeItems(unsigned int count, unsigned int seed) {
+	std::vector<Area> items;
+	unsigned int state = seed;
+	for (unsigned int i = 0; i < count; i++) {
+		state = state * 1103515245u + 12345u;
+		items.push_back({1 + (state >> 16) % 24, 1 + (state >> 8) % 24});
+	}
+	return items;
+}
+
+// Unchanged items keep their placements when items are added and removed
+static void TestUpdateKeepsPlacements() {
+	const std::vector<Area> items = MakeItems(400, 1);
+	std::vector<unsigned long long> ids;
+	for (unsigned long long i = 0; i < items.size(); i++)
+		ids.push_back(i);
+	const PackResult previous = PackItems(items);
+
+	std::vector<Area> updatedItems(items.begin() + 10, items.end());
+	std::vector<unsigned long long> updatedIds(ids.begin() + 10, ids.end());
+	for (const Area & added : MakeItems(30, 2)) {
+		updatedItems.push_back(added);
+		updatedIds.push_back(updatedIds.back() + 1);
+	}
+
+	bool repacked = true;
+	const PackResult updated = UpdateItems(previous, ids, updatedIds, updatedItems, PackSettings(), 0.25, &repacked);
+	CHECK(!repacked);
+	CHECK(updated.placements.size() == updatedItems.size());
+	for (std::size_t i = 0; i + 30 < updatedItems.size(); i++)
+		CHECK(SameRect(updated.placements[i], previous.placements[i + 10]));
+	for (const Rect & r : updated.placements)
+		CHECK(r.IsValid());
+}
+
+static bool IsRejected(const PackResult& result) {
+	return result.placements.empty() && result.emptyRegions.empty() && result.dimensions.width == 0 && result.dimensions.height == 0;
+}
+
+// Ids that don't match the items or the previous placements, or that aren't unique, are rejected instead of read out of bounds
+static void TestUpdateRejectsMismatchedIds() {
+	const std::vector<Area> items = MakeItems(50, 3);
+	std::vector<unsigned long long> ids;
+	for (unsigned long long i = 0; i < items.size(); i++)
+		ids.push_back(i);
+	const PackResult previous = PackItems(items);
+	CHECK(!IsRejected(UpdateItems(previous, ids, ids, items)));
+
+	const std::vector<unsigned long long> shortIds(ids.begin(), ids.begin() + 20);
+	CHECK(IsRejected(UpdateItems(previous, ids, shortIds, items)));
+	CHECK(IsRejected(UpdateItems(previous, shortIds, ids, items)));
+	std::vector<unsigned long long> longIds = ids;
+	longIds.push_back(ids.size());
+	CHECK(IsRejected(UpdateItems(previous, longIds, ids, items)));
+
+	std::vector<unsigned long long> duplicateIds = ids;
+	duplicateIds[30] = duplicateIds[10];
+	CHECK(IsRejected(UpdateItems(previous, ids, duplicateIds, items)));
+	CHECK(IsRejected(UpdateItems(previous, duplicateIds, ids, items)));
+}
+
+// Bulk packing gives each list the same result as packing it alone
+static void TestPackBinsMatchesPackItems() {
+	std::vector<std::vector<Area>> itemLists;
+	for (unsigned int i = 0; i < 6; i++)
+		itemLists.push_back(MakeItems(50 + i * 40, 10 + i));
+	const std::vector<PackResult> results = PackBins(itemLists, PackSettings(), 3);
+	CHECK(results.size() == itemLists.size());
+	for (std::size_t i = 0; i < results.size() && i < itemLists.size(); i++) {
+		const PackResult single = PackItems(itemLists[i]);
+		CHECK(results[i].placements.size() == single.placements.size());
+		for (std::size_t j = 0; j < single.placements.size() && j < results[i].placements.size(); j++)
+			CHECK(SameRect(results[i].placements[j], single.placements[j]));
+	}
+}
+
+int main() {
+	TestUpdateKeepsPlacements();
+	TestUpdateRejectsMismatchedIds();
+	TestPackBinsMatchesPackItems();
+	return ExitStatus();
+}
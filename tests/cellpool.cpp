@@ -0,0 +1,112 @@
+#include "check.h"
+#include "cellpool.h"
+#include <set>
+
+using namespace BinPacker;
+
+static bool SameRect(Rect a, Rect b) {
+	return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+static bool Overlap(Rect a, Rect b) {
+	return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+}
+
+static unsigned int Random(unsigned int& state, unsigned int range) {
+	state = state * 1103515245u + 12345u;
+	return (state >> 16) % range;
+}
+
+// Allocations and frees match a set of free cells, where the first free cell is always the one with the lowest index.
+// Small strips spread the cells over more than 64 strips, so the summary takes several words.
+static void TestMatchesFreeSet(Area stripCells, unsigned int seed) {
+	Bin bin;
+	bin.ExtendDimensions({512, 512});
+	const Area cellSize = {3, 5};
+	CellPool pool(bin, cellSize, stripCells);
+	const unsigned int cellsPerStrip = stripCells.width * stripCells.height;
+	std::set<unsigned int> free, allocated;
+	unsigned int strips = 0;
+	unsigned int state = seed;
+	for (unsigned int i = 0; i < 30000; i++) {
+		if (Random(state, 5) < 3 || allocated.empty()) {
+			if (free.empty()) {
+				for (unsigned int c = 0; c < cellsPerStrip; c++)
+					free.insert(strips * 64 + c);
+				strips++;
+			}
+			const unsigned int cell = pool.Allocate();
+			CHECK(cell == *free.begin());
+			free.erase(cell);
+			allocated.insert(cell);
+		} else {
+			auto cell = allocated.begin();
+			std::advance(cell, Random(state, (unsigned int)allocated.size()));
+			if (Random(state, 2) == 0)
+				pool.Free(*cell);
+			else
+				pool.Free(pool.GetCell(*cell));
+			free.insert(*cell);
+			allocated.erase(cell);
+		}
+		CHECK(pool.GetFreeCells() == free.size());
+		CHECK(pool.GetCapacity() == strips * cellsPerStrip);
+	}
+	CHECK(strips > 64);
+
+	// Every cell lies within its strip without overlapping another, and is found again by its position
+	std::vector<Rect> cells;
+	for (unsigned int cell : allocated) {
+		const Rect r = pool.GetCell(cell);
+		CHECK(r.IsValid() && r.right - r.left + 1 == cellSize.width && r.bottom - r.top + 1 == cellSize.height);
+		CHECK(pool.GetCellIndex(r) == cell);
+		cells.push_back(r);
+	}
+	for (std::size_t i = 0; i < cells.size(); i++) {
+		for (std::size_t j = i + 1; j < cells.size(); j++)
+			CHECK(!Overlap(cells[i], cells[j]));
+	}
+}
+
+// Freeing a free cell, a cell that doesn't exist or a rect that isn't a cell changes nothing
+static void TestInvalidFree() {
+	Bin bin;
+	bin.ExtendDimensions({64, 64});
+	CellPool pool(bin, {4, 4}, {3, 3});
+	const unsigned int a = pool.Allocate(), b = pool.Allocate();
+	CHECK(a == 0 && b == 1 && pool.GetFreeCells() == 7);
+	pool.Free(a);
+	pool.Free(a);
+	pool.Free(9u);
+	pool.Free(64u);
+	pool.Free(CellPool::invalidCell);
+	pool.Free(Rect{1, 1, 4, 4});
+	CHECK(pool.GetFreeCells() == 8);
+	CHECK(pool.GetCellIndex(Rect{1, 1, 4, 4}) == CellPool::invalidCell);
+	CHECK(!pool.GetCell(9).IsValid() && !pool.GetCell(64).IsValid());
+	CHECK(pool.Allocate() == a);
+}
+
+// Once no strip fits the bin, allocating fails until a cell is freed
+static void TestFullBin() {
+	Bin bin;
+	bin.ExtendDimensions({64, 64});
+	CellPool pool(bin, {8, 8}, {8, 8});
+	std::vector<Rect> cells;
+	for (Rect r = pool.TryPackArea(); r.IsValid(); r = pool.TryPackArea())
+		cells.push_back(r);
+	CHECK(cells.size() == 64 && pool.GetCapacity() == 64 && pool.GetFreeCells() == 0);
+	CHECK(pool.Allocate() == CellPool::invalidCell);
+	pool.Free(cells[37]);
+	CHECK(SameRect(pool.TryPackArea(), cells[37]));
+	CHECK(!pool.TryPackArea().IsValid());
+}
+
+int main() {
+	TestMatchesFreeSet({8, 8}, 1);
+	TestMatchesFreeSet({2, 2}, 2);
+	TestMatchesFreeSet({5, 3}, 3);
+	TestInvalidFree();
+	TestFullBin();
+	return ExitStatus();
+}
@@ -0,0 +1,22 @@
+// Minimal assertions for the standalone test programs in this directory.
+// Each program runs its checks from main, which prints every failed check and returns ExitStatus(),
+// so the program exits with status 1 if any failed. Build a test with its source file and the sources it uses, e.g.
+//   g++ -std=c++17 -O2 -Isrc tests/stagingbin.cpp src/stagingbin.cpp src/binpacker.cpp -o stagingbintest -pthread
+
+#pragma once
+#include <cstdio>
+
+static int failedChecks = 0;
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+			failedChecks++; \
+		} \
+	} while (false)
+
+// Exit status of a test program: 1 if any check failed, otherwise 0
+static int ExitStatus() {
+	return failedChecks > 0 ? 1 : 0;
+}
@@ -0,0 +1,66 @@
+#include "check.h"
+#include "concurrentbin.h"
+#include <mutex>
+#include <thread>
+
+using namespace BinPacker;
+
+static bool Overlap(Rect a, Rect b) {
+	return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+}
+
+// Items packed from several threads lie within the bin and never overlap each other or the empty regions
+static void TestConcurrentInserts() {
+	ConcurrentBin bin({512, 512}, 4);
+	std::mutex packedMutex;
+	std::vector<Rect> packed;
+	std::vector<std::thread> threads;
+	for (unsigned int t = 0; t < 4; t++) {
+		threads.emplace_back([&, t]() {
+			unsigned int state = t + 1;
+			for (unsigned int i = 0; i < 500; i++) {
+				state = state * 1103515245u + 12345u;
+				const Rect r = bin.TryPackArea({1 + (state >> 16) % 16, 1 + (state >> 8) % 16});
+				if (r.IsValid()) {
+					std::lock_guard<std::mutex> lock(packedMutex);
+					packed.push_back(r);
+				}
+			}
+		});
+	}
+	for (std::thread & thread : threads)
+		thread.join();
+	bin.Rebalance();
+
+	CHECK(packed.size() > 1000);
+	const std::vector<Rect> emptyRegions = bin.GetEmptyRegions();
+	for (std::size_t i = 0; i < packed.size(); i++) {
+		CHECK(packed[i].right < 512 && packed[i].bottom < 512);
+		for (std::size_t j = i + 1; j < packed.size(); j++)
+			CHECK(!Overlap(packed[i], packed[j]));
+		for (const Rect & r : emptyRegions)
+			CHECK(!Overlap(packed[i], r));
+	}
+}
+
+// The used area counts padding and size alignment, like the space the items take from the bin
+static void TestUsedAreaIncludesPadding() {
+	PackConstraints constraints;
+	constraints.padding = {1, 1, 1, 1};
+	constraints.sizeAlignment = {4, 4};
+	ConcurrentBin bin({256, 256}, 2);
+	unsigned long long reservedArea = 0;
+	for (unsigned int i = 0; i < 50; i++) {
+		const Rect r = bin.TryPackArea({5, 3}, constraints);
+		CHECK(r.IsValid());
+		const unsigned int width = r.right - r.left + 1;
+		reservedArea += (unsigned long long)((width + 3) / 4 * 4 + 2) * ((r.bottom - r.top + 1 + 3) / 4 * 4 + 2);
+	}
+	CHECK(bin.GetUsedArea() == reservedArea);
+}
+
+int main() {
+	TestConcurrentInserts();
+	TestUsedAreaIncludesPadding();
+	return ExitStatus();
+}
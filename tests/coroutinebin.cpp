@@ -0,0 +1,136 @@
+#include "check.h"
+#include "coroutinebin.h"
+
+using namespace BinPacker;
+
+// Coroutine that starts immediately and destroys itself when it finishes
+struct Task {
+	struct promise_type {
+		Task get_return_object() { return {}; }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+	};
+};
+
+static Task PackInto(CoroutineBin& bin, Area area, Rect& result, bool& done) {
+	result = co_await bin.Pack(area);
+	done = true;
+}
+
+static bool Overlap(Rect a, Rect b) {
+	return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+}
+
+static Bin MakeBin(Area dimensions) {
+	Bin bin;
+	bin.ExtendDimensions(dimensions);
+	return bin;
+}
+
+// Areas that fit are packed without suspending, and a waiter resumes once an asynchronous growth completes
+static void TestResumeAfterGrowth() {
+	std::vector<CoroutineBin::GrowthCompletion> completions;
+	std::vector<Area> handlerDimensions;
+	CoroutineBin bin(MakeBin({16, 16}), [&](Area dimensions, const std::vector<Area> & pending, CoroutineBin::GrowthCompletion complete) {
+		CHECK(pending.size() == 1 && pending[0].width == 16 && pending[0].height == 8);
+		handlerDimensions.push_back(dimensions);
+		completions.push_back(std::move(complete));
+	});
+
+	Rect first = {1, 1, 0, 0}, second = {1, 1, 0, 0};
+	bool firstDone = false, secondDone = false;
+	PackInto(bin, {16, 12}, first, firstDone);
+	CHECK(firstDone && first.IsValid() && completions.empty());
+
+	PackInto(bin, {16, 8}, second, secondDone);
+	CHECK(!secondDone && completions.size() == 1);
+	CHECK(handlerDimensions.size() == 1 && handlerDimensions[0].width == 16 && handlerDimensions[0].height == 16);
+
+	completions[0]({0, 16});
+	CHECK(secondDone && second.IsValid() && !Overlap(first, second));
+	CHECK(completions.size() == 1);
+	CHECK(bin.GetDimensions().width == 16 && bin.GetDimensions().height == 32);
+	CHECK(bin.GetPendingAreas().empty());
+}
+
+// A handler that completes before returning resumes the waiter from within await_suspend
+static void TestSynchronousHandler() {
+	unsigned int growths = 0;
+	CoroutineBin bin(MakeBin({8, 8}), [&](Area dimensions, const std::vector<Area> &, CoroutineBin::GrowthCompletion complete) {
+		growths++;
+		complete(dimensions);
+	});
+
+	std::vector<Rect> results(40, Rect{1, 1, 0, 0});
+	bool done[40] = {};
+	for (unsigned int i = 0; i < 40; i++) {
+		PackInto(bin, {4 + i % 5, 4 + i % 3}, results[i], done[i]);
+		CHECK(done[i] && results[i].IsValid());
+	}
+	CHECK(growths > 0);
+	for (unsigned int i = 0; i < 40; i++) {
+		for (unsigned int j = i + 1; j < 40; j++)
+			CHECK(!Overlap(results[i], results[j]));
+	}
+}
+
+// A bin that can't grow fails every waiting pack, with or without a handler
+static void TestCannotGrow() {
+	CoroutineBin bin(MakeBin({16, 16}), [](Area, const std::vector<Area> &, CoroutineBin::GrowthCompletion complete) {
+		complete({0, 0});
+	});
+	Rect result = {0, 0, 0, 0};
+	bool done = false;
+	PackInto(bin, {32, 4}, result, done);
+	CHECK(done && !result.IsValid());
+	CHECK(bin.GetDimensions().width == 16 && bin.GetDimensions().height == 16);
+
+	CoroutineBin unhandled(MakeBin({16, 16}), nullptr);
+	done = false;
+	result = {0, 0, 0, 0};
+	PackInto(unhandled, {4, 32}, result, done);
+	CHECK(done && !result.IsValid());
+	PackInto(unhandled, {4, 4}, result, done);
+	CHECK(result.IsValid());
+}
+
+// Waiters that arrive during a growth share it, and the handler can size the growth for all of them
+static void TestSharedGrowth() {
+	unsigned int growths = 0;
+	CoroutineBin::GrowthCompletion completion;
+	CoroutineBin bin(MakeBin({16, 16}), [&](Area, const std::vector<Area> &, CoroutineBin::GrowthCompletion complete) {
+		growths++;
+		completion = std::move(complete);
+	});
+
+	const unsigned int count = 6;
+	std::vector<Rect> results(count, Rect{1, 1, 0, 0});
+	bool done[count] = {};
+	for (unsigned int i = 0; i < count; i++)
+		PackInto(bin, {16, 10}, results[i], done[i]);
+	CHECK(done[0] && growths == 1);
+
+	const std::vector<Area> pending = bin.GetPendingAreas();
+	CHECK(pending.size() == count - 1);
+	unsigned int height = 0;
+	for (const Area & area : pending)
+		height += area.height;
+	completion({0, height});
+
+	CHECK(growths == 1);
+	for (unsigned int i = 0; i < count; i++) {
+		CHECK(done[i] && results[i].IsValid());
+		for (unsigned int j = i + 1; j < count; j++)
+			CHECK(!Overlap(results[i], results[j]));
+	}
+}
+
+int main() {
+	TestResumeAfterGrowth();
+	TestSynchronousHandler();
+	TestCannotGrow();
+	TestSharedGrowth();
+	return ExitStatus();
+}
@@ -0,0 +1,110 @@
+#include "check.h"
+#include "defragmenter.h"
+#include <algorithm>
+
+using namespace BinPacker;
+
+static bool SameRect(Rect a, Rect b) {
+	return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+static bool Overlap(Rect a, Rect b) {
+	return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+}
+
+static unsigned long long LargestRegion(const Bin& bin) {
+	unsigned long long largest = 0;
+	for (const Rect & r : bin.GetEmptyRegions())
+		largest = std::max(largest, (unsigned long long)(r.right - r.left + 1) * (r.bottom - r.top + 1));
+	return largest;
+}
+
+// Whether the empty regions cover exactly the pixels of the bin outside every one of reserved
+static bool IsEmptyExcept(const Bin& bin, const std::vector<Rect>& reserved) {
+	const Area dimensions = bin.GetDimensions();
+	const std::vector<Rect> & regions = bin.GetEmptyRegions();
+	auto covers = [](const Rect & r, unsigned int x, unsigned int y) { return x >= r.left && x <= r.right && y >= r.top && y <= r.bottom; };
+	for (unsigned int y = 0; y < dimensions.height; y++) {
+		for (unsigned int x = 0; x < dimensions.width; x++) {
+			const bool empty = std::any_of(regions.cbegin(), regions.cend(), [&](const Rect & r){ return covers(r, x, y); });
+			if (empty == std::any_of(reserved.cbegin(), reserved.cend(), [&](const Rect & r){ return covers(r, x, y); }))
+				return false;
+		}
+	}
+	return true;
+}
+
+// Each relocation moves a live rect to space that no other rect occupies at that point, so the moves can be copied in order.
+// Releasing every third rect leaves too little free space to move blocked rects out of the way, so only part of the plan is found.
+static void TestMoveOrder(unsigned int releaseEvery, bool complete) {
+	Bin bin;
+	bin.ExtendDimensions({128, 128});
+	unsigned int state = 5;
+	std::vector<Rect> packed;
+	for (unsigned int i = 0; i < 400; i++) {
+		state = state * 1103515245u + 12345u;
+		const unsigned int width = 2 + (state >> 16) % 14;
+		state = state * 1103515245u + 12345u;
+		const Rect r = bin.TryPackArea({width, 2 + (state >> 16) % 14});
+		if (r.IsValid())
+			packed.push_back(r);
+	}
+	std::vector<Rect> live;
+	for (std::size_t i = 0; i < packed.size(); i++) {
+		if (i % releaseEvery == 0)
+			bin.Release(packed[i]);
+		else
+			live.push_back(packed[i]);
+	}
+	const unsigned long long largestBefore = LargestRegion(bin);
+
+	Defragmenter defragmenter(bin, live);
+	CHECK(defragmenter.IsPlanned() == complete);
+	CHECK(defragmenter.GetRemainingMoves() > 0);
+	unsigned int moves = 0;
+	while (!defragmenter.IsDone()) {
+		const std::size_t remaining = defragmenter.GetRemainingMoves();
+		const std::vector<Relocation> applied = defragmenter.Step(7);
+		CHECK(!applied.empty() && applied.size() <= 7 && defragmenter.GetRemainingMoves() == remaining - applied.size());
+		for (const Relocation & r : applied) {
+			auto from = std::find_if(live.begin(), live.end(), [&](const Rect & l){ return SameRect(l, r.from); });
+			CHECK(from != live.end());
+			if (from == live.end())
+				continue;
+			CHECK(!Overlap(r.from, r.to));
+			const Area size = { r.to.right - r.to.left + 1, r.to.bottom - r.to.top + 1 };
+			CHECK(r.rotated == (size.width != r.from.right - r.from.left + 1));
+			CHECK(std::none_of(live.cbegin(), live.cend(), [&](const Rect & l){ return Overlap(l, r.to); }));
+			*from = r.to;
+			moves++;
+		}
+	}
+	CHECK(moves > 0);
+	CHECK(IsEmptyExcept(bin, live));
+	if (complete)
+		CHECK(LargestRegion(bin) > largestBefore);
+}
+
+// Rects that can't be repacked largest first into an empty bin are reported, and the bin is left as it is
+static void TestRepackFailure() {
+	// Fills an 8x8 bin exactly, in a layout that largest first doesn't find
+	const std::vector<Rect> live = { {0, 0, 6, 0}, {0, 1, 6, 2}, {0, 3, 6, 6}, {0, 7, 6, 7}, {7, 0, 7, 7} };
+	Bin bin;
+	bin.ExtendDimensions({8, 8});
+	for (const Rect & r : live)
+		CHECK(bin.Reserve(r));
+	const unsigned long long revision = bin.GetRevision();
+
+	Defragmenter defragmenter(bin, live);
+	CHECK(!defragmenter.IsPlanned());
+	CHECK(defragmenter.IsDone() && defragmenter.GetRemainingMoves() == 0);
+	CHECK(defragmenter.Step(16).empty());
+	CHECK(bin.GetRevision() == revision && bin.GetEmptyRegions().empty());
+}
+
+int main() {
+	TestMoveOrder(2, true);
+	TestMoveOrder(3, false);
+	TestRepackFailure();
+	return ExitStatus();
+}
@@ -0,0 +1,70 @@
+#include "check.h"
+#include "hybridbin.h"
+
+using namespace BinPacker;
+
+static unsigned int AlignUp(unsigned int value, unsigned int alignment) {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+// Returns the space the bin reserves for rect: its size alignment and padding, dropped along the bin's edges if allowed
+static Rect GetReserved(Rect rect, Area dimensions, const PackConstraints& constraints) {
+	const Padding & padding = constraints.padding;
+	const unsigned int right = rect.left + AlignUp(rect.right - rect.left + 1, constraints.sizeAlignment.width) - 1 + padding.right;
+	const unsigned int bottom = rect.top + AlignUp(rect.bottom - rect.top + 1, constraints.sizeAlignment.height) - 1 + padding.bottom;
+	if (constraints.padBinEdges)
+		return Rect{rect.left - padding.left, rect.top - padding.top, right, bottom};
+	return Rect{rect.left - std::min(rect.left, padding.left), rect.top - std::min(rect.top, padding.top),
+		std::min(right, dimensions.width - 1), std::min(bottom, dimensions.height - 1)};
+}
+
+static bool Overlap(Rect a, Rect b) {
+	return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+}
+
+// Items packed into cell pools honour the same constraints as items packed into the bin
+static void TestConstraints(bool padBinEdges) {
+	PackConstraints constraints;
+	constraints.padding = {1, 2, 3, 1};
+	constraints.padBinEdges = padBinEdges;
+	constraints.positionAlignment = {4, 2};
+	constraints.sizeAlignment = {2, 4};
+	Bin bin;
+	bin.ExtendDimensions({512, 512});
+	HybridBin hybrid(std::move(bin), constraints, 8);
+
+	std::vector<Rect> packed;
+	unsigned int state = 7;
+	for (unsigned int i = 0; i < 1500; i++) {
+		state = state * 1103515245u + 12345u;
+		const unsigned int maxSide = i % 8 == 0 ? 24 : 8;
+		const Area area = {1 + (state >> 16) % maxSide, 1 + (state >> 8) % maxSide};
+		const Rect r = hybrid.TryPackArea(area);
+		if (!r.IsValid())
+			continue;
+		const unsigned int width = r.right - r.left + 1, height = r.bottom - r.top + 1;
+		CHECK((width == area.width && height == area.height) || (width == area.height && height == area.width));
+		CHECK(r.left % 4 == 0 && r.top % 2 == 0);
+		if (i % 5 == 0)
+			hybrid.Release(r);
+		else
+			packed.push_back(r);
+	}
+	CHECK(packed.size() > 1000);
+
+	const Area dimensions = hybrid.GetDimensions();
+	for (std::size_t i = 0; i < packed.size(); i++) {
+		const Rect reserved = GetReserved(packed[i], dimensions, constraints);
+		CHECK(reserved.right < dimensions.width && reserved.bottom < dimensions.height);
+		for (std::size_t j = i + 1; j < packed.size(); j++)
+			CHECK(!Overlap(reserved, GetReserved(packed[j], dimensions, constraints)));
+		for (const Rect & r : hybrid.GetEmptyRegions())
+			CHECK(!Overlap(packed[i], r));
+	}
+}
+
+int main() {
+	TestConstraints(true);
+	TestConstraints(false);
+	return ExitStatus();
+}
@@ -0,0 +1,78 @@
+#include "check.h"
+#include "journaledbin.h"
+#include <filesystem>
+
+using namespace BinPacker;
+
+static const std::string journalPath = "journaledbintest.journal";
+
+static bool SameRects(const std::vector<Rect>& a, const std::vector<Rect>& b) {
+	if (a.size() != b.size())
+		return false;
+	for (std::size_t i = 0; i < a.size(); i++) {
+		if (a[i].left != b[i].left || a[i].top != b[i].top || a[i].right != b[i].right || a[i].bottom != b[i].bottom)
+			return false;
+	}
+	return true;
+}
+
+static void RemoveFiles() {
+	std::filesystem::remove_all(journalPath);
+	std::filesystem::remove_all(journalPath + ".checkpoint");
+	std::filesystem::remove_all(journalPath + ".checkpoint.tmp");
+}
+
+// Reopening a journaled bin rebuilds the same empty regions
+static void TestReopen() {
+	RemoveFiles();
+	std::vector<Rect> emptyRegions;
+	{
+		JournaledBin bin(journalPath, 4, 16);
+		CHECK(bin.Open());
+		bin.ExtendDimensions({256, 256});
+		for (unsigned int i = 0; i < 100; i++) {
+			const Rect packed = bin.TryPackArea({1 + i % 13, 1 + i % 7});
+			if (i % 3 == 0)
+				bin.Release(packed);
+		}
+		CHECK(bin.Sync());
+		emptyRegions = bin.GetBin().GetEmptyRegions();
+	}
+
+	JournaledBin reopened(journalPath);
+	CHECK(reopened.Open());
+	CHECK(SameRects(reopened.GetBin().GetEmptyRegions(), emptyRegions));
+	RemoveFiles();
+}
+
+// When checkpoints can't be written, operations keep being synced to the current journal
+static void TestFailedCheckpoint() {
+	RemoveFiles();
+	std::vector<Rect> emptyRegions;
+	{
+		JournaledBin bin(journalPath, 4, 16);
+		CHECK(bin.Open());
+		std::filesystem::create_directory(journalPath + ".checkpoint.tmp");
+		CHECK(!bin.Checkpoint());
+
+		bin.ExtendDimensions({256, 256});
+		for (unsigned int i = 0; i < 100; i++)
+			bin.TryPackArea({1 + i % 13, 1 + i % 7});
+		// Operations past the first failed automatic checkpoint have already been synced
+		CHECK(std::filesystem::file_size(journalPath) > 12 + 100 * 4);
+		CHECK(bin.Sync());
+		emptyRegions = bin.GetBin().GetEmptyRegions();
+	}
+	std::filesystem::remove_all(journalPath + ".checkpoint.tmp");
+
+	JournaledBin reopened(journalPath);
+	CHECK(reopened.Open());
+	CHECK(SameRects(reopened.GetBin().GetEmptyRegions(), emptyRegions));
+	RemoveFiles();
+}
+
+int main() {
+	TestReopen();
+	TestFailedCheckpoint();
+	return ExitStatus();
+}
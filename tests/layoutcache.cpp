@@ -0,0 +1,110 @@
+#include "check.h"
+#include "layoutcache.h"
+#include <filesystem>
+#include <thread>
+
+using namespace BinPacker;
+
+static const std::string cacheDirectory = "layoutcachetest";
+
+// Items from a fixed linear congruential sequence, so every platform packs the same list
+static std::vector<Area> MakeItems(unsigned int count) {
+	std::vector<Area> items;
+	unsigned int state = 12345;
+	for (unsigned int i = 0; i < count; i++) {
+		state = state * 1103515245u + 12345u;
+		const unsigned int width = 1 + (state >> 16) % 48;
+		state = state * 1103515245u + 12345u;
+		items.push_back({width, 1 + (state >> 16) % 48});
+	}
+	return items;
+}
+
+// FNV-1a of the dimensions, placements and empty regions of a layout
+static unsigned long long HashResult(const PackResult& result) {
+	unsigned long long hash = 14695981039346656037ull;
+	auto add = [&](unsigned int value) {
+		for (unsigned int i = 0; i < 4; i++)
+			hash = (hash ^ ((value >> (i * 8)) & 0xFF)) * 1099511628211ull;
+	};
+	add(result.dimensions.width);
+	add(result.dimensions.height);
+	for (const std::vector<Rect>* rects : {&result.placements, &result.emptyRegions}) {
+		add((unsigned int)rects->size());
+		for (const Rect & r : *rects) {
+			add(r.left);
+			add(r.top);
+			add(r.right);
+			add(r.bottom);
+		}
+	}
+	return hash;
+}
+
+static void ResetDirectory() {
+	std::filesystem::remove_all(cacheDirectory);
+	std::filesystem::create_directory(cacheDirectory);
+}
+
+// Packing is bit-identical between runs, and matches the layout recorded when the cache format was last changed
+static void TestDeterminism() {
+	const std::vector<Area> items = MakeItems(2000);
+	PackSettings settings;
+	settings.constraints.padding = {1, 1, 1, 1};
+	const unsigned long long hash = HashResult(PackItems(items, settings));
+	CHECK(HashResult(PackItems(items, settings)) == hash);
+	CHECK(hash == 0x614e26ba0223f625ull);
+}
+
+// The same input is a hit with the same layout, and verifying every hit finds no difference
+static void TestHit() {
+	ResetDirectory();
+	const std::vector<Area> items = MakeItems(500);
+	LayoutCache cache(cacheDirectory, 1);
+	const PackResult packed = cache.Pack(items);
+	const PackResult cached = cache.Pack(items);
+	CHECK(cache.GetMisses() == 1 && cache.GetHits() == 1);
+	CHECK(cache.GetVerificationFailures() == 0);
+	CHECK(HashResult(cached) == HashResult(packed));
+	CHECK(HashResult(cached) == HashResult(PackItems(items)));
+
+	std::vector<Area> changed = items;
+	changed.back().width++;
+	cache.Pack(changed);
+	CHECK(cache.GetMisses() == 2);
+}
+
+// Several builds storing the same entry at once leave one complete entry and no temporary files
+static void TestConcurrentStores() {
+	ResetDirectory();
+	const std::vector<Area> items = MakeItems(300);
+	std::vector<std::thread> threads;
+	for (unsigned int t = 0; t < 8; t++) {
+		threads.emplace_back([&]() {
+			LayoutCache cache(cacheDirectory, 0);
+			for (unsigned int i = 0; i < 4; i++) {
+				cache.Pack(items);
+			}
+		});
+	}
+	for (std::thread & thread : threads)
+		thread.join();
+
+	unsigned int files = 0;
+	for (const auto & entry : std::filesystem::directory_iterator(cacheDirectory))
+		files += entry.path().extension() == ".layout" ? 1 : 100;
+	CHECK(files == 1);
+
+	LayoutCache cache(cacheDirectory, 0);
+	const PackResult cached = cache.Pack(items);
+	CHECK(cache.GetHits() == 1);
+	CHECK(HashResult(cached) == HashResult(PackItems(items)));
+	std::filesystem::remove_all(cacheDirectory);
+}
+
+int main() {
+	TestDeterminism();
+	TestHit();
+	TestConcurrentStores();
+	return ExitStatus();
+}
@@ -0,0 +1,121 @@
+#include "check.h"
+#include "packservice.h"
+#include <algorithm>
+
+using namespace BinPacker;
+
+static bool SameRect(Rect a, Rect b) {
+	return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+static bool Overlap(Rect a, Rect b) {
+	return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+}
+
+static std::vector<Area> MakeItems(unsigned int count, unsigned int maxSide, unsigned int seed) {
+	std::vector<Area> items;
+	unsigned int state = seed;
+	for (unsigned int i = 0; i < count; i++) {
+		state = state * 1103515245u + 12345u;
+		const unsigned int width = 1 + (state >> 16) % maxSide;
+		state = state * 1103515245u + 12345u;
+		items.push_back({width, 1 + (state >> 16) % maxSide});
+	}
+	return items;
+}
+
+// Requests from one thread are packed in the order they were submitted, so the placements match packing them directly
+static void TestOrder() {
+	const std::vector<Area> items = MakeItems(500, 16, 1);
+	Bin bin;
+	bin.ExtendDimensions({256, 256});
+	Bin expectedBin = bin;
+	const std::vector<Rect> expected = expectedBin.TryPackAreas(items);
+
+	std::vector<std::future<Rect>> results;
+	{
+		PackService service(std::move(bin), PackConstraints(), nullptr, 7);
+		for (const Area & item : items)
+			results.push_back(service.Pack(item));
+	}
+	for (std::size_t i = 0; i < items.size(); i++)
+		CHECK(SameRect(results[i].get(), expected[i]));
+}
+
+// Every request from many threads is completed, with futures or callbacks, without any two placements overlapping
+static void TestCompletion() {
+	const unsigned int threadCount = 8, itemsPerThread = 200;
+	Bin bin;
+	bin.ExtendDimensions({1024, 1024});
+	std::vector<std::vector<Rect>> placements(threadCount, std::vector<Rect>(itemsPerThread, Rect{1, 1, 0, 0}));
+	std::atomic<unsigned int> callbacks(0);
+	{
+		PackService service(std::move(bin));
+		std::vector<std::thread> producers;
+		for (unsigned int t = 0; t < threadCount; t++) {
+			producers.emplace_back([&, t]() {
+				const std::vector<Area> items = MakeItems(itemsPerThread, 12, t + 1);
+				std::vector<std::future<Rect>> futures(itemsPerThread);
+				for (unsigned int i = 0; i < itemsPerThread; i++) {
+					if (i % 2 == 0) {
+						futures[i] = service.Pack(items[i]);
+					} else {
+						// Each callback writes its own element, and the service's destructor waits for every callback
+						service.Pack(items[i], [&placements, &callbacks, t, i](Rect r) {
+							placements[t][i] = r;
+							callbacks++;
+						});
+					}
+				}
+				for (unsigned int i = 0; i < itemsPerThread; i += 2)
+					placements[t][i] = futures[i].get();
+			});
+		}
+		for (std::thread & producer : producers)
+			producer.join();
+	}
+
+	CHECK(callbacks == threadCount * itemsPerThread / 2);
+	std::vector<Rect> all;
+	for (const std::vector<Rect> & rects : placements)
+		all.insert(all.end(), rects.cbegin(), rects.cend());
+	for (std::size_t i = 0; i < all.size(); i++) {
+		CHECK(all[i].IsValid());
+		for (std::size_t j = i + 1; j < all.size(); j++)
+			CHECK(!Overlap(all[i], all[j]));
+	}
+}
+
+// The growth handler is called for areas that don't fit, and areas it can't make room for complete as invalid
+static void TestGrowth() {
+	Bin bin;
+	bin.ExtendDimensions({32, 32});
+	unsigned int growths = 0;
+	auto grow = [&growths](Bin& bin, Area) {
+		if (bin.GetDimensions().width >= 256)
+			return false;
+		growths++;
+		bin.ExtendDimensions(bin.GetDimensions());
+		return true;
+	};
+	std::vector<std::future<Rect>> results;
+	{
+		PackService service(std::move(bin), PackConstraints(), grow);
+		for (const Area & item : MakeItems(300, 16, 4))
+			results.push_back(service.Pack(item));
+		results.push_back(service.Pack({300, 300}));
+	}
+	CHECK(growths > 0);
+	for (std::size_t i = 0; i + 1 < results.size(); i++) {
+		const Rect r = results[i].get();
+		CHECK(r.IsValid() && r.right < 256 && r.bottom < 256);
+	}
+	CHECK(!results.back().get().IsValid());
+}
+
+int main() {
+	TestOrder();
+	TestCompletion();
+	TestGrowth();
+	return ExitStatus();
+}
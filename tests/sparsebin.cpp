@@ -0,0 +1,134 @@
+#include "check.h"
+#include "sparsebin.h"
+#include <algorithm>
+
+using namespace BinPacker;
+
+static bool SameRect(Rect a, Rect b) {
+	return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+static bool Overlap(Rect a, Rect b) {
+	return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+}
+
+static unsigned int Random(unsigned int& state, unsigned int range) {
+	state = state * 1103515245u + 12345u;
+	return (state >> 16) % range;
+}
+
+// Whether rect lies within a single tile
+static bool WithinTile(Rect rect, unsigned int tileSize) {
+	return rect.left / tileSize == rect.right / tileSize && rect.top / tileSize == rect.bottom / tileSize;
+}
+
+// Tiles are only materialized as items are packed into them, and untouched tiles are reported as single empty regions
+static void TestMaterialization() {
+	SparseBin bin({1000000, 1000000}, 64, 2);
+	CHECK(bin.GetMaterializedTileCount() == 0);
+	CHECK(bin.GetEmptyRegions(Rect{0, 0, 127, 63}).size() == 2);
+
+	unsigned int state = 1;
+	std::vector<Rect> packed;
+	unsigned long long area = 0;
+	for (unsigned int i = 0; i < 300; i++) {
+		const Area item = { 1 + Random(state, 24), 1 + Random(state, 24) };
+		const Rect r = bin.TryPackArea(item);
+		CHECK(r.IsValid() && WithinTile(r, 64));
+		CHECK((r.right - r.left + 1 == item.width && r.bottom - r.top + 1 == item.height)
+			|| (r.right - r.left + 1 == item.height && r.bottom - r.top + 1 == item.width));
+		for (const Rect & p : packed)
+			CHECK(!Overlap(p, r));
+		packed.push_back(r);
+		area += (unsigned long long)item.width * item.height;
+	}
+	CHECK(bin.GetUsedArea() == area);
+	// Far fewer tiles than items, and about as many as the items' area needs
+	CHECK(bin.GetMaterializedTileCount() > area / (64 * 64) && bin.GetMaterializedTileCount() < area / (64 * 64) * 3);
+
+	// The empty regions of the packed tiles exclude every packed item
+	for (const Rect & r : bin.GetEmptyRegions(Rect{0, 0, 64 * 40 - 1, 64 * 40 - 1})) {
+		for (const Rect & p : packed)
+			CHECK(!Overlap(p, r));
+	}
+}
+
+// A tile whose items are all released is forgotten, reported as untouched again, and materialized again before any new tile
+static void TestReleaseToUntouched() {
+	SparseBin bin({512, 512}, 64, 1);
+	std::vector<Rect> first, second;
+	for (unsigned int i = 0; i < 16; i++)
+		first.push_back(bin.TryPackArea({16, 16}));
+	for (unsigned int i = 0; i < 4; i++)
+		second.push_back(bin.TryPackArea({16, 16}));
+	CHECK(bin.GetMaterializedTileCount() == 2);
+	const Rect firstTile = {first[0].left / 64 * 64, first[0].top / 64 * 64, first[0].left / 64 * 64 + 63, first[0].top / 64 * 64 + 63};
+	for (const Rect & r : first)
+		CHECK(r.IsValid() && r.left >= firstTile.left && r.right <= firstTile.right && r.top >= firstTile.top && r.bottom <= firstTile.bottom);
+
+	for (const Rect & r : first)
+		bin.Release(r);
+	CHECK(bin.GetMaterializedTileCount() == 1);
+	CHECK(bin.GetUsedArea() == 4 * 16 * 16);
+	const std::vector<Rect> regions = bin.GetEmptyRegions(firstTile);
+	CHECK(regions.size() == 1 && SameRect(regions[0], firstTile));
+
+	// The second tile is active, so a tile is only needed again for an item that doesn't fit it
+	const Rect large = bin.TryPackArea({64, 64});
+	CHECK(large.IsValid() && SameRect(large, firstTile));
+	CHECK(bin.GetMaterializedTileCount() == 2);
+}
+
+// Items larger than a tile in every allowed orientation are refused without materializing a tile
+static void TestOversized() {
+	SparseBin bin({10000, 10000}, 100);
+	CHECK(!bin.TryPackArea({101, 50}, false).IsValid());
+	CHECK(!bin.TryPackArea({101, 101}).IsValid());
+	CHECK(!bin.TryPackArea({0, 10}).IsValid());
+	CHECK(bin.GetMaterializedTileCount() == 0 && bin.GetUsedArea() == 0);
+	const Rect tall = bin.TryPackArea({50, 100}, false);
+	CHECK(tall.IsValid() && tall.right - tall.left + 1 == 50 && tall.bottom - tall.top + 1 == 100);
+	CHECK(bin.GetMaterializedTileCount() == 1);
+
+	// A bin that isn't a whole number of tiles has partial tiles along its edges, which are only used for items that fit them
+	SparseBin edges({150, 100}, 100, 1);
+	CHECK(SameRect(edges.TryPackArea({100, 100}), Rect{0, 0, 99, 99}));
+	CHECK(!edges.TryPackArea({60, 60}).IsValid());
+	CHECK(SameRect(edges.TryPackArea({50, 100}, false), Rect{100, 0, 149, 99}));
+}
+
+// Once every tile is materialized, items that fit no active tile are packed into space released in inactive tiles
+static void TestInactiveTiles() {
+	SparseBin bin({256, 256}, 64, 2);
+	std::vector<Rect> packed;
+	for (Rect r = bin.TryPackArea({8, 8}); r.IsValid(); r = bin.TryPackArea({8, 8}))
+		packed.push_back(r);
+	CHECK(packed.size() == 16 * 64 && bin.GetMaterializedTileCount() == 16);
+
+	// Free a 16x16 square in each of a few tiles, leaving every tile partly used
+	unsigned int state = 3;
+	std::vector<Rect> freed;
+	for (unsigned int tile : {0u, 5u, 10u, 15u}) {
+		const unsigned int left = tile % 4 * 64 + Random(state, 4) * 16, top = tile / 4 * 64 + Random(state, 4) * 16;
+		for (const Rect & r : packed) {
+			if (r.left >= left && r.right < left + 16 && r.top >= top && r.bottom < top + 16)
+				bin.Release(r);
+		}
+		freed.push_back(Rect{left, top, left + 15, top + 15});
+	}
+	CHECK(bin.GetMaterializedTileCount() == 16);
+	for (unsigned int i = 0; i < 4; i++) {
+		const Rect r = bin.TryPackArea({16, 16});
+		CHECK(std::any_of(freed.cbegin(), freed.cend(), [&](const Rect & f){ return SameRect(f, r); }));
+	}
+	CHECK(!bin.TryPackArea({16, 16}).IsValid());
+	CHECK(!bin.TryPackArea({1, 1}).IsValid());
+}
+
+int main() {
+	TestMaterialization();
+	TestReleaseToUntouched();
+	TestOversized();
+	TestInactiveTiles();
+	return ExitStatus();
+}
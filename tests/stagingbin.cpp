@@ -0,0 +1,68 @@
+#include "check.h"
+#include "stagingbin.h"
+#include <algorithm>
+
+using namespace BinPacker;
+
+static bool Contains(Rect outer, Rect inner) {
+	return inner.left >= outer.left && inner.top >= outer.top && inner.right <= outer.right && inner.bottom <= outer.bottom;
+}
+
+// A block that only fits rotated isn't leased, as the staging bin would extend past it
+static void TestLeaseIsNotRotated() {
+	Bin bin;
+	bin.ExtendDimensions({100, 100});
+	CHECK(bin.TryPackArea({100, 60}).IsValid());
+	SharedBin shared(std::move(bin));
+
+	StagingBin rotated = shared.Lease({40, 90});
+	CHECK(!rotated.IsValid());
+
+	StagingBin staging = shared.Lease({90, 40});
+	CHECK(staging.IsValid());
+	const Rect block = staging.GetBlock();
+	CHECK(block.right - block.left + 1 == 90 && block.bottom - block.top + 1 == 40);
+	const Rect packed = staging.TryPackArea({40, 30});
+	CHECK(packed.IsValid() && Contains(block, packed));
+	shared.Return(std::move(staging));
+
+	for (const Rect & r : shared.GetEmptyRegions())
+		CHECK(r.right < 100 && r.bottom < 100);
+}
+
+// Items packed into leased blocks stay within them, and returning the leases gives their empty space back
+static void TestItemsStayInBlock() {
+	Bin bin;
+	bin.ExtendDimensions({256, 256});
+	SharedBin shared(std::move(bin));
+
+	PackConstraints constraints;
+	constraints.padding = {1, 1, 1, 1};
+	StagingBin staging = shared.Lease({64, 64}, constraints);
+	CHECK(staging.IsValid());
+	std::vector<Rect> packed;
+	for (unsigned int i = 0; i < 20; i++) {
+		packed.push_back(staging.TryPackArea({3 + i % 5, 5 + i % 3}));
+		CHECK(packed.back().IsValid() && Contains(staging.GetBlock(), packed.back()));
+	}
+	shared.Return(std::move(staging));
+	CHECK(!staging.IsValid());
+
+	// Every pixel of the bin is empty again except those reserved for the items and their padding
+	unsigned long long reservedArea = 0;
+	for (const Rect & r : packed)
+		reservedArea += (unsigned long long)(r.right - r.left + 3) * (r.bottom - r.top + 3);
+	const std::vector<Rect> emptyRegions = shared.GetEmptyRegions();
+	unsigned long long emptyArea = 0;
+	for (unsigned int y = 0; y < 256; y++) {
+		for (unsigned int x = 0; x < 256; x++)
+			emptyArea += std::any_of(emptyRegions.cbegin(), emptyRegions.cend(), [&](const Rect & r){ return Contains(r, Rect{x, y, x, y}); });
+	}
+	CHECK(emptyArea == 256 * 256 - reservedArea);
+}
+
+int main() {
+	TestLeaseIsNotRotated();
+	TestItemsStayInBlock();
+	return ExitStatus();
+}
@@ -0,0 +1,181 @@
+#include "check.h"
+#include "mappedfile.h"
+#include "streamingpacker.h"
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+using namespace BinPacker;
+
+static const std::uint32_t unpackedPage = 0xFFFFFFFF;
+
+static bool Overlap(Rect a, Rect b) {
+	return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+}
+
+static std::string TempPath(const char* name) {
+	return (std::filesystem::temp_directory_path() / name).string();
+}
+
+static std::vector<unsigned char> ReadFile(const std::string& path) {
+	std::ifstream file(path, std::ios::binary);
+	return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void WriteFile(const std::string& path, const std::vector<unsigned char>& data) {
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write((const char*)data.data(), (std::streamsize)data.size());
+}
+
+static std::uint64_t ReadLittleEndian(const unsigned char* data, unsigned int bytes) {
+	std::uint64_t value = 0;
+	for (unsigned int i = bytes; i-- > 0;)
+		value = (value << 8) | data[i];
+	return value;
+}
+
+static void WriteItems(const std::string& path, const std::vector<Area>& items) {
+	std::vector<unsigned char> data;
+	for (const Area & item : items) {
+		for (std::uint32_t value : {item.width, item.height}) {
+			for (unsigned int i = 0; i < 4; i++)
+				data.push_back((unsigned char)(value >> (i * 8)));
+		}
+	}
+	WriteFile(path, data);
+}
+
+// Packs enough items to cross several windows of both files and close pages, with a few items larger than a page,
+// then checks the header and every record of the placement file
+static void TestPackFile() {
+	std::vector<Area> items;
+	unsigned int state = 1;
+	for (unsigned int i = 0; i < 20000; i++) {
+		state = state * 1103515245u + 12345u;
+		const unsigned int width = 1 + (state >> 16) % 32;
+		state = state * 1103515245u + 12345u;
+		const unsigned int height = 1 + (state >> 16) % 32;
+		items.push_back(i % 997 == 5 ? Area{300, 10 + i % 7} : Area{width, height});
+	}
+	const std::string itemPath = TempPath("streamingpackertest.items"), placementPath = TempPath("streamingpackertest.placements");
+	WriteItems(itemPath, items);
+
+	StreamingSettings settings;
+	settings.pageDimensions = {256, 200};
+	settings.maxOpenPages = 3;
+	settings.memoryBudget = 1 << 20;
+	StreamingStats stats;
+	CHECK(PackFile(itemPath, placementPath, settings, &stats));
+
+	const std::vector<unsigned char> placements = ReadFile(placementPath);
+	CHECK(placements.size() == 24 + items.size() * 20);
+	if (placements.size() != 24 + items.size() * 20)
+		return;
+	CHECK(std::equal(placements.begin(), placements.begin() + 4, "BPS1"));
+	CHECK(ReadLittleEndian(&placements[4], 4) == 256 && ReadLittleEndian(&placements[8], 4) == 200);
+	const std::uint32_t pageCount = (std::uint32_t)ReadLittleEndian(&placements[12], 4);
+	CHECK(pageCount == stats.pageCount && pageCount > settings.maxOpenPages);
+	CHECK(ReadLittleEndian(&placements[16], 8) == items.size() && stats.itemCount == items.size());
+	CHECK(stats.peakOpenPages <= settings.maxOpenPages);
+
+	std::vector<std::vector<Rect>> pages(pageCount);
+	unsigned long long packedCount = 0;
+	for (std::size_t i = 0; i < items.size(); i++) {
+		const unsigned char* record = &placements[24 + i * 20];
+		const std::uint32_t page = (std::uint32_t)ReadLittleEndian(record, 4);
+		const Rect r = { (unsigned int)ReadLittleEndian(record + 4, 4), (unsigned int)ReadLittleEndian(record + 8, 4),
+			(unsigned int)ReadLittleEndian(record + 12, 4), (unsigned int)ReadLittleEndian(record + 16, 4) };
+		if (items[i].width > 256) {
+			CHECK(page == unpackedPage && r.left == 0 && r.top == 0 && r.right == 0 && r.bottom == 0);
+			continue;
+		}
+		CHECK(page < pageCount);
+		if (page >= pageCount)
+			continue;
+		const Area size = { r.right - r.left + 1, r.bottom - r.top + 1 };
+		CHECK(r.IsValid() && r.right < 256 && r.bottom < 200);
+		CHECK((size.width == items[i].width && size.height == items[i].height) || (size.width == items[i].height && size.height == items[i].width));
+		pages[page].push_back(r);
+		packedCount++;
+	}
+	CHECK(packedCount == stats.packedCount && packedCount < items.size());
+	for (const std::vector<Rect> & page : pages) {
+		CHECK(!page.empty());
+		for (std::size_t i = 0; i < page.size(); i++) {
+			for (std::size_t j = i + 1; j < page.size(); j++)
+				CHECK(!Overlap(page[i], page[j]));
+		}
+	}
+
+	std::filesystem::remove(itemPath);
+	std::filesystem::remove(placementPath);
+}
+
+// An empty item file gives a header with no pages and no items, and files that aren't whole items or don't exist are rejected
+static void TestEmptyAndInvalidFiles() {
+	const std::string itemPath = TempPath("streamingpackertest.items"), placementPath = TempPath("streamingpackertest.placements");
+	WriteFile(itemPath, {});
+	StreamingStats stats;
+	stats.itemCount = 1;
+	CHECK(PackFile(itemPath, placementPath, StreamingSettings(), &stats));
+	CHECK(stats.itemCount == 0 && stats.pageCount == 0 && stats.packedCount == 0);
+	const std::vector<unsigned char> placements = ReadFile(placementPath);
+	CHECK(placements.size() == 24);
+	if (placements.size() == 24) {
+		CHECK(std::equal(placements.begin(), placements.begin() + 4, "BPS1"));
+		CHECK(ReadLittleEndian(&placements[12], 4) == 0 && ReadLittleEndian(&placements[16], 8) == 0);
+	}
+
+	WriteFile(itemPath, std::vector<unsigned char>(12, 1));
+	CHECK(!PackFile(itemPath, placementPath));
+	std::filesystem::remove(itemPath);
+	CHECK(!PackFile(itemPath, placementPath));
+	std::filesystem::remove(placementPath);
+}
+
+// Windows at any offset read and write the bytes of the file, and windows outside the file aren't mapped
+static void TestMappedFile() {
+	const std::string path = TempPath("mappedfiletest.bin");
+	const unsigned long long size = 300000;
+	{
+		MappedFile file;
+		CHECK(file.Create(path, size));
+		CHECK(file.GetSize() == size);
+		for (unsigned long long offset = 0; offset < size; offset += 70001) {
+			const std::size_t length = (std::size_t)std::min<unsigned long long>(70001, size - offset);
+			unsigned char* window = file.Map(offset, length);
+			CHECK(window != nullptr);
+			if (window == nullptr)
+				continue;
+			for (std::size_t i = 0; i < length; i++)
+				window[i] = (unsigned char)((offset + i) * 7);
+			CHECK(file.Flush());
+		}
+		CHECK(file.Map(size - 10, 11) == nullptr);
+		CHECK(file.Map(size, 1) == nullptr);
+	}
+
+	const std::vector<unsigned char> data = ReadFile(path);
+	CHECK(data.size() == size);
+	bool written = data.size() == size;
+	for (std::size_t i = 0; i < data.size() && written; i++)
+		written = data[i] == (unsigned char)(i * 7);
+	CHECK(written);
+
+	MappedFile file;
+	CHECK(file.Open(path) && file.GetSize() == size);
+	const unsigned char* window = file.Map(123457, 1000);
+	CHECK(window != nullptr && window[0] == (unsigned char)(123457 * 7) && window[999] == (unsigned char)(124456 * 7));
+	file.Close();
+	CHECK(!file.Open(TempPath("mappedfiletest.missing")));
+	std::filesystem::remove(path);
+}
+
+int main() {
+	TestPackFile();
+	TestEmptyAndInvalidFiles();
+	TestMappedFile();
+	return ExitStatus();
+}
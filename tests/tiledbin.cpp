@@ -0,0 +1,96 @@
+#include "check.h"
+#include "tiledbin.h"
+#include <cmath>
+
+using namespace BinPacker;
+
+static bool Overlap(Rect a, Rect b) {
+	return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+}
+
+static std::vector<Area> MakeItems(unsigned int count, unsigned int maxSide, unsigned int seed) {
+	std::vector<Area> items;
+	unsigned int state = seed;
+	for (unsigned int i = 0; i < count; i++) {
+		state = state * 1103515245u + 12345u;
+		const unsigned int width = 1 + (state >> 16) % maxSide;
+		state = state * 1103515245u + 12345u;
+		items.push_back({width, 1 + (state >> 16) % maxSide});
+	}
+	return items;
+}
+
+// Packs items into the bin, releasing every seventh, and returns the fraction of the bin covered by the items left packed
+template<typename Packer>
+static double Fill(Packer& bin, Area dimensions, const std::vector<Area>& items, std::vector<Rect>& packed) {
+	unsigned long long usedArea = 0;
+	for (std::size_t i = 0; i < items.size(); i++) {
+		const Rect r = bin.TryPackArea(items[i]);
+		if (!r.IsValid())
+			continue;
+		if (i % 7 == 0) {
+			bin.Release(r);
+			continue;
+		}
+		packed.push_back(r);
+		usedArea += (unsigned long long)items[i].width * items[i].height;
+	}
+	return (double)usedArea / ((double)dimensions.width * dimensions.height);
+}
+
+// Ties between placements are resolved in tile order rather than the bin's region order, so layouts differ,
+// but a tiled bin fills as much of the bin as a Bin, and its items never overlap each other or its empty regions
+static void TestMatchesBinUtilisation(Area dimensions, unsigned int maxSide, unsigned int tileSize) {
+	const std::vector<Area> items = MakeItems(dimensions.width * dimensions.height / (maxSide * maxSide / 4 + 1) * 2, maxSide, maxSide);
+
+	Bin bin;
+	bin.ExtendDimensions(dimensions);
+	std::vector<Rect> binPacked;
+	const double binFill = Fill(bin, dimensions, items, binPacked);
+
+	TiledBin tiled(dimensions, tileSize);
+	std::vector<Rect> tiledPacked;
+	const double tiledFill = Fill(tiled, dimensions, items, tiledPacked);
+
+	CHECK(std::fabs(binFill - tiledFill) < 0.01);
+	const std::vector<Rect> emptyRegions = tiled.GetEmptyRegions();
+	for (std::size_t i = 0; i < tiledPacked.size(); i++) {
+		CHECK(tiledPacked[i].right < dimensions.width && tiledPacked[i].bottom < dimensions.height);
+		for (std::size_t j = i + 1; j < tiledPacked.size(); j++)
+			CHECK(!Overlap(tiledPacked[i], tiledPacked[j]));
+		for (const Rect & r : emptyRegions)
+			CHECK(!Overlap(tiledPacked[i], r));
+	}
+}
+
+// Releasing every item, in any order, leaves a single region covering the bin, as it does for a Bin
+static void TestReleaseAll(Area dimensions, unsigned int maxSide, unsigned int tileSize) {
+	const std::vector<Area> items = MakeItems(2000, maxSide, 11);
+	TiledBin tiled(dimensions, tileSize);
+	std::vector<Rect> packed;
+	for (const Area & item : items) {
+		const Rect r = tiled.TryPackArea(item);
+		if (r.IsValid())
+			packed.push_back(r);
+	}
+	unsigned int state = 5;
+	for (std::size_t i = packed.size(); i > 1; i--) {
+		state = state * 1103515245u + 12345u;
+		std::swap(packed[i - 1], packed[(state >> 16) % i]);
+	}
+	for (const Rect & r : packed)
+		tiled.Release(r);
+	const std::vector<Rect> emptyRegions = tiled.GetEmptyRegions();
+	CHECK(emptyRegions.size() == 1 && emptyRegions[0].left == 0 && emptyRegions[0].top == 0
+		&& emptyRegions[0].right == dimensions.width - 1 && emptyRegions[0].bottom == dimensions.height - 1);
+	CHECK(tiled.TryPackArea(dimensions).IsValid());
+}
+
+int main() {
+	TestMatchesBinUtilisation({256, 256}, 16, 32);
+	TestMatchesBinUtilisation({512, 512}, 64, 64);
+	TestMatchesBinUtilisation({300, 200}, 8, 16);
+	TestReleaseAll({256, 256}, 16, 32);
+	TestReleaseAll({300, 200}, 40, 64);
+	return ExitStatus();
+}
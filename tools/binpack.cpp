@@ -0,0 +1,424 @@
+// Command-line atlas packer.
+// Reads item sizes from a file or stdin and writes each item's placement as soon as it is packed.
+// Items are packed into a growing bin, and into further pages once a page can't grow to fit an item.
+// Items that wouldn't fit even an empty page grown as far as it can, or that have no area, are left
+// unpacked without growing the page or starting a new one.
+//
+// Text input holds a width and height per item, e.g. "40 30", "40,30" or "40x30", with lines
+// starting with '#' ignored. Binary input is a sequence of little-endian 32-bit width and height
+// pairs, as read by PackFile, and is memory-mapped when read from a file.
+//
+// Text output has a line of "index page left top width height rotated" per item, with a page of -1
+// for items that weren't packed, followed by a line of "# page index width height" per page. Binary
+// output has a 20-byte record of the page, left, top, right and bottom of each placement as
+// little-endian 32-bit values, with a page of 0xFFFFFFFF for items that weren't packed. Unlike the
+// placement file of PackFile it has no header, since the page sizes aren't known until every item is
+// packed: the records are followed by a footer of the width and height of each page, the page count
+// and item count as 32 and 64-bit values and the magic "BPP1". It is memory-mapped when written to a
+// file from a memory-mapped input. The exit code is 3 if any item wasn't packed.
+//
+// Build with e.g.: g++ -std=c++17 -O2 -Isrc tools/binpack.cpp src/binpacker.cpp src/mappedfile.cpp -o binpack -pthread
+
+#include "binpacker.h"
+#include "mappedfile.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+using namespace BinPacker;
+
+static const unsigned char footerMagic[4] = {'B', 'P', 'P', '1'};
+static const std::size_t itemSize = 8;
+static const std::size_t recordSize = 20;
+static const std::size_t windowSize = 16 << 20;
+
+enum class GrowPolicy {
+	None,		// Never grow
+	Double,		// Double both dimensions
+	Alternate	// Double the smaller dimension, or the width if they are equal
+};
+
+struct Options {
+	std::string input, output;
+	bool binaryInput = false, binaryOutput = false;
+	Area initialDimensions = {128, 128};
+	Area maxDimensions = {16384, 16384};
+	GrowPolicy grow = GrowPolicy::Double;
+	unsigned int maxPages = 1;
+	PackConstraints constraints;
+	bool quiet = false;
+};
+
+static void WriteUint(unsigned char* data, unsigned long long value, unsigned int bytes = 4) {
+	for (unsigned int i = 0; i < bytes; i++)
+		data[i] = (unsigned char)(value >> (i * 8));
+}
+
+static unsigned int ReadUint(const unsigned char* data) {
+	return data[0] | (data[1] << 8) | (data[2] << 16) | ((unsigned int)data[3] << 24);
+}
+
+// Reads items from a memory-mapped binary file, a binary stream or a text stream
+class ItemReader {
+	public:
+		bool Open(const Options& options) {
+			binary = options.binaryInput;
+			if (binary && !options.input.empty()) {
+				if (!mapped.Open(options.input) || mapped.GetSize() % itemSize != 0)
+					return false;
+				mappedItems = mapped.GetSize() / itemSize;
+				return true;
+			}
+			stream = options.input.empty() ? stdin : std::fopen(options.input.c_str(), binary ? "rb" : "r");
+#ifdef _WIN32
+			if (binary && stream == stdin)
+				_setmode(_fileno(stdin), _O_BINARY);
+#endif
+			return stream != nullptr;
+		}
+
+		~ItemReader() {
+			if (stream != nullptr && stream != stdin)
+				std::fclose(stream);
+		}
+
+		// Returns the number of items if known in advance, which it is for memory-mapped input
+		bool GetCount(unsigned long long& count) const {
+			count = mappedItems;
+			return stream == nullptr;
+		}
+
+		// Reads the next item, returning false at the end of the input or on an error
+		bool Next(Area& area) {
+			if (stream == nullptr) {
+				if (index == mappedItems)
+					return false;
+				if (index % (windowSize / itemSize) == 0) {
+					window = mapped.Map(index * itemSize, (std::size_t)std::min<unsigned long long>(windowSize / itemSize, mappedItems - index) * itemSize);
+					if (window == nullptr)
+						return failed = true, false;
+				}
+				const unsigned char* item = window + (index++ % (windowSize / itemSize)) * itemSize;
+				area = { ReadUint(item), ReadUint(item + 4) };
+				return true;
+			}
+			if (binary) {
+				unsigned char item[itemSize];
+				const std::size_t read = std::fread(item, 1, itemSize, stream);
+				if (read != itemSize)
+					return failed = read != 0 || std::ferror(stream), false;
+				area = { ReadUint(item), ReadUint(item + 4) };
+				return true;
+			}
+			return ReadNumber(area.width) && (ReadNumber(area.height) || (failed = true, false));
+		}
+
+		bool Failed() const {
+			return failed;
+		}
+	private:
+		// Reads the next number of text input, skipping separators and comments
+		bool ReadNumber(unsigned int& value) {
+			int c = std::getc(stream);
+			while (c != EOF && (c < '0' || c > '9')) {
+				if (c == '#') {
+					while (c != EOF && c != '\n')
+						c = std::getc(stream);
+				} else if (c != ' ' && c != '\t' && c != '\r' && c != '\n' && c != ',' && c != 'x') {
+					failed = true;
+					return false;
+				}
+				c = std::getc(stream);
+			}
+			if (c == EOF)
+				return false;
+			unsigned long long number = 0;
+			for (; c >= '0' && c <= '9'; c = std::getc(stream))
+				number = std::min(number * 10 + (c - '0'), 0xFFFFFFFFull);
+			std::ungetc(c, stream);
+			value = (unsigned int)number;
+			return true;
+		}
+
+		bool binary = false;
+		bool failed = false;
+		std::FILE* stream = nullptr;
+		MappedFile mapped;
+		const unsigned char* window = nullptr;
+		unsigned long long mappedItems = 0;
+		unsigned long long index = 0;
+};
+
+// Writes placements to a memory-mapped binary file, a binary stream or a text stream
+class PlacementWriter {
+	public:
+		bool Open(const Options& options, bool countKnown, unsigned long long count) {
+			binary = options.binaryOutput;
+			path = options.output;
+			if (binary && countKnown && !path.empty()) {
+				mappedRecords = count;
+				return mapped.Create(path, count * recordSize);
+			}
+			stream = path.empty() ? stdout : std::fopen(path.c_str(), binary ? "wb" : "w");
+#ifdef _WIN32
+			if (binary && stream == stdout)
+				_setmode(_fileno(stdout), _O_BINARY);
+#endif
+			return stream != nullptr;
+		}
+
+		~PlacementWriter() {
+			if (stream != nullptr && stream != stdout)
+				std::fclose(stream);
+		}
+
+		void Write(unsigned long long index, unsigned int page, Rect rect, bool rotated) {
+			const bool packed = rect.IsValid();
+			if (!binary) {
+				char line[96];
+				const int length = packed
+					? std::snprintf(line, sizeof(line), "%llu %u %u %u %u %u %d\n", index, page, rect.left, rect.top, rect.right - rect.left + 1, rect.bottom - rect.top + 1, rotated ? 1 : 0)
+					: std::snprintf(line, sizeof(line), "%llu -1 0 0 0 0 0\n", index);
+				failed = failed || std::fwrite(line, 1, (std::size_t)length, stream) != (std::size_t)length;
+				return;
+			}
+
+			unsigned char buffer[recordSize];
+			unsigned char* record = buffer;
+			if (stream == nullptr) {
+				if (index % (windowSize / recordSize) == 0) {
+					window = mapped.Map(index * recordSize, (std::size_t)std::min<unsigned long long>(windowSize / recordSize, mappedRecords - index) * recordSize);
+					failed = failed || window == nullptr;
+				}
+				if (window == nullptr)
+					return;
+				record = window + (index % (windowSize / recordSize)) * recordSize;
+			}
+			WriteUint(record, packed ? page : 0xFFFFFFFF);
+			WriteUint(record + 4, packed ? rect.left : 0);
+			WriteUint(record + 8, packed ? rect.top : 0);
+			WriteUint(record + 12, packed ? rect.right : 0);
+			WriteUint(record + 16, packed ? rect.bottom : 0);
+			if (stream != nullptr)
+				failed = failed || std::fwrite(record, 1, recordSize, stream) != recordSize;
+		}
+
+		// Writes the dimensions of every page after the placements
+		bool Finish(const std::vector<Area>& pages, unsigned long long itemCount) {
+			if (stream == nullptr) {
+				// The mapped file only has room for the placements, so the rest is appended
+				failed = failed || !mapped.Flush();
+				mapped.Close();
+				stream = std::fopen(path.c_str(), "ab");
+				if (stream == nullptr)
+					return false;
+			}
+
+			if (binary) {
+				std::vector<unsigned char> footer(pages.size() * 8 + 16);
+				for (std::size_t i = 0; i < pages.size(); i++) {
+					WriteUint(&footer[i * 8], pages[i].width);
+					WriteUint(&footer[i * 8 + 4], pages[i].height);
+				}
+				unsigned char* end = &footer[pages.size() * 8];
+				WriteUint(end, pages.size());
+				WriteUint(end + 4, itemCount, 8);
+				std::copy(footerMagic, footerMagic + 4, end + 12);
+				failed = failed || std::fwrite(footer.data(), 1, footer.size(), stream) != footer.size();
+			} else {
+				for (std::size_t i = 0; i < pages.size(); i++)
+					failed = failed || std::fprintf(stream, "# page %u %u %u\n", (unsigned int)i, pages[i].width, pages[i].height) < 0;
+			}
+			return std::fflush(stream) == 0 && !failed;
+		}
+	private:
+		bool binary = false;
+		bool failed = false;
+		std::string path;
+		std::FILE* stream = nullptr;
+		MappedFile mapped;
+		unsigned char* window = nullptr;
+		unsigned long long mappedRecords = 0;
+};
+
+// Returns the extension of a page of dimensions by the policy, or nothing if it can't grow any further
+static Area GetGrowth(Area dimensions, const Options& options) {
+	Area extension = {0, 0};
+	switch (options.grow) {
+		case GrowPolicy::None:
+			break;
+		case GrowPolicy::Double:
+			extension = dimensions;
+			break;
+		case GrowPolicy::Alternate:
+			if (dimensions.width <= dimensions.height)
+				extension.width = dimensions.width;
+			else
+				extension.height = dimensions.height;
+			break;
+	}
+	extension.width = std::min(extension.width, options.maxDimensions.width - std::min(options.maxDimensions.width, dimensions.width));
+	extension.height = std::min(extension.height, options.maxDimensions.height - std::min(options.maxDimensions.height, dimensions.height));
+	return extension;
+}
+
+static bool ParseArea(const char* text, Area& area) {
+	char* end;
+	area.width = (unsigned int)std::strtoul(text, &end, 10);
+	if (*end != 'x')
+		return false;
+	area.height = (unsigned int)std::strtoul(end + 1, &end, 10);
+	return *end == '\0' && area.width > 0 && area.height > 0;
+}
+
+static bool ParseUint(const char* text, unsigned int& value) {
+	char* end;
+	value = (unsigned int)std::strtoul(text, &end, 10);
+	return *text != '\0' && *end == '\0';
+}
+
+static void PrintUsage() {
+	std::fputs(
+		"Usage: binpack [options] [input]\n"
+		"Packs the item sizes in input, or stdin, and writes their placements to stdout.\n"
+		"  -o FILE            Write placements to FILE\n"
+		"  --binary-in        Read little-endian 32-bit width and height pairs instead of text\n"
+		"  --binary-out       Write binary placement records instead of text\n"
+		"  --size WxH         Initial dimensions of each page (default 128x128)\n"
+		"  --max-size WxH     Dimensions each page may grow to (default 16384x16384)\n"
+		"  --grow POLICY      none, double or alternate (default double)\n"
+		"  --pages N          Maximum number of pages, or 0 for no limit (default 1)\n"
+		"  --padding N        Pixels of padding reserved around each item\n"
+		"  --align N          Align the position and size of each item to N pixels\n"
+		"  --no-rotate        Never rotate items\n"
+		"  --quiet            Don't report timing on stderr\n", stderr);
+}
+
+static bool ParseOptions(int argc, char** argv, Options& options) {
+	for (int i = 1; i < argc; i++) {
+		const std::string arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+		unsigned int number;
+		if (arg == "--binary-in")
+			options.binaryInput = true;
+		else if (arg == "--binary-out")
+			options.binaryOutput = true;
+		else if (arg == "--no-rotate")
+			options.constraints.allowRotation = false;
+		else if (arg == "--quiet")
+			options.quiet = true;
+		else if (arg == "-o" && value != nullptr)
+			options.output = argv[++i];
+		else if (arg == "--size" && value != nullptr && ParseArea(value, options.initialDimensions))
+			i++;
+		else if (arg == "--max-size" && value != nullptr && ParseArea(value, options.maxDimensions))
+			i++;
+		else if (arg == "--pages" && value != nullptr && ParseUint(value, options.maxPages))
+			i++;
+		else if (arg == "--padding" && value != nullptr && ParseUint(value, number)) {
+			options.constraints.padding = {number, number, number, number};
+			i++;
+		} else if (arg == "--align" && value != nullptr && ParseUint(value, number) && number > 0) {
+			options.constraints.positionAlignment = options.constraints.sizeAlignment = {number, number};
+			i++;
+		} else if (arg == "--grow" && value != nullptr && (std::strcmp(value, "none") == 0 || std::strcmp(value, "double") == 0 || std::strcmp(value, "alternate") == 0)) {
+			options.grow = value[0] == 'n' ? GrowPolicy::None : value[0] == 'd' ? GrowPolicy::Double : GrowPolicy::Alternate;
+			i++;
+		} else if (arg[0] != '-' && options.input.empty())
+			options.input = arg;
+		else
+			return false;
+	}
+	return true;
+}
+
+int main(int argc, char** argv) {
+	using namespace std;
+
+	Options options;
+	if (!ParseOptions(argc, argv, options)) {
+		PrintUsage();
+		return 2;
+	}
+	options.initialDimensions.width = min(options.initialDimensions.width, options.maxDimensions.width);
+	options.initialDimensions.height = min(options.initialDimensions.height, options.maxDimensions.height);
+
+	ItemReader reader;
+	if (!reader.Open(options)) {
+		fprintf(stderr, "binpack: can't read %s\n", options.input.empty() ? "stdin" : options.input.c_str());
+		return 1;
+	}
+	unsigned long long count;
+	const bool countKnown = reader.GetCount(count);
+	PlacementWriter writer;
+	if (!writer.Open(options, countKnown, count)) {
+		fprintf(stderr, "binpack: can't write %s\n", options.output.empty() ? "stdout" : options.output.c_str());
+		return 1;
+	}
+
+	// The largest page is an empty page grown by the policy until it can't grow any further
+	Area largestPage = options.initialDimensions;
+	for (Area growth = GetGrowth(largestPage, options); growth.width > 0 || growth.height > 0; growth = GetGrowth(largestPage, options)) {
+		largestPage.width += growth.width;
+		largestPage.height += growth.height;
+	}
+	Bin largestEmptyPage;
+	largestEmptyPage.ExtendDimensions(largestPage);
+
+	const auto start = chrono::steady_clock::now();
+	Bin bin;
+	bin.ExtendDimensions(options.initialDimensions);
+	vector<Area> pages(1, options.initialDimensions);
+	unsigned long long index = 0, packedCount = 0;
+	bool pageEmpty = true;
+	Area area;
+	for (; reader.Next(area); index++) {
+		Rect packed = bin.TryPackArea(area, options.constraints);
+		// Items that don't fit the largest page, in either orientation with padding and alignment, are left unpacked
+		// without growing the page or starting a new one
+		const bool fitsPage = packed.IsValid() || Bin(largestEmptyPage).TryPackArea(area, options.constraints).IsValid();
+		while (!packed.IsValid() && fitsPage) {
+			// Grow the page, then move on to a new page once it can't grow any further
+			const Area growth = GetGrowth(bin.GetDimensions(), options);
+			if (growth.width > 0 || growth.height > 0) {
+				bin.ExtendDimensions(growth);
+				pages.back() = bin.GetDimensions();
+			} else if (!pageEmpty && (options.maxPages == 0 || pages.size() < options.maxPages)) {
+				bin = Bin();
+				bin.ExtendDimensions(options.initialDimensions);
+				pages.push_back(options.initialDimensions);
+				pageEmpty = true;
+			} else {
+				break;	// Out of pages
+			}
+			packed = bin.TryPackArea(area, options.constraints);
+		}
+
+		const bool rotated = packed.IsValid() && area.width != area.height && packed.right - packed.left + 1 != area.width;
+		writer.Write(index, (unsigned int)pages.size() - 1, packed, rotated);
+		packedCount += packed.IsValid();
+		pageEmpty = pageEmpty && !packed.IsValid();
+	}
+	if (reader.Failed()) {
+		fprintf(stderr, "binpack: malformed or unreadable input after %llu items\n", index);
+		return 1;
+	}
+	if (!writer.Finish(pages, index)) {
+		fprintf(stderr, "binpack: can't write %s\n", options.output.empty() ? "stdout" : options.output.c_str());
+		return 1;
+	}
+
+	if (!options.quiet) {
+		const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		fprintf(stderr, "binpack: packed %llu of %llu items into %u pages in %.3f s (%.0f items/s)\n",
+			packedCount, index, (unsigned int)pages.size(), seconds, seconds > 0 ? index / seconds : 0.0);
+	}
+	return packedCount == index ? 0 : 3;
+}